@@ -43,6 +43,7 @@ TreeCCContext *TreeCCContextCreate(TreeCCInput *input)
 	context->track_lines = 1;
 	context->no_singletons = 0;
 	context->reentrant = 0;
+	context->thread_local_state = 0;
 	context->force = 0;
 	context->virtual_factory = 0;
 	context->abstract_factory = 0;
@@ -52,13 +53,30 @@ TreeCCContext *TreeCCContextCreate(TreeCCInput *input)
 	context->internal_access = 0;
 	context->use_allocator = 1;
 	context->use_gc_allocator = 0;
+	context->use_shared_allocator = 0;
+	context->node_stats = 0;
+	context->free_lists = 0;
+	context->clone_nodes = 0;
+	context->memory_resource = 0;
+	context->propagate_resource = 0;
+	context->finalizers = 0;
+	context->move_fields = 0;
+	context->kind_ranges = 0;
+	context->dispatch_tables = 0;
+	context->profile_dispatch = 0;
+	context->batch_operations = 0;
+	context->flat_nodes = 0;
 	context->yy_replacement = "yy";
 	context->state_type = "YYNODESTATE";
 	context->namespace = 0;
 	context->language = TREECC_LANG_C;
 	context->block_size = 0;
+	context->block_cache = 0;
+	context->max_block_size = 0;
+	context->mmap_threshold = 0;
 	context->nodeNumber = 1;
 	context->baseType = 0;
+	context->profileFile = "treecc.prof";
 	return context;
 }
 
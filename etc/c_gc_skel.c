@@ -82,6 +82,66 @@ void yynodepop()
 #endif
 }
 
+/*
+ * Mark the node allocation state.  Not used in the GC version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+YYNODESTATE_mark yynodemark(state__)
+YYNODESTATE *state__;
+{
+#else
+YYNODESTATE_mark yynodemark()
+{
+#endif
+	YYNODESTATE_mark mark__;
+	mark__.dummy__ = 0;
+	return mark__;
+}
+
+/*
+ * Roll back to a mark.  Not used in the GC version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynoderollback(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynoderollback(mark__)
+YYNODESTATE_mark mark__;
+{
+#endif
+}
+
+/*
+ * Commit to a mark.  Not used in the GC version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodecommit(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynodecommit(mark__)
+YYNODESTATE_mark mark__;
+{
+#endif
+}
+
+#ifdef YYNODESTATE_REENTRANT
+
+/*
+ * Move all nodes from one node allocation pool to another.
+ * Not used in the GC version.
+ */
+void yynodeadopt(state__, src__)
+YYNODESTATE *state__;
+YYNODESTATE *src__;
+{
+}
+
+#endif /* YYNODESTATE_REENTRANT */
+
 /*
  * Clear the node allocation pool completely.  Not used in the GC version.
  */
@@ -94,3 +154,16 @@ void yynodeclear()
 {
 #endif
 }
+
+/*
+ * Trim the retired block cache.  Not used in the GC version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodetrim(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodetrim()
+{
+#endif
+}
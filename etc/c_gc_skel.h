@@ -3,3 +3,8 @@ typedef struct
 	int dummy__;
 
 } YYNODESTATE;
+typedef struct
+{
+	int dummy__;
+
+} YYNODESTATE_mark;
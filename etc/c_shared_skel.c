@@ -0,0 +1,539 @@
+/*
+ * treecc shared node allocation routines for C.
+ *
+ * Copyright (C) 2026  Southern Storm Software, Pty Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * As a special exception, when this file is copied by treecc into
+ * a treecc output file, you may use that output file without restriction.
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+
+/*
+ * Size of the private chunk that each thread allocates nodes from.
+ */
+#ifndef YYNODESTATE_BLKSIZ
+#define	YYNODESTATE_BLKSIZ	2048
+#endif
+
+/*
+ * Number of private chunks that are carved out of each shared block.
+ */
+#ifndef YYNODESTATE_SHARED_CHUNKS
+#define	YYNODESTATE_SHARED_CHUNKS	16
+#endif
+
+/*
+ * Number of states that each thread can hold a private chunk for.
+ */
+#ifndef YYNODESTATE_SHARED_STATES
+#define	YYNODESTATE_SHARED_STATES	4
+#endif
+
+/*
+ * Types used by the allocation routines.  The node data for a
+ * block follows the header, at an offset of YYNODESTATE_BLKHDR.
+ * Threads reserve chunks within a block by advancing "used__".
+ */
+struct YYNODESTATE_block
+{
+	struct YYNODESTATE_block *next__;
+	size_t size__;
+	atomic_size_t used__;
+
+};
+
+/*
+ * The calling thread's private chunks, one for each of the states that
+ * it allocated from most recently.  Nodes are carved from them without
+ * touching memory that is written by other threads.  A chunk is only
+ * valid for its state while the state has the same generation number.
+ */
+struct YYNODESTATE_chunk
+{
+	const void *state__;
+	unsigned long generation__;
+	char *next__;
+	char *limit__;
+};
+static YYNODESTATE_THREAD_LOCAL struct YYNODESTATE_chunk
+	chunks__[YYNODESTATE_SHARED_STATES];
+static YYNODESTATE_THREAD_LOCAL unsigned int next_chunk__;
+
+/*
+ * Source of generation numbers.  Every state is given a new number
+ * when it is initialized or cleared, which invalidates the chunks
+ * that threads were holding for it.
+ */
+static atomic_ulong last_generation__;
+
+/*
+ * The fixed global state to use for non-reentrant allocation.
+ * It is shared between all threads.
+ */
+#ifndef YYNODESTATE_REENTRANT
+static YYNODESTATE fixed_state__;
+#endif
+
+/*
+ * Some macro magic to determine the default alignment
+ * on this machine.  This will compile down to a constant.
+ */
+#define	YYNODESTATE_ALIGN_CHECK_TYPE(type,name)	\
+	struct _YYNODESTATE_align_##name { \
+		char pad; \
+		type field; \
+	}
+#define	YYNODESTATE_ALIGN_FOR_TYPE(type)	\
+	((unsigned)(unsigned long)(&(((struct _YYNODESTATE_align_##type *)0)->field)))
+#define	YYNODESTATE_ALIGN_MAX(a,b)	\
+	((a) > (b) ? (a) : (b))
+#define	YYNODESTATE_ALIGN_MAX3(a,b,c) \
+	(YYNODESTATE_ALIGN_MAX((a), YYNODESTATE_ALIGN_MAX((b), (c))))
+YYNODESTATE_ALIGN_CHECK_TYPE(int, int);
+YYNODESTATE_ALIGN_CHECK_TYPE(long, long);
+#if defined(WIN32) && !defined(__CYGWIN__)
+YYNODESTATE_ALIGN_CHECK_TYPE(__int64, long_long);
+#else
+YYNODESTATE_ALIGN_CHECK_TYPE(long long, long_long);
+#endif
+YYNODESTATE_ALIGN_CHECK_TYPE(void *, void_p);
+YYNODESTATE_ALIGN_CHECK_TYPE(float, float);
+YYNODESTATE_ALIGN_CHECK_TYPE(double, double);
+#define	YYNODESTATE_ALIGNMENT	\
+	YYNODESTATE_ALIGN_MAX( \
+			YYNODESTATE_ALIGN_MAX3	\
+			(YYNODESTATE_ALIGN_FOR_TYPE(int), \
+		     YYNODESTATE_ALIGN_FOR_TYPE(long), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(long_long)), \
+  	     YYNODESTATE_ALIGN_MAX3 \
+		 	(YYNODESTATE_ALIGN_FOR_TYPE(void_p), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(float), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(double)))
+
+/*
+ * Size of a block header, rounded up so that the node data
+ * that follows it is correctly aligned.
+ */
+#define	YYNODESTATE_BLKHDR	\
+	((sizeof(struct YYNODESTATE_block) + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+#define	YYNODESTATE_BLKDATA(block)	\
+	(((char *)(block)) + YYNODESTATE_BLKHDR)
+
+/*
+ * Size of a private chunk, rounded up to the alignment boundary.
+ */
+#define	YYNODESTATE_CHUNK	\
+	((YYNODESTATE_BLKSIZ + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+
+/*
+ * Get a new generation number.
+ */
+static unsigned long yynodegeneration__()
+{
+	return atomic_fetch_add_explicit(&last_generation__, 1,
+									 memory_order_relaxed) + 1;
+}
+
+/*
+ * Initialize the node allocation pool.  This must be done before
+ * any thread allocates nodes from the pool.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodeinit(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodeinit()
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	atomic_init(&(state__->generation__), yynodegeneration__());
+	atomic_init(&(state__->blocks__), (struct YYNODESTATE_block *)0);
+	atomic_init(&(state__->large__), (struct YYNODESTATE_block *)0);
+	atomic_init(&(state__->blocks_last__), (struct YYNODESTATE_block *)0);
+	atomic_init(&(state__->large_last__), (struct YYNODESTATE_block *)0);
+}
+
+/*
+ * Obtain a new block with room for "size__" bytes of node data.
+ */
+static struct YYNODESTATE_block *yynodenewblock__(state__, size__)
+YYNODESTATE *state__;
+size_t size__;
+{
+	struct YYNODESTATE_block *block__;
+	block__ = (struct YYNODESTATE_block *)malloc(YYNODESTATE_BLKHDR + size__);
+	if(!block__)
+	{
+		/* The system is out of memory.  The programmer can
+		   supply the "yynodefailed" function to report the
+		   out of memory state and/or abort the program */
+#ifdef YYNODESTATE_REENTRANT
+		yynodefailed(state__);
+#else
+		yynodefailed();
+#endif
+		return 0;
+	}
+	block__->size__ = size__;
+	return block__;
+}
+
+/*
+ * Push a chain of blocks, ending at "tail__", onto the front of a
+ * shared block list.  Blocks are only ever added to the front, so the
+ * last block in a list is recorded in "last__" when the list is filled.
+ */
+static void yynodesplice__(list__, last__, chain__, tail__)
+_Atomic(struct YYNODESTATE_block *) *list__;
+_Atomic(struct YYNODESTATE_block *) *last__;
+struct YYNODESTATE_block *chain__;
+struct YYNODESTATE_block *tail__;
+{
+	struct YYNODESTATE_block *head__;
+	if(!chain__)
+	{
+		return;
+	}
+	head__ = atomic_load_explicit(list__, memory_order_relaxed);
+	do
+	{
+		tail__->next__ = head__;
+	}
+	while(!atomic_compare_exchange_weak_explicit
+				(list__, &head__, chain__,
+				 memory_order_release, memory_order_relaxed));
+	if(!head__)
+	{
+		atomic_store_explicit(last__, tail__, memory_order_relaxed);
+	}
+}
+
+/*
+ * Free a chain of blocks.
+ */
+static void yynodefreeblocks__(block__)
+struct YYNODESTATE_block *block__;
+{
+	struct YYNODESTATE_block *next__;
+	while(block__ != 0)
+	{
+		next__ = block__->next__;
+		free(block__);
+		block__ = next__;
+	}
+}
+
+/*
+ * Find the calling thread's chunk entry for a state, or else take
+ * over the entries of other states in turn.
+ */
+static struct YYNODESTATE_chunk *yynodechunk__(state__)
+YYNODESTATE *state__;
+{
+	unsigned int index__;
+	for(index__ = 0; index__ < YYNODESTATE_SHARED_STATES; ++index__)
+	{
+		if(chunks__[index__].state__ == (const void *)state__)
+		{
+			return &(chunks__[index__]);
+		}
+	}
+	index__ = next_chunk__;
+	next_chunk__ = (index__ + 1) % YYNODESTATE_SHARED_STATES;
+	chunks__[index__].state__ = (const void *)state__;
+	return &(chunks__[index__]);
+}
+
+/*
+ * Allocate memory when the calling thread's private chunk cannot
+ * satisfy the request.  This is the only place where threads
+ * contend with each other.
+ */
+static void *yynodeallocslow__(state__, size__)
+YYNODESTATE *state__;
+size_t size__;
+{
+	struct YYNODESTATE_chunk *chunk__;
+	struct YYNODESTATE_block *block__;
+	struct YYNODESTATE_block *newblock__;
+	size_t offset__;
+	char *data__;
+
+	/* Large requests get a dedicated block of their own, so
+	   that they don't waste the rest of the private chunk */
+	if(size__ > (YYNODESTATE_CHUNK / 4))
+	{
+		newblock__ = yynodenewblock__(state__, size__);
+		if(!newblock__)
+		{
+			return (void *)0;
+		}
+		newblock__->next__ = 0;
+		atomic_init(&(newblock__->used__), size__);
+		yynodesplice__(&(state__->large__), &(state__->large_last__),
+					   newblock__, newblock__);
+		return (void *)(YYNODESTATE_BLKDATA(newblock__));
+	}
+
+	/* Reserve a new private chunk within the current shared block,
+	   or install a new shared block if the current one is full */
+	block__ = atomic_load_explicit(&(state__->blocks__),
+								   memory_order_acquire);
+	for(;;)
+	{
+		if(block__)
+		{
+			offset__ = atomic_fetch_add_explicit
+				(&(block__->used__), YYNODESTATE_CHUNK,
+				 memory_order_relaxed);
+			if((offset__ + YYNODESTATE_CHUNK) <= block__->size__)
+			{
+				data__ = YYNODESTATE_BLKDATA(block__) + offset__;
+				break;
+			}
+		}
+		newblock__ = yynodenewblock__
+			(state__, YYNODESTATE_CHUNK * YYNODESTATE_SHARED_CHUNKS);
+		if(!newblock__)
+		{
+			return (void *)0;
+		}
+		newblock__->next__ = block__;
+		atomic_init(&(newblock__->used__), YYNODESTATE_CHUNK);
+		if(atomic_compare_exchange_strong_explicit
+				(&(state__->blocks__), &block__, newblock__,
+				 memory_order_acq_rel, memory_order_acquire))
+		{
+			if(!block__)
+			{
+				atomic_store_explicit(&(state__->blocks_last__), newblock__,
+									  memory_order_relaxed);
+			}
+			data__ = YYNODESTATE_BLKDATA(newblock__);
+			break;
+		}
+
+		/* Another thread installed a block first, so use that instead */
+		free(newblock__);
+	}
+
+	/* Allocate the memory from the new private chunk */
+	chunk__ = yynodechunk__(state__);
+	chunk__->generation__ =
+		atomic_load_explicit(&(state__->generation__), memory_order_relaxed);
+	chunk__->next__ = data__ + size__;
+	chunk__->limit__ = data__ + YYNODESTATE_CHUNK;
+	return (void *)data__;
+}
+
+/*
+ * Allocate a block of memory.  Any number of threads may call
+ * this at the same time.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void *yynodealloc(state__, size__)
+YYNODESTATE *state__;
+unsigned int size__;
+{
+#else
+void *yynodealloc(size__)
+unsigned int size__;
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	struct YYNODESTATE_chunk *chunk__;
+	unsigned long generation__;
+	size_t rounded__;
+	unsigned int index__;
+	void *result__;
+
+	/* Round the size to the next alignment boundary */
+	rounded__ = ((size_t)size__ + YYNODESTATE_ALIGNMENT - 1) &
+					~((size_t)(YYNODESTATE_ALIGNMENT - 1));
+
+	/* Allocate from the private chunk for this state if there is one */
+	generation__ = atomic_load_explicit(&(state__->generation__),
+										memory_order_relaxed);
+	chunk__ = chunks__;
+	for(index__ = 0; index__ < YYNODESTATE_SHARED_STATES; ++index__)
+	{
+		if(chunk__->state__ == (const void *)state__ &&
+		   chunk__->generation__ == generation__)
+		{
+			if(rounded__ <= (size_t)(chunk__->limit__ - chunk__->next__))
+			{
+				result__ = (void *)(chunk__->next__);
+				chunk__->next__ += rounded__;
+				return result__;
+			}
+			break;
+		}
+		++chunk__;
+	}
+	return yynodeallocslow__(state__, rounded__);
+}
+
+/*
+ * Push the node allocation state.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+int yynodepush(state__)
+YYNODESTATE *state__;
+{
+#else
+int yynodepush()
+{
+#endif
+	return 1;
+}
+
+/*
+ * Pop the node allocation state.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodepop(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodepop()
+{
+#endif
+}
+
+/*
+ * Mark the node allocation state.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+YYNODESTATE_mark yynodemark(state__)
+YYNODESTATE *state__;
+{
+#else
+YYNODESTATE_mark yynodemark()
+{
+#endif
+	YYNODESTATE_mark mark__;
+	mark__.dummy__ = 0;
+	return mark__;
+}
+
+/*
+ * Roll back to a mark.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynoderollback(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynoderollback(mark__)
+YYNODESTATE_mark mark__;
+{
+#endif
+}
+
+/*
+ * Commit to a mark.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodecommit(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynodecommit(mark__)
+YYNODESTATE_mark mark__;
+{
+#endif
+}
+
+#ifdef YYNODESTATE_REENTRANT
+
+/*
+ * Move all nodes from one node allocation pool to another.  Other
+ * threads may allocate from "state__" while this is in progress,
+ * but not from "src__".
+ */
+void yynodeadopt(state__, src__)
+YYNODESTATE *state__;
+YYNODESTATE *src__;
+{
+	yynodesplice__(&(state__->blocks__), &(state__->blocks_last__),
+		atomic_exchange_explicit(&(src__->blocks__),
+								 (struct YYNODESTATE_block *)0,
+								 memory_order_acquire),
+		atomic_exchange_explicit(&(src__->blocks_last__),
+								 (struct YYNODESTATE_block *)0,
+								 memory_order_relaxed));
+	yynodesplice__(&(state__->large__), &(state__->large_last__),
+		atomic_exchange_explicit(&(src__->large__),
+								 (struct YYNODESTATE_block *)0,
+								 memory_order_acquire),
+		atomic_exchange_explicit(&(src__->large_last__),
+								 (struct YYNODESTATE_block *)0,
+								 memory_order_relaxed));
+	atomic_store_explicit(&(src__->generation__), yynodegeneration__(),
+						  memory_order_relaxed);
+}
+
+#endif /* YYNODESTATE_REENTRANT */
+
+/*
+ * Clear the node allocation pool completely.  No other thread may
+ * allocate from the pool while this is in progress.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodeclear(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodeclear()
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	yynodefreeblocks__
+		(atomic_exchange_explicit(&(state__->blocks__),
+								  (struct YYNODESTATE_block *)0,
+								  memory_order_acquire));
+	yynodefreeblocks__
+		(atomic_exchange_explicit(&(state__->large__),
+								  (struct YYNODESTATE_block *)0,
+								  memory_order_acquire));
+	atomic_store_explicit(&(state__->blocks_last__),
+						  (struct YYNODESTATE_block *)0, memory_order_relaxed);
+	atomic_store_explicit(&(state__->large_last__),
+						  (struct YYNODESTATE_block *)0, memory_order_relaxed);
+	atomic_store_explicit(&(state__->generation__), yynodegeneration__(),
+						  memory_order_relaxed);
+}
+
+/*
+ * Trim the retired block cache.  Not used in the shared version.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodetrim(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodetrim()
+{
+#endif
+}
@@ -0,0 +1,19 @@
+#include <stdatomic.h>
+#ifndef YYNODESTATE_CACHE_LINE
+#define	YYNODESTATE_CACHE_LINE	64
+#endif
+typedef struct
+{
+	atomic_ulong generation__;
+	char pad__[YYNODESTATE_CACHE_LINE];
+	_Atomic(struct YYNODESTATE_block *) blocks__;
+	_Atomic(struct YYNODESTATE_block *) large__;
+	_Atomic(struct YYNODESTATE_block *) blocks_last__;
+	_Atomic(struct YYNODESTATE_block *) large_last__;
+
+} YYNODESTATE;
+typedef struct
+{
+	int dummy__;
+
+} YYNODESTATE_mark;
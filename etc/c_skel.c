@@ -22,18 +22,52 @@
  */
 
 #include <stdlib.h>
+#if defined(YYNODESTATE_STATS) || defined(YYNODESTATE_FREE_LISTS)
+#include <string.h>
+#endif
+
+/*
+ * Blocks at least YYNODESTATE_MMAP_THRESHOLD bytes in size are
+ * mapped directly from the operating system.
+ */
+#ifdef YYNODESTATE_MMAP_THRESHOLD
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define	MAP_ANONYMOUS	MAP_ANON
+#endif
+#endif
 
 #ifndef YYNODESTATE_BLKSIZ
 #define	YYNODESTATE_BLKSIZ	2048
 #endif
 
 /*
- * Types used by the allocation routines.
+ * Block sizes double from YYNODESTATE_BLKSIZ up to this limit.
+ * The limit is never less than the initial block size, or no
+ * block would be small enough for the retired block cache.
+ */
+#ifndef YYNODESTATE_MAXBLKSIZ
+#define	YYNODESTATE_MAXBLKSIZ	YYNODESTATE_BLKSIZ
+#elif YYNODESTATE_MAXBLKSIZ < YYNODESTATE_BLKSIZ
+#undef	YYNODESTATE_MAXBLKSIZ
+#define	YYNODESTATE_MAXBLKSIZ	YYNODESTATE_BLKSIZ
+#endif
+
+/*
+ * Maximum number of retired blocks to keep for re-use.
+ */
+#ifndef YYNODESTATE_CACHE
+#define	YYNODESTATE_CACHE	0
+#endif
+
+/*
+ * Types used by the allocation routines.  The node data for a
+ * block follows the header, at an offset of YYNODESTATE_BLKHDR.
  */
 struct YYNODESTATE_block
 {
-	char data__[YYNODESTATE_BLKSIZ];
 	struct YYNODESTATE_block *next__;
+	unsigned int size__;
 
 };
 struct YYNODESTATE_push
@@ -41,14 +75,24 @@ struct YYNODESTATE_push
 	struct YYNODESTATE_push *next__;
 	struct YYNODESTATE_block *saved_block__;
 	int saved_used__;
+#ifdef YYNODESTATE_STATS
+	unsigned long saved_requested__;
+	unsigned long saved_padding__;
+	unsigned long saved_tail_waste__;
+#endif
 };
 
 /*
  * The fixed global state to use for non-reentrant allocation.
+ * Each thread has its own copy if YYNODESTATE_THREAD_LOCAL is defined.
  */
 #ifndef YYNODESTATE_REENTRANT
+#ifdef YYNODESTATE_THREAD_LOCAL
+static YYNODESTATE_THREAD_LOCAL YYNODESTATE fixed_state__;
+#else
 static YYNODESTATE fixed_state__;
 #endif
+#endif
 
 /*
  * Some macro magic to determine the default alignment
@@ -86,6 +130,16 @@ YYNODESTATE_ALIGN_CHECK_TYPE(double, double);
 			 YYNODESTATE_ALIGN_FOR_TYPE(float), \
 			 YYNODESTATE_ALIGN_FOR_TYPE(double)))
 
+/*
+ * Size of a block header, rounded up so that the node data
+ * that follows it is correctly aligned.
+ */
+#define	YYNODESTATE_BLKHDR	\
+	((sizeof(struct YYNODESTATE_block) + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+#define	YYNODESTATE_BLKDATA(block)	\
+	(((char *)(block)) + YYNODESTATE_BLKHDR)
+
 /*
  * Initialize the node allocation pool.
  */
@@ -99,8 +153,182 @@ void yynodeinit()
 	YYNODESTATE *state__ = &fixed_state__;
 #endif
 	state__->blocks__ = 0;
+	state__->last_block__ = 0;
+	state__->adopted__ = 0;
+	state__->adopted_last__ = 0;
 	state__->push_stack__ = 0;
 	state__->used__ = 0;
+	state__->blksize__ = YYNODESTATE_BLKSIZ;
+	state__->free_blocks__ = 0;
+	state__->num_free__ = 0;
+#ifdef YYNODESTATE_FREE_LISTS
+	memset(state__->free_lists__, 0, sizeof(state__->free_lists__));
+#endif
+#ifdef YYNODESTATE_STATS
+	memset(&(state__->stats__), 0, sizeof(YYNODESTATE_stats));
+#endif
+}
+
+/*
+ * Obtain a new block with room for at least "size__" bytes of
+ * node data, from the retired block cache or from the system.
+ */
+static struct YYNODESTATE_block *yynodenewblock__(state__, size__)
+YYNODESTATE *state__;
+unsigned int size__;
+{
+	struct YYNODESTATE_block *block__;
+
+	/* Re-use a block from the retired block cache if it is big enough */
+	block__ = state__->free_blocks__;
+	if(block__ && block__->size__ >= size__)
+	{
+		state__->free_blocks__ = block__->next__;
+		--(state__->num_free__);
+		return block__;
+	}
+
+	/* Very large blocks are mapped directly from the operating system */
+#ifdef YYNODESTATE_MMAP_THRESHOLD
+	if((YYNODESTATE_BLKHDR + size__) >= YYNODESTATE_MMAP_THRESHOLD)
+	{
+		block__ = (struct YYNODESTATE_block *)
+			mmap((void *)0, YYNODESTATE_BLKHDR + size__,
+				 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(block__ == (struct YYNODESTATE_block *)MAP_FAILED)
+		{
+			block__ = 0;
+		}
+	#ifdef MADV_HUGEPAGE
+		else
+		{
+			madvise((void *)block__, YYNODESTATE_BLKHDR + size__,
+					MADV_HUGEPAGE);
+		}
+	#endif
+	}
+	else
+#endif
+	{
+		block__ = (struct YYNODESTATE_block *)
+						malloc(YYNODESTATE_BLKHDR + size__);
+	}
+	if(!block__)
+	{
+		/* The system is out of memory.  The programmer can
+		   supply the "yynodefailed" function to report the
+		   out of memory state and/or abort the program */
+#ifdef YYNODESTATE_REENTRANT
+		yynodefailed(state__);
+#else
+		yynodefailed();
+#endif
+		return 0;
+	}
+	block__->size__ = size__;
+	return block__;
+}
+
+/*
+ * Return a block to the system.
+ */
+static void yynodefreeblock__(block__)
+struct YYNODESTATE_block *block__;
+{
+#ifdef YYNODESTATE_MMAP_THRESHOLD
+	if((YYNODESTATE_BLKHDR + block__->size__) >= YYNODESTATE_MMAP_THRESHOLD)
+	{
+		munmap((void *)block__, YYNODESTATE_BLKHDR + block__->size__);
+		return;
+	}
+#endif
+	free(block__);
+}
+
+#ifdef YYNODESTATE_STATS
+
+/*
+ * Update the statistics for a block that is about to be added
+ * to the chain.  The rest of the current block becomes waste.
+ */
+static void yynodestatblock__(state__, block__)
+YYNODESTATE *state__;
+struct YYNODESTATE_block *block__;
+{
+	if(state__->blocks__)
+	{
+		state__->stats__.tail_waste +=
+			state__->blocks__->size__ - state__->used__;
+	}
+	state__->stats__.reserved += block__->size__;
+	++(state__->stats__.blocks);
+	if(state__->stats__.reserved > state__->stats__.peak)
+	{
+		state__->stats__.peak = state__->stats__.reserved;
+	}
+}
+
+#endif /* YYNODESTATE_STATS */
+
+/*
+ * Retire a block that has been removed from a chain, keeping ordinary
+ * blocks in the retired block cache if there is room for them.
+ */
+static void yynoderetire__(state__, block__)
+YYNODESTATE *state__;
+struct YYNODESTATE_block *block__;
+{
+#ifdef YYNODESTATE_STATS
+	state__->stats__.reserved -= block__->size__;
+	--(state__->stats__.blocks);
+#endif
+	if(block__->size__ <= YYNODESTATE_MAXBLKSIZ &&
+	   state__->num_free__ < YYNODESTATE_CACHE)
+	{
+		block__->next__ = state__->free_blocks__;
+		state__->free_blocks__ = block__;
+		++(state__->num_free__);
+	}
+	else
+	{
+		yynodefreeblock__(block__);
+	}
+}
+
+/*
+ * Release all blocks above a saved block.
+ */
+static void yynoderelease__(state__, saved_block__)
+YYNODESTATE *state__;
+struct YYNODESTATE_block *saved_block__;
+{
+	struct YYNODESTATE_block *temp_block__;
+	while(state__->blocks__ != saved_block__)
+	{
+		temp_block__ = state__->blocks__;
+		state__->blocks__ = temp_block__->next__;
+		yynoderetire__(state__, temp_block__);
+	}
+	if(!(state__->blocks__))
+	{
+		state__->last_block__ = 0;
+	}
+}
+
+/*
+ * Release the blocks that were adopted from other node pools.
+ */
+static void yynodereleaseadopted__(state__)
+YYNODESTATE *state__;
+{
+	struct YYNODESTATE_block *temp_block__;
+	while(state__->adopted__ != 0)
+	{
+		temp_block__ = state__->adopted__;
+		state__->adopted__ = temp_block__->next__;
+		yynoderetire__(state__, temp_block__);
+	}
+	state__->adopted_last__ = 0;
 }
 
 /*
@@ -121,43 +349,124 @@ unsigned int size__;
 	void *result__;
 
 	/* Round the size to the next alignment boundary */
+#ifdef YYNODESTATE_STATS
+	state__->stats__.requested += size__;
+	state__->stats__.padding -= size__;
+#endif
 	size__ = (size__ + YYNODESTATE_ALIGNMENT - 1) &
 				~(YYNODESTATE_ALIGNMENT - 1);
+#ifdef YYNODESTATE_STATS
+	state__->stats__.padding += size__;
+#endif
+
+	/* Recycle a freed block of the same size class if possible */
+#ifdef YYNODESTATE_FREE_LISTS
+	if((size__ / YYNODESTATE_ALIGNMENT) < YYNODESTATE_FREE_CLASSES)
+	{
+		result__ = state__->free_lists__[size__ / YYNODESTATE_ALIGNMENT];
+		if(result__)
+		{
+			state__->free_lists__[size__ / YYNODESTATE_ALIGNMENT] =
+				*((void **)result__);
+			return result__;
+		}
+	}
+#endif
 
 	/* Do we need to allocate a new block? */
 	block__ = state__->blocks__;
-	if(!block__ || (state__->used__ + size__) > YYNODESTATE_BLKSIZ)
+	if(!block__ || (state__->used__ + size__) > block__->size__)
 	{
-		if(size__ > YYNODESTATE_BLKSIZ)
+		if(size__ > state__->blksize__)
 		{
-			/* The allocation is too big for the node pool */
-			return (void *)0;
+			/* The allocation is too big for the node pool, so give
+			   it a dedicated block of its own.  The block is marked
+			   as full so that the next allocation starts afresh */
+			block__ = yynodenewblock__(state__, size__);
+			if(!block__)
+			{
+				return (void *)0;
+			}
+		#ifdef YYNODESTATE_STATS
+			yynodestatblock__(state__, block__);
+			state__->stats__.tail_waste += block__->size__ - size__;
+		#endif
+			if(!(state__->blocks__))
+			{
+				state__->last_block__ = block__;
+			}
+			block__->next__ = state__->blocks__;
+			state__->blocks__ = block__;
+			state__->used__ = block__->size__;
+			return (void *)(YYNODESTATE_BLKDATA(block__));
 		}
-		block__ = (struct YYNODESTATE_block *)
-						malloc(sizeof(struct YYNODESTATE_block));
+		block__ = yynodenewblock__(state__, state__->blksize__);
 		if(!block__)
 		{
-			/* The system is out of memory.  The programmer can
-			   supply the "yynodefailed" function to report the
-			   out of memory state and/or abort the program */
-#ifdef YYNODESTATE_REENTRANT
-			yynodefailed(state__);
-#else
-			yynodefailed();
-#endif
 			return (void *)0;
 		}
+	#ifdef YYNODESTATE_STATS
+		yynodestatblock__(state__, block__);
+	#endif
+		if(!(state__->blocks__))
+		{
+			state__->last_block__ = block__;
+		}
 		block__->next__ = state__->blocks__;
 		state__->blocks__ = block__;
 		state__->used__ = 0;
+
+		/* Grow the size of the next block, up to the maximum */
+		if(state__->blksize__ < YYNODESTATE_MAXBLKSIZ)
+		{
+			state__->blksize__ *= 2;
+			if(state__->blksize__ > YYNODESTATE_MAXBLKSIZ)
+			{
+				state__->blksize__ = YYNODESTATE_MAXBLKSIZ;
+			}
+		}
 	}
 
 	/* Allocate the memory and return it */
-	result__ = (void *)(block__->data__ + state__->used__);
+	result__ = (void *)(YYNODESTATE_BLKDATA(block__) + state__->used__);
 	state__->used__ += size__;
 	return result__;
 }
 
+#ifdef YYNODESTATE_FREE_LISTS
+
+/*
+ * Deallocate a block of memory, by adding it to the free list
+ * for its size class.  Blocks that are too large are ignored.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodedealloc(state__, ptr__, size__)
+YYNODESTATE *state__;
+void *ptr__;
+unsigned int size__;
+{
+#else
+void yynodedealloc(ptr__, size__)
+void *ptr__;
+unsigned int size__;
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	unsigned int index__;
+	index__ = (size__ + YYNODESTATE_ALIGNMENT - 1) / YYNODESTATE_ALIGNMENT;
+	if(ptr__ && size__ > 0 && index__ < YYNODESTATE_FREE_CLASSES)
+	{
+	#ifdef YYNODESTATE_STATS
+		state__->stats__.requested -= size__;
+		state__->stats__.padding -= index__ * YYNODESTATE_ALIGNMENT - size__;
+	#endif
+		*((void **)ptr__) = state__->free_lists__[index__];
+		state__->free_lists__[index__] = ptr__;
+	}
+}
+
+#endif /* YYNODESTATE_FREE_LISTS */
+
 /*
  * Push the node allocation state.
  */
@@ -173,10 +482,20 @@ int yynodepush()
 	struct YYNODESTATE_block *saved_block__;
 	int saved_used__;
 	struct YYNODESTATE_push *push_item__;
+#ifdef YYNODESTATE_STATS
+	unsigned long saved_requested__;
+	unsigned long saved_padding__;
+	unsigned long saved_tail_waste__;
+#endif
 
 	/* Save the current state of the node allocation pool */
 	saved_block__ = state__->blocks__;
 	saved_used__ = state__->used__;
+#ifdef YYNODESTATE_STATS
+	saved_requested__ = state__->stats__.requested;
+	saved_padding__ = state__->stats__.padding;
+	saved_tail_waste__ = state__->stats__.tail_waste;
+#endif
 
 	/* Allocate space for a push item */
 #ifdef YYNODESTATE_REENTRANT
@@ -194,6 +513,11 @@ int yynodepush()
 	/* Copy the saved information to the push item */
 	push_item__->saved_block__ = saved_block__;
 	push_item__->saved_used__ = saved_used__;
+#ifdef YYNODESTATE_STATS
+	push_item__->saved_requested__ = saved_requested__;
+	push_item__->saved_padding__ = saved_padding__;
+	push_item__->saved_tail_waste__ = saved_tail_waste__;
+#endif
 
 	/* Add the push item to the push stack */
 	push_item__->next__ = state__->push_stack__;
@@ -215,31 +539,187 @@ void yynodepop()
 #endif
 	struct YYNODESTATE_push *push_item__;
 	struct YYNODESTATE_block *saved_block__;
-	struct YYNODESTATE_block *temp_block__;
 
 	/* Pop the top of the push stack */
 	push_item__ = state__->push_stack__;
 	if(push_item__ == 0)
 	{
+		yynodereleaseadopted__(state__);
 		saved_block__ = 0;
 		state__->used__ = 0;
+		state__->blksize__ = YYNODESTATE_BLKSIZ;
+	#ifdef YYNODESTATE_STATS
+		state__->stats__.requested = 0;
+		state__->stats__.padding = 0;
+		state__->stats__.tail_waste = 0;
+	#endif
 	}
 	else
 	{
 		saved_block__ = push_item__->saved_block__;
 		state__->used__ = push_item__->saved_used__;
 		state__->push_stack__ = push_item__->next__;
+	#ifdef YYNODESTATE_STATS
+		state__->stats__.requested = push_item__->saved_requested__;
+		state__->stats__.padding = push_item__->saved_padding__;
+		state__->stats__.tail_waste = push_item__->saved_tail_waste__;
+	#endif
 	}
 
-	/* Free unnecessary blocks */
-	while(state__->blocks__ != saved_block__)
+	/* Free unnecessary blocks.  The free lists may refer to
+	   the blocks that are released, so they are discarded */
+	yynoderelease__(state__, saved_block__);
+#ifdef YYNODESTATE_FREE_LISTS
+	memset(state__->free_lists__, 0, sizeof(state__->free_lists__));
+#endif
+}
+
+/*
+ * Mark the current position of the node allocation pool.
+ */
+#ifdef YYNODESTATE_REENTRANT
+YYNODESTATE_mark yynodemark(state__)
+YYNODESTATE *state__;
+{
+#else
+YYNODESTATE_mark yynodemark()
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	YYNODESTATE_mark mark__;
+	mark__.block__ = state__->blocks__;
+	mark__.push_stack__ = state__->push_stack__;
+	mark__.used__ = state__->used__;
+#ifdef YYNODESTATE_STATS
+	mark__.requested__ = state__->stats__.requested;
+	mark__.padding__ = state__->stats__.padding;
+	mark__.tail_waste__ = state__->stats__.tail_waste;
+#endif
+	return mark__;
+}
+
+/*
+ * Roll the node allocation pool back to a mark, discarding
+ * all nodes that were allocated after the mark was taken.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynoderollback(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynoderollback(mark__)
+YYNODESTATE_mark mark__;
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	yynoderelease__(state__, mark__.block__);
+	state__->push_stack__ = mark__.push_stack__;
+	state__->used__ = mark__.used__;
+#ifdef YYNODESTATE_FREE_LISTS
+	memset(state__->free_lists__, 0, sizeof(state__->free_lists__));
+#endif
+#ifdef YYNODESTATE_STATS
+	state__->stats__.requested = mark__.requested__;
+	state__->stats__.padding = mark__.padding__;
+	state__->stats__.tail_waste = mark__.tail_waste__;
+#endif
+}
+
+/*
+ * Commit the nodes that were allocated after a mark was taken.
+ * Nothing needs to be done, because the mark is held by value.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodecommit(state__, mark__)
+YYNODESTATE *state__;
+YYNODESTATE_mark mark__;
+{
+#else
+void yynodecommit(mark__)
+YYNODESTATE_mark mark__;
+{
+#endif
+}
+
+#ifdef YYNODESTATE_REENTRANT
+
+/*
+ * Move all nodes from one node allocation pool to another, by
+ * splicing the source's blocks onto the destination's list of
+ * adopted blocks.  The adopted blocks are kept until the destination
+ * is cleared, so that they are not released by popping or rolling
+ * back the destination.  The source is left empty.
+ */
+void yynodeadopt(state__, src__)
+YYNODESTATE *state__;
+YYNODESTATE *src__;
+{
+	struct YYNODESTATE_block *chain__;
+	struct YYNODESTATE_block *tail__;
+	if(src__ == state__)
 	{
-		temp_block__ = state__->blocks__;
-		state__->blocks__ = temp_block__->next__;
-		free(temp_block__);
+		return;
+	}
+
+	/* Join the source's own blocks to the blocks that it adopted */
+	chain__ = src__->blocks__;
+	tail__ = src__->last_block__;
+	if(!chain__)
+	{
+		chain__ = src__->adopted__;
+		tail__ = src__->adopted_last__;
+	}
+	else if(src__->adopted__)
+	{
+		tail__->next__ = src__->adopted__;
+		tail__ = src__->adopted_last__;
+	}
+	if(!chain__)
+	{
+		return;
+	}
+#ifdef YYNODESTATE_STATS
+	if(src__->blocks__)
+	{
+		src__->stats__.tail_waste +=
+			src__->blocks__->size__ - src__->used__;
+	}
+	state__->stats__.requested += src__->stats__.requested;
+	state__->stats__.padding += src__->stats__.padding;
+	state__->stats__.tail_waste += src__->stats__.tail_waste;
+	state__->stats__.reserved += src__->stats__.reserved;
+	state__->stats__.blocks += src__->stats__.blocks;
+	if(state__->stats__.reserved > state__->stats__.peak)
+	{
+		state__->stats__.peak = state__->stats__.reserved;
+	}
+	src__->stats__.requested = 0;
+	src__->stats__.padding = 0;
+	src__->stats__.tail_waste = 0;
+	src__->stats__.reserved = 0;
+	src__->stats__.blocks = 0;
+#endif
+	tail__->next__ = state__->adopted__;
+	if(!(state__->adopted__))
+	{
+		state__->adopted_last__ = tail__;
 	}
+	state__->adopted__ = chain__;
+	src__->blocks__ = 0;
+	src__->last_block__ = 0;
+	src__->adopted__ = 0;
+	src__->adopted_last__ = 0;
+	src__->push_stack__ = 0;
+	src__->used__ = 0;
+	src__->blksize__ = YYNODESTATE_BLKSIZ;
+#ifdef YYNODESTATE_FREE_LISTS
+	memset(src__->free_lists__, 0, sizeof(src__->free_lists__));
+#endif
 }
 
+#endif /* YYNODESTATE_REENTRANT */
+
 /*
  * Clear the node allocation pool completely.
  */
@@ -249,16 +729,81 @@ YYNODESTATE *state__;
 {
 #else
 void yynodeclear()
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	yynoderelease__(state__, 0);
+	yynodereleaseadopted__(state__);
+	state__->push_stack__ = 0;
+	state__->used__ = 0;
+	state__->blksize__ = YYNODESTATE_BLKSIZ;
+#ifdef YYNODESTATE_FREE_LISTS
+	memset(state__->free_lists__, 0, sizeof(state__->free_lists__));
+#endif
+#ifdef YYNODESTATE_STATS
+	state__->stats__.requested = 0;
+	state__->stats__.padding = 0;
+	state__->stats__.tail_waste = 0;
+#endif
+}
+
+/*
+ * Return all blocks in the retired block cache to the system.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodetrim(state__)
+YYNODESTATE *state__;
+{
+#else
+void yynodetrim()
 {
 	YYNODESTATE *state__ = &fixed_state__;
 #endif
 	struct YYNODESTATE_block *temp_block__;
-	while(state__->blocks__ != 0)
+	while(state__->free_blocks__ != 0)
 	{
-		temp_block__ = state__->blocks__;
-		state__->blocks__ = temp_block__->next__;
-		free(temp_block__);
+		temp_block__ = state__->free_blocks__;
+		state__->free_blocks__ = temp_block__->next__;
+		yynodefreeblock__(temp_block__);
 	}
-	state__->push_stack__ = 0;
-	state__->used__ = 0;
+	state__->num_free__ = 0;
 }
+
+#ifdef YYNODESTATE_STATS
+
+/*
+ * Get the allocation statistics for the node allocation pool.
+ */
+#ifdef YYNODESTATE_REENTRANT
+const YYNODESTATE_stats *yynodestats(state__)
+YYNODESTATE *state__;
+{
+#else
+const YYNODESTATE_stats *yynodestats()
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	return &(state__->stats__);
+}
+
+/*
+ * Count the creation of a node of a particular kind.
+ */
+#ifdef YYNODESTATE_REENTRANT
+void yynodecount__(state__, kind__, size__)
+YYNODESTATE *state__;
+int kind__;
+unsigned int size__;
+{
+#else
+void yynodecount__(kind__, size__)
+int kind__;
+unsigned int size__;
+{
+	YYNODESTATE *state__ = &fixed_state__;
+#endif
+	++(state__->stats__.kind_count[kind__]);
+	state__->stats__.kind_bytes[kind__] += size__;
+}
+
+#endif /* YYNODESTATE_STATS */
@@ -1,7 +1,48 @@
+#if defined(YYNODESTATE_FREE_LISTS) && !defined(YYNODESTATE_FREE_CLASSES)
+#define	YYNODESTATE_FREE_CLASSES	64
+#endif
+#ifdef YYNODESTATE_STATS
+typedef struct
+{
+	unsigned long requested;
+	unsigned long reserved;
+	unsigned long padding;
+	unsigned long tail_waste;
+	unsigned long blocks;
+	unsigned long peak;
+	unsigned long kind_count[YYNODESTATE_NUM_KINDS];
+	unsigned long kind_bytes[YYNODESTATE_NUM_KINDS];
+
+} YYNODESTATE_stats;
+#endif
 typedef struct
 {
 	struct YYNODESTATE_block *blocks__;
+	struct YYNODESTATE_block *last_block__;
+	struct YYNODESTATE_block *adopted__;
+	struct YYNODESTATE_block *adopted_last__;
 	struct YYNODESTATE_push *push_stack__;
 	int used__;
+	unsigned int blksize__;
+	struct YYNODESTATE_block *free_blocks__;
+	int num_free__;
+#ifdef YYNODESTATE_FREE_LISTS
+	void *free_lists__[YYNODESTATE_FREE_CLASSES];
+#endif
+#ifdef YYNODESTATE_STATS
+	YYNODESTATE_stats stats__;
+#endif
 
 } YYNODESTATE;
+typedef struct
+{
+	struct YYNODESTATE_block *block__;
+	struct YYNODESTATE_push *push_stack__;
+	int used__;
+#ifdef YYNODESTATE_STATS
+	unsigned long requested__;
+	unsigned long padding__;
+	unsigned long tail_waste__;
+#endif
+
+} YYNODESTATE_mark;
@@ -97,6 +97,41 @@ void YYNODESTATE::pop()
 	/* Not used with the garbage collector */
 }
 
+/*
+ * Mark the node allocation state.
+ */
+YYNODESTATE::Mark YYNODESTATE::mark() const
+{
+	/* Not used with the garbage collector */
+	Mark mark__;
+	mark__.dummy__ = 0;
+	return mark__;
+}
+
+/*
+ * Roll back to a mark.
+ */
+void YYNODESTATE::rollback(const Mark &mark__)
+{
+	/* Not used with the garbage collector */
+}
+
+/*
+ * Commit to a mark.
+ */
+void YYNODESTATE::commit(const Mark &mark__)
+{
+	/* Not used with the garbage collector */
+}
+
+/*
+ * Move all nodes from another node allocation pool to this one.
+ */
+void YYNODESTATE::adopt(YYNODESTATE *src__)
+{
+	/* Not used with the garbage collector */
+}
+
 /*
  * Clear the node allocation pool completely.
  */
@@ -105,6 +140,14 @@ void YYNODESTATE::clear()
 	/* Not used with the garbage collector */
 }
 
+/*
+ * Trim the retired block cache.
+ */
+void YYNODESTATE::trim()
+{
+	/* Not used with the garbage collector */
+}
+
 #endif /* YYNODESTATE_USE_ALLOCATOR */
 
 /*
@@ -1 +1,7 @@
+public:
+
+	struct Mark
+	{
+		int dummy__;
+	};
 
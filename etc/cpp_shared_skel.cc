@@ -0,0 +1,493 @@
+/*
+ * treecc shared node allocation routines for C++.
+ *
+ * Copyright (C) 2026  Southern Storm Software, Pty Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * As a special exception, when this file is copied by treecc into
+ * a treecc output file, you may use that output file without restriction.
+ */
+
+#include <stdlib.h>
+
+/*
+ * Size of the private chunk that each thread allocates nodes from.
+ */
+#ifndef YYNODESTATE_BLKSIZ
+#define	YYNODESTATE_BLKSIZ	2048
+#endif
+
+/*
+ * Number of private chunks that are carved out of each shared block.
+ */
+#ifndef YYNODESTATE_SHARED_CHUNKS
+#define	YYNODESTATE_SHARED_CHUNKS	16
+#endif
+
+/*
+ * Number of states that each thread can hold a private chunk for.
+ */
+#ifndef YYNODESTATE_SHARED_STATES
+#define	YYNODESTATE_SHARED_STATES	4
+#endif
+
+/*
+ * Types used by the allocation routines.  The node data for a
+ * block follows the header, at an offset of YYNODESTATE_BLKHDR.
+ * Threads reserve chunks within a block by advancing "used__".
+ */
+struct YYNODESTATE_block
+{
+	struct YYNODESTATE_block *next__;
+	size_t size__;
+	std::atomic<size_t> used__;
+
+};
+
+/*
+ * The calling thread's private chunks, one for each of the states that
+ * it allocated from most recently.  Nodes are carved from them without
+ * touching memory that is written by other threads.  A chunk is only
+ * valid for its state while the state has the same generation number.
+ */
+struct YYNODESTATE_chunk
+{
+	const void *state__;
+	unsigned long generation__;
+	char *next__;
+	char *limit__;
+};
+static thread_local struct YYNODESTATE_chunk
+	YYNODESTATE_chunks__[YYNODESTATE_SHARED_STATES];
+static thread_local unsigned int YYNODESTATE_next_chunk__;
+
+/*
+ * Source of generation numbers.  Every state is given a new number
+ * when it is constructed or cleared, which invalidates the chunks
+ * that threads were holding for it.
+ */
+static std::atomic<unsigned long> YYNODESTATE_generation__(0);
+
+/*
+ * Initialize the singleton instance.  It is shared between all threads,
+ * so it must be constructed before the threads start creating nodes.
+ */
+#ifndef YYNODESTATE_REENTRANT
+YYNODESTATE *YYNODESTATE::state__ = 0;
+#endif
+
+/*
+ * Some macro magic to determine the default alignment
+ * on this machine.  This will compile down to a constant.
+ */
+#define	YYNODESTATE_ALIGN_CHECK_TYPE(type,name)	\
+	struct _YYNODESTATE_align_##name { \
+		char pad; \
+		type field; \
+	}
+#define	YYNODESTATE_ALIGN_FOR_TYPE(type)	\
+	((unsigned)(unsigned long)(&(((struct _YYNODESTATE_align_##type *)0)->field)))
+#define	YYNODESTATE_ALIGN_MAX(a,b)	\
+	((a) > (b) ? (a) : (b))
+#define	YYNODESTATE_ALIGN_MAX3(a,b,c) \
+	(YYNODESTATE_ALIGN_MAX((a), YYNODESTATE_ALIGN_MAX((b), (c))))
+YYNODESTATE_ALIGN_CHECK_TYPE(int, int);
+YYNODESTATE_ALIGN_CHECK_TYPE(long, long);
+#if defined(WIN32) && !defined(__CYGWIN__)
+YYNODESTATE_ALIGN_CHECK_TYPE(__int64, long_long);
+#else
+YYNODESTATE_ALIGN_CHECK_TYPE(long long, long_long);
+#endif
+YYNODESTATE_ALIGN_CHECK_TYPE(void *, void_p);
+YYNODESTATE_ALIGN_CHECK_TYPE(float, float);
+YYNODESTATE_ALIGN_CHECK_TYPE(double, double);
+#define	YYNODESTATE_ALIGNMENT	\
+	YYNODESTATE_ALIGN_MAX( \
+			YYNODESTATE_ALIGN_MAX3	\
+			(YYNODESTATE_ALIGN_FOR_TYPE(int), \
+		     YYNODESTATE_ALIGN_FOR_TYPE(long), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(long_long)), \
+  	     YYNODESTATE_ALIGN_MAX3 \
+		 	(YYNODESTATE_ALIGN_FOR_TYPE(void_p), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(float), \
+			 YYNODESTATE_ALIGN_FOR_TYPE(double)))
+
+/*
+ * Size of a block header, rounded up so that the node data
+ * that follows it is correctly aligned.
+ */
+#define	YYNODESTATE_BLKHDR	\
+	((sizeof(struct YYNODESTATE_block) + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+#define	YYNODESTATE_BLKDATA(block)	\
+	(((char *)(block)) + YYNODESTATE_BLKHDR)
+
+/*
+ * Size of a private chunk, rounded up to the alignment boundary.
+ */
+#define	YYNODESTATE_CHUNK	\
+	((YYNODESTATE_BLKSIZ + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+
+/*
+ * Constructor for YYNODESTATE.
+ */
+YYNODESTATE::YYNODESTATE()
+	: generation__(nextgeneration__()), blocks__(0), large__(0),
+	  blocks_last__(0), large_last__(0)
+{
+#ifndef YYNODESTATE_REENTRANT
+	/* Register this object as the singleton instance */
+	if(!state__)
+	{
+		state__ = this;
+	}
+#endif
+}
+
+/*
+ * Destructor for YYNODESTATE.
+ */
+YYNODESTATE::~YYNODESTATE()
+{
+	/* Free all node memory */
+	freeblocks__(blocks__.exchange(0, std::memory_order_acquire));
+	freeblocks__(large__.exchange(0, std::memory_order_acquire));
+
+#ifndef YYNODESTATE_REENTRANT
+	/* We are no longer the singleton instance */
+	if(state__ == this)
+	{
+		state__ = 0;
+	}
+#endif
+}
+
+#ifdef YYNODESTATE_USE_ALLOCATOR
+
+/*
+ * Allocate a block of memory.  Any number of threads may call
+ * this at the same time.
+ */
+void *YYNODESTATE::alloc(size_t size__)
+{
+	struct YYNODESTATE_chunk *chunk__ = YYNODESTATE_chunks__;
+	unsigned long generation__;
+	void *result__;
+
+	/* Round the size to the next alignment boundary */
+	size__ = (size__ + YYNODESTATE_ALIGNMENT - 1) &
+				~(YYNODESTATE_ALIGNMENT - 1);
+
+	/* Allocate from the private chunk for this state if there is one */
+	generation__ = this->generation__.load(std::memory_order_relaxed);
+	for(int index__ = 0; index__ < YYNODESTATE_SHARED_STATES; ++index__)
+	{
+		if(chunk__->state__ == (const void *)this &&
+		   chunk__->generation__ == generation__)
+		{
+			if(size__ <= (size_t)(chunk__->limit__ - chunk__->next__))
+			{
+				result__ = (void *)(chunk__->next__);
+				chunk__->next__ += size__;
+				return result__;
+			}
+			break;
+		}
+		++chunk__;
+	}
+	return allocslow__(size__);
+}
+
+/*
+ * Deallocate a block of memory.
+ */
+void YYNODESTATE::dealloc(void *ptr__, size_t size__)
+{
+	/* Nothing to do for this type of node allocator */
+}
+
+/*
+ * Push the node allocation state.
+ */
+int YYNODESTATE::push()
+{
+	/* Not used with the shared allocator */
+	return 1;
+}
+
+/*
+ * Pop the node allocation state.
+ */
+void YYNODESTATE::pop()
+{
+	/* Not used with the shared allocator */
+}
+
+/*
+ * Mark the node allocation state.
+ */
+YYNODESTATE::Mark YYNODESTATE::mark() const
+{
+	/* Not used with the shared allocator */
+	Mark mark__;
+	mark__.dummy__ = 0;
+	return mark__;
+}
+
+/*
+ * Roll back to a mark.
+ */
+void YYNODESTATE::rollback(const Mark &mark__)
+{
+	/* Not used with the shared allocator */
+}
+
+/*
+ * Commit to a mark.
+ */
+void YYNODESTATE::commit(const Mark &mark__)
+{
+	/* Not used with the shared allocator */
+}
+
+/*
+ * Move all nodes from another node allocation pool to this one.
+ * Other threads may allocate from this pool while this is in
+ * progress, but not from "src__".
+ */
+void YYNODESTATE::adopt(YYNODESTATE *src__)
+{
+	splice__(blocks__, blocks_last__,
+			 src__->blocks__.exchange(0, std::memory_order_acquire),
+			 src__->blocks_last__.exchange(0, std::memory_order_relaxed));
+	splice__(large__, large_last__,
+			 src__->large__.exchange(0, std::memory_order_acquire),
+			 src__->large_last__.exchange(0, std::memory_order_relaxed));
+	src__->generation__.store(nextgeneration__(), std::memory_order_relaxed);
+}
+
+/*
+ * Clear the node allocation pool completely.  No other thread may
+ * allocate from the pool while this is in progress.
+ */
+void YYNODESTATE::clear()
+{
+	freeblocks__(blocks__.exchange(0, std::memory_order_acquire));
+	freeblocks__(large__.exchange(0, std::memory_order_acquire));
+	blocks_last__.store(0, std::memory_order_relaxed);
+	large_last__.store(0, std::memory_order_relaxed);
+	generation__.store(nextgeneration__(), std::memory_order_relaxed);
+}
+
+/*
+ * Trim the retired block cache.
+ */
+void YYNODESTATE::trim()
+{
+	/* Not used with the shared allocator */
+}
+
+/*
+ * Allocate memory when the calling thread's private chunk cannot
+ * satisfy the request.  This is the only place where threads
+ * contend with each other.
+ */
+void *YYNODESTATE::allocslow__(size_t size__)
+{
+	struct YYNODESTATE_chunk *chunk__;
+	struct YYNODESTATE_block *block__;
+	struct YYNODESTATE_block *added__;
+	size_t offset__;
+	char *data__;
+
+	/* Large requests get a dedicated block of their own, so
+	   that they don't waste the rest of the private chunk */
+	if(size__ > (YYNODESTATE_CHUNK / 4))
+	{
+		added__ = newblock__(size__);
+		if(!added__)
+		{
+			return (void *)0;
+		}
+		added__->next__ = 0;
+		added__->used__.store(size__, std::memory_order_relaxed);
+		splice__(large__, large_last__, added__, added__);
+		return (void *)(YYNODESTATE_BLKDATA(added__));
+	}
+
+	/* Reserve a new private chunk within the current shared block,
+	   or install a new shared block if the current one is full */
+	block__ = blocks__.load(std::memory_order_acquire);
+	for(;;)
+	{
+		if(block__)
+		{
+			offset__ = block__->used__.fetch_add
+				(YYNODESTATE_CHUNK, std::memory_order_relaxed);
+			if((offset__ + YYNODESTATE_CHUNK) <= block__->size__)
+			{
+				data__ = YYNODESTATE_BLKDATA(block__) + offset__;
+				break;
+			}
+		}
+		added__ = newblock__
+			(YYNODESTATE_CHUNK * YYNODESTATE_SHARED_CHUNKS);
+		if(!added__)
+		{
+			return (void *)0;
+		}
+		added__->next__ = block__;
+		added__->used__.store(YYNODESTATE_CHUNK, std::memory_order_relaxed);
+		if(blocks__.compare_exchange_strong
+				(block__, added__,
+				 std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			if(!block__)
+			{
+				blocks_last__.store(added__, std::memory_order_relaxed);
+			}
+			data__ = YYNODESTATE_BLKDATA(added__);
+			break;
+		}
+
+		/* Another thread installed a block first, so use that instead */
+		added__->~YYNODESTATE_block();
+		free(added__);
+	}
+
+	/* Allocate the memory from the new private chunk */
+	chunk__ = findchunk__();
+	chunk__->generation__ = generation__.load(std::memory_order_relaxed);
+	chunk__->next__ = data__ + size__;
+	chunk__->limit__ = data__ + YYNODESTATE_CHUNK;
+	return (void *)data__;
+}
+
+/*
+ * Find the calling thread's chunk entry for this state, or else
+ * take over the entries of other states in turn.
+ */
+struct YYNODESTATE_chunk *YYNODESTATE::findchunk__()
+{
+	int index__;
+	for(index__ = 0; index__ < YYNODESTATE_SHARED_STATES; ++index__)
+	{
+		if(YYNODESTATE_chunks__[index__].state__ == (const void *)this)
+		{
+			return &(YYNODESTATE_chunks__[index__]);
+		}
+	}
+	index__ = YYNODESTATE_next_chunk__;
+	YYNODESTATE_next_chunk__ = (index__ + 1) % YYNODESTATE_SHARED_STATES;
+	YYNODESTATE_chunks__[index__].state__ = (const void *)this;
+	return &(YYNODESTATE_chunks__[index__]);
+}
+
+/*
+ * Obtain a new block with room for "size__" bytes of node data.
+ */
+struct YYNODESTATE_block *YYNODESTATE::newblock__(size_t size__)
+{
+	void *memory__ = malloc(YYNODESTATE_BLKHDR + size__);
+	if(!memory__)
+	{
+		/* The system is out of memory.  The programmer can
+		   inherit the "failed" method to report the
+		   out of memory state and/or abort the program */
+		failed();
+		return 0;
+	}
+	struct YYNODESTATE_block *block__ = new (memory__) YYNODESTATE_block;
+	block__->size__ = size__;
+	return block__;
+}
+
+#endif /* YYNODESTATE_USE_ALLOCATOR */
+
+/*
+ * Get a new generation number.
+ */
+unsigned long YYNODESTATE::nextgeneration__()
+{
+	return YYNODESTATE_generation__.fetch_add
+				(1, std::memory_order_relaxed) + 1;
+}
+
+/*
+ * Push a chain of blocks, ending at "tail__", onto the front of a
+ * shared block list.  Blocks are only ever added to the front, so the
+ * last block in a list is recorded in "last__" when the list is filled.
+ */
+void YYNODESTATE::splice__(std::atomic<struct YYNODESTATE_block *> &list__,
+						   std::atomic<struct YYNODESTATE_block *> &last__,
+						   struct YYNODESTATE_block *chain__,
+						   struct YYNODESTATE_block *tail__)
+{
+	struct YYNODESTATE_block *head__;
+	if(!chain__)
+	{
+		return;
+	}
+	head__ = list__.load(std::memory_order_relaxed);
+	do
+	{
+		tail__->next__ = head__;
+	}
+	while(!list__.compare_exchange_weak
+				(head__, chain__,
+				 std::memory_order_release, std::memory_order_relaxed));
+	if(!head__)
+	{
+		last__.store(tail__, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * Free a chain of blocks.
+ */
+void YYNODESTATE::freeblocks__(struct YYNODESTATE_block *block__)
+{
+	struct YYNODESTATE_block *next__;
+	while(block__ != 0)
+	{
+		next__ = block__->next__;
+		block__->~YYNODESTATE_block();
+		free(block__);
+		block__ = next__;
+	}
+}
+
+/*
+ * Default implementation of functions which may be overridden.
+ */
+void YYNODESTATE::failed()
+{
+}
+
+#ifdef YYNODESTATE_TRACK_LINES
+
+const char *YYNODESTATE::currFilename() const
+{
+	return (const char *)0;
+}
+
+long YYNODESTATE::currLinenum() const
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+public:
+
+	struct Mark
+	{
+		int dummy__;
+	};
+
+private:
+
+#ifndef YYNODESTATE_CACHE_LINE
+#define	YYNODESTATE_CACHE_LINE	64
+#endif
+	std::atomic<unsigned long> generation__;
+	char pad__[YYNODESTATE_CACHE_LINE];
+	std::atomic<struct YYNODESTATE_block *> blocks__;
+	std::atomic<struct YYNODESTATE_block *> large__;
+	std::atomic<struct YYNODESTATE_block *> blocks_last__;
+	std::atomic<struct YYNODESTATE_block *> large_last__;
+
+	void *allocslow__(size_t size__);
+	struct YYNODESTATE_chunk *findchunk__();
+	struct YYNODESTATE_block *newblock__(size_t size__);
+	static unsigned long nextgeneration__();
+	static void splice__(std::atomic<struct YYNODESTATE_block *> &list__,
+						 std::atomic<struct YYNODESTATE_block *> &last__,
+						 struct YYNODESTATE_block *chain__,
+						 struct YYNODESTATE_block *tail__);
+	static void freeblocks__(struct YYNODESTATE_block *block__);
@@ -26,12 +26,41 @@
 #endif
 
 /*
- * Types used by the allocation routines.
+ * Block sizes double from YYNODESTATE_BLKSIZ up to this limit.
+ * The limit is never less than the initial block size, or no
+ * block would be small enough for the retired block cache.
+ */
+#ifndef YYNODESTATE_MAXBLKSIZ
+#define	YYNODESTATE_MAXBLKSIZ	YYNODESTATE_BLKSIZ
+#elif YYNODESTATE_MAXBLKSIZ < YYNODESTATE_BLKSIZ
+#undef	YYNODESTATE_MAXBLKSIZ
+#define	YYNODESTATE_MAXBLKSIZ	YYNODESTATE_BLKSIZ
+#endif
+
+/*
+ * Blocks at least this large are mapped directly from the operating
+ * system.  The output file must include <sys/mman.h> for this.
+ */
+#if defined(YYNODESTATE_MMAP_THRESHOLD) && \
+		!defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define	MAP_ANONYMOUS	MAP_ANON
+#endif
+
+/*
+ * Maximum number of retired blocks to keep for re-use.
+ */
+#ifndef YYNODESTATE_CACHE
+#define	YYNODESTATE_CACHE	0
+#endif
+
+/*
+ * Types used by the allocation routines.  The node data for a
+ * block follows the header, at an offset of YYNODESTATE_BLKHDR.
  */
 struct YYNODESTATE_block
 {
-	char data__[YYNODESTATE_BLKSIZ];
 	struct YYNODESTATE_block *next__;
+	unsigned int size__;
 
 };
 struct YYNODESTATE_push
@@ -39,14 +68,101 @@ struct YYNODESTATE_push
 	struct YYNODESTATE_push *next__;
 	struct YYNODESTATE_block *saved_block__;
 	int saved_used__;
+#ifdef YYNODESTATE_STATS
+	unsigned long saved_requested__;
+	unsigned long saved_padding__;
+	unsigned long saved_tail_waste__;
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	unsigned long saved_serial__;
+#endif
+};
+#ifdef YYNODESTATE_FINALIZERS
+
+/*
+ * Finalizer records are kept in a doubly-linked list, newest first, so
+ * that a node can cancel its own records in constant time.  Positions
+ * in the list are identified by serial number, which stays valid when
+ * other records are unlinked.  A record with no function holds the
+ * finalizers that were adopted from another node pool.
+ */
+struct YYNODESTATE_finalizer
+{
+	struct YYNODESTATE_finalizer *next__;
+	struct YYNODESTATE_finalizer **prev__;
+	struct YYNODESTATE_finalizer *same__;
+	struct YYNODESTATE_finalizer *adopted__;
+	unsigned long serial__;
+	void (*func__)(void *);
+	void *obj__;
+};
+
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+
+/*
+ * Memory resource that is given to the fields of nodes.  Requests are
+ * passed on to the node pool that currently holds the nodes, so that
+ * the fields follow their nodes when another pool adopts them.
+ */
+struct YYNODESTATE_resource : public std::pmr::memory_resource
+{
+	YYNODESTATE *owner__;
+	struct YYNODESTATE_resource *forward__;
+	struct YYNODESTATE_resource *retired__;
+	struct YYNODESTATE_resource *next__;
+
+	YYNODESTATE_resource(YYNODESTATE *state__)
+		: owner__(state__), forward__(0), retired__(0), next__(0) {}
+
+	YYNODESTATE *target__() const
+		{
+			const struct YYNODESTATE_resource *resource__ = this;
+			while(resource__->forward__ != 0)
+			{
+				resource__ = resource__->forward__;
+			}
+			return resource__->owner__;
+		}
+
+	/* Free a list of retired resources, and the resources
+	   that were retired along with each of them */
+	static void release__(struct YYNODESTATE_resource *list__)
+		{
+			struct YYNODESTATE_resource *next__;
+			while(list__ != 0)
+			{
+				next__ = list__->next__;
+				release__(list__->retired__);
+				delete list__;
+				list__ = next__;
+			}
+		}
+
+protected:
+
+	void *do_allocate(size_t bytes__, size_t align__)
+		{ return target__()->allocate(bytes__, align__); }
+	void do_deallocate(void *ptr__, size_t bytes__, size_t align__)
+		{ target__()->deallocate(ptr__, bytes__, align__); }
+	bool do_is_equal(const std::pmr::memory_resource &other__)
+		const noexcept
+		{ return (this == &other__); }
 };
 
+#endif
+
 /*
- * Initialize the singleton instance.
+ * Initialize the singleton instance.  Each thread has its
+ * own instance if YYNODESTATE_THREAD_LOCAL is defined.
  */
 #ifndef YYNODESTATE_REENTRANT
+#ifdef YYNODESTATE_THREAD_LOCAL
+YYNODESTATE_THREAD_LOCAL YYNODESTATE *YYNODESTATE::state__ = 0;
+#else
 YYNODESTATE *YYNODESTATE::state__ = 0;
 #endif
+#endif
 
 /*
  * Some macro magic to determine the default alignment
@@ -84,6 +200,16 @@ YYNODESTATE_ALIGN_CHECK_TYPE(double, double);
 			 YYNODESTATE_ALIGN_FOR_TYPE(float), \
 			 YYNODESTATE_ALIGN_FOR_TYPE(double)))
 
+/*
+ * Size of a block header, rounded up so that the node data
+ * that follows it is correctly aligned.
+ */
+#define	YYNODESTATE_BLKHDR	\
+	((sizeof(struct YYNODESTATE_block) + YYNODESTATE_ALIGNMENT - 1) & \
+				~(YYNODESTATE_ALIGNMENT - 1))
+#define	YYNODESTATE_BLKDATA(block)	\
+	(((char *)(block)) + YYNODESTATE_BLKHDR)
+
 /*
  * Constructor for YYNODESTATE.
  */
@@ -91,8 +217,29 @@ YYNODESTATE::YYNODESTATE()
 {
 	/* Initialize the allocation state */
 	blocks__ = 0;
+	last_block__ = 0;
+	adopted__ = 0;
+	adopted_last__ = 0;
 	push_stack__ = 0;
 	used__ = 0;
+	blksize__ = YYNODESTATE_BLKSIZ;
+	free_blocks__ = 0;
+	num_free__ = 0;
+#ifdef YYNODESTATE_FREE_LISTS
+	clearfree__();
+#endif
+#ifdef YYNODESTATE_STATS
+	stats__ = Stats();
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	finalizers__ = 0;
+	adopted_finals__ = 0;
+	free_finals__ = 0;
+	final_serial__ = 0;
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	resource__ = new YYNODESTATE_resource(this);
+#endif
 
 #ifndef YYNODESTATE_REENTRANT
 	/* Register this object as the singleton instance */
@@ -110,6 +257,12 @@ YYNODESTATE::~YYNODESTATE()
 {
 	/* Free all node memory */
 	clear();
+#ifdef YYNODESTATE_USE_ALLOCATOR
+	trim();
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	YYNODESTATE_resource::release__(resource__);
+#endif
 
 #ifndef YYNODESTATE_REENTRANT
 	/* We are no longer the singleton instance */
@@ -131,34 +284,86 @@ void *YYNODESTATE::alloc(size_t size__)
 	void *result__;
 
 	/* Round the size to the next alignment boundary */
+#ifdef YYNODESTATE_STATS
+	stats__.requested += size__;
+	stats__.padding -= size__;
+#endif
 	size__ = (size__ + YYNODESTATE_ALIGNMENT - 1) &
 				~(YYNODESTATE_ALIGNMENT - 1);
+#ifdef YYNODESTATE_STATS
+	stats__.padding += size__;
+#endif
+
+	/* Recycle a freed block of the same size class if possible */
+#ifdef YYNODESTATE_FREE_LISTS
+	if((size__ / YYNODESTATE_ALIGNMENT) < YYNODESTATE_FREE_CLASSES)
+	{
+		result__ = free_lists__[size__ / YYNODESTATE_ALIGNMENT];
+		if(result__)
+		{
+			free_lists__[size__ / YYNODESTATE_ALIGNMENT] =
+				*((void **)result__);
+			return result__;
+		}
+	}
+#endif
 
 	/* Do we need to allocate a new block? */
 	block__ = blocks__;
-	if(!block__ || (used__ + size__) > YYNODESTATE_BLKSIZ)
+	if(!block__ || (used__ + size__) > block__->size__)
 	{
-		if(size__ > YYNODESTATE_BLKSIZ)
+		if(size__ > blksize__)
 		{
-			/* The allocation is too big for the node pool */
-			return (void *)0;
+			/* The allocation is too big for the node pool, so give
+			   it a dedicated block of its own.  The block is marked
+			   as full so that the next allocation starts afresh */
+			block__ = newblock__(size__);
+			if(!block__)
+			{
+				return (void *)0;
+			}
+		#ifdef YYNODESTATE_STATS
+			statblock__(block__);
+			stats__.tail_waste += block__->size__ - size__;
+		#endif
+			if(!blocks__)
+			{
+				last_block__ = block__;
+			}
+			block__->next__ = blocks__;
+			blocks__ = block__;
+			used__ = block__->size__;
+			return (void *)(YYNODESTATE_BLKDATA(block__));
 		}
-		block__ = new YYNODESTATE_block;
+		block__ = newblock__(blksize__);
 		if(!block__)
 		{
-			/* The system is out of memory.  The programmer can
-			   inherit the "failed" method to report the
-			   out of memory state and/or abort the program */
-			failed();
 			return (void *)0;
 		}
+	#ifdef YYNODESTATE_STATS
+		statblock__(block__);
+	#endif
+		if(!blocks__)
+		{
+			last_block__ = block__;
+		}
 		block__->next__ = blocks__;
 		blocks__ = block__;
 		used__ = 0;
+
+		/* Grow the size of the next block, up to the maximum */
+		if(blksize__ < YYNODESTATE_MAXBLKSIZ)
+		{
+			blksize__ *= 2;
+			if(blksize__ > YYNODESTATE_MAXBLKSIZ)
+			{
+				blksize__ = YYNODESTATE_MAXBLKSIZ;
+			}
+		}
 	}
 
 	/* Allocate the memory and return it */
-	result__ = (void *)(block__->data__ + used__);
+	result__ = (void *)(YYNODESTATE_BLKDATA(block__) + used__);
 	used__ += size__;
 	return result__;
 }
@@ -168,7 +373,23 @@ void *YYNODESTATE::alloc(size_t size__)
  */
 void YYNODESTATE::dealloc(void *ptr__, size_t size__)
 {
+#ifdef YYNODESTATE_FREE_LISTS
+	/* Add the block to the free list for its size class.
+	   Blocks that are too large are ignored */
+	size_t index__;
+	index__ = (size__ + YYNODESTATE_ALIGNMENT - 1) / YYNODESTATE_ALIGNMENT;
+	if(ptr__ && size__ > 0 && index__ < YYNODESTATE_FREE_CLASSES)
+	{
+	#ifdef YYNODESTATE_STATS
+		stats__.requested -= size__;
+		stats__.padding -= index__ * YYNODESTATE_ALIGNMENT - size__;
+	#endif
+		*((void **)ptr__) = free_lists__[index__];
+		free_lists__[index__] = ptr__;
+	}
+#else
 	/* Nothing to do for this type of node allocator */
+#endif
 }
 
 /*
@@ -179,10 +400,20 @@ int YYNODESTATE::push()
 	struct YYNODESTATE_block *saved_block__;
 	int saved_used__;
 	struct YYNODESTATE_push *push_item__;
+#ifdef YYNODESTATE_STATS
+	unsigned long saved_requested__;
+	unsigned long saved_padding__;
+	unsigned long saved_tail_waste__;
+#endif
 
 	/* Save the current state of the node allocation pool */
 	saved_block__ = blocks__;
 	saved_used__ = used__;
+#ifdef YYNODESTATE_STATS
+	saved_requested__ = stats__.requested;
+	saved_padding__ = stats__.padding;
+	saved_tail_waste__ = stats__.tail_waste;
+#endif
 
 	/* Allocate space for a push item */
 	push_item__ = (struct YYNODESTATE_push *)
@@ -195,6 +426,14 @@ int YYNODESTATE::push()
 	/* Copy the saved information to the push item */
 	push_item__->saved_block__ = saved_block__;
 	push_item__->saved_used__ = saved_used__;
+#ifdef YYNODESTATE_FINALIZERS
+	push_item__->saved_serial__ = final_serial__;
+#endif
+#ifdef YYNODESTATE_STATS
+	push_item__->saved_requested__ = saved_requested__;
+	push_item__->saved_padding__ = saved_padding__;
+	push_item__->saved_tail_waste__ = saved_tail_waste__;
+#endif
 
 	/* Add the push item to the push stack */
 	push_item__->next__ = push_stack__;
@@ -209,49 +448,637 @@ void YYNODESTATE::pop()
 {
 	struct YYNODESTATE_push *push_item__;
 	struct YYNODESTATE_block *saved_block__;
-	struct YYNODESTATE_block *temp_block__;
 
 	/* Pop the top of the push stack */
 	push_item__ = push_stack__;
 	if(push_item__ == 0)
 	{
+	#ifdef YYNODESTATE_FINALIZERS
+		runlist__(&adopted_finals__, 0);
+		runfinal__(0);
+	#endif
+	#ifdef YYNODESTATE_MEMORY_RESOURCE
+		YYNODESTATE_resource::release__(resource__->retired__);
+		resource__->retired__ = 0;
+	#endif
+		releaseadopted__();
 		saved_block__ = 0;
 		used__ = 0;
+		blksize__ = YYNODESTATE_BLKSIZ;
+	#ifdef YYNODESTATE_STATS
+		stats__.requested = 0;
+		stats__.padding = 0;
+		stats__.tail_waste = 0;
+	#endif
 	}
 	else
 	{
+	#ifdef YYNODESTATE_FINALIZERS
+		runfinal__(push_item__->saved_serial__);
+	#endif
 		saved_block__ = push_item__->saved_block__;
 		used__ = push_item__->saved_used__;
 		push_stack__ = push_item__->next__;
+	#ifdef YYNODESTATE_STATS
+		stats__.requested = push_item__->saved_requested__;
+		stats__.padding = push_item__->saved_padding__;
+		stats__.tail_waste = push_item__->saved_tail_waste__;
+	#endif
 	}
 
-	/* Free unnecessary blocks */
-	while(blocks__ != saved_block__)
+	/* Free unnecessary blocks.  The free lists may refer to
+	   the blocks that are released, so they are discarded */
+	release__(saved_block__);
+#ifdef YYNODESTATE_FREE_LISTS
+	clearfree__();
+#endif
+}
+
+/*
+ * Mark the current position of the node allocation pool.
+ */
+YYNODESTATE::Mark YYNODESTATE::mark() const
+{
+	Mark mark__;
+	mark__.block__ = blocks__;
+	mark__.push_stack__ = push_stack__;
+	mark__.used__ = used__;
+#ifdef YYNODESTATE_STATS
+	mark__.requested__ = stats__.requested;
+	mark__.padding__ = stats__.padding;
+	mark__.tail_waste__ = stats__.tail_waste;
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	mark__.final_serial__ = final_serial__;
+#endif
+	return mark__;
+}
+
+/*
+ * Roll the node allocation pool back to a mark, discarding
+ * all nodes that were allocated after the mark was taken.
+ */
+void YYNODESTATE::rollback(const Mark &mark__)
+{
+#ifdef YYNODESTATE_FINALIZERS
+	runfinal__(mark__.final_serial__);
+#endif
+	release__(mark__.block__);
+	push_stack__ = mark__.push_stack__;
+	used__ = mark__.used__;
+#ifdef YYNODESTATE_FREE_LISTS
+	clearfree__();
+#endif
+#ifdef YYNODESTATE_STATS
+	stats__.requested = mark__.requested__;
+	stats__.padding = mark__.padding__;
+	stats__.tail_waste = mark__.tail_waste__;
+#endif
+}
+
+/*
+ * Commit the nodes that were allocated after a mark was taken.
+ * Nothing needs to be done, because the mark is held by value.
+ */
+void YYNODESTATE::commit(const Mark &mark__)
+{
+}
+
+/*
+ * Move all nodes from another node allocation pool to this one, by
+ * splicing the other pool's blocks onto our list of adopted blocks.
+ * The adopted blocks are kept until we are cleared, so that they are
+ * not released by popping or rolling back.  The other pool is left empty.
+ */
+void YYNODESTATE::adopt(YYNODESTATE *src__)
+{
+	struct YYNODESTATE_block *chain__;
+	struct YYNODESTATE_block *tail__;
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	struct YYNODESTATE_resource *fresh__;
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	struct YYNODESTATE_finalizer *final__;
+	struct YYNODESTATE_finalizer *adopted_final__;
+#endif
+	if(src__ == this || (!(src__->blocks__) && !(src__->adopted__)))
 	{
-		temp_block__ = blocks__;
-		blocks__ = temp_block__->next__;
-		delete temp_block__;
+		return;
+	}
+#ifdef YYNODESTATE_FINALIZERS
+	/* The finalizers of the other pool are held by records in our
+	   list of adopted finalizers, so that they run when we are
+	   cleared without walking the lists.  The records are allocated
+	   by the other pool, so that they are adopted along with it */
+	final__ = 0;
+	adopted_final__ = 0;
+	if(src__->finalizers__)
+	{
+		final__ = (struct YYNODESTATE_finalizer *)
+				src__->alloc(sizeof(struct YYNODESTATE_finalizer));
+		if(!final__)
+		{
+			return;
+		}
+	}
+	if(src__->adopted_finals__)
+	{
+		adopted_final__ = (struct YYNODESTATE_finalizer *)
+				src__->alloc(sizeof(struct YYNODESTATE_finalizer));
+		if(!adopted_final__)
+		{
+			return;
+		}
+	}
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	fresh__ = new YYNODESTATE_resource(src__);
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	if(final__)
+	{
+		adoptfinal__(final__, src__->finalizers__);
+		src__->finalizers__ = 0;
+	}
+	if(adopted_final__)
+	{
+		adoptfinal__(adopted_final__, src__->adopted_finals__);
+		src__->adopted_finals__ = 0;
+	}
+	src__->free_finals__ = 0;
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	/* The fields of the adopted nodes allocate from this pool from
+	   now on, and the other pool starts again with a fresh resource */
+	src__->resource__->forward__ = resource__;
+	src__->resource__->next__ = resource__->retired__;
+	resource__->retired__ = src__->resource__;
+	src__->resource__ = fresh__;
+#endif
+#ifdef YYNODESTATE_FREE_LISTS
+	/* The free lists of the other pool refer to the adopted blocks */
+	src__->clearfree__();
+#endif
+#ifdef YYNODESTATE_STATS
+	if(src__->blocks__)
+	{
+		src__->stats__.tail_waste += src__->blocks__->size__ - src__->used__;
+	}
+	stats__.requested += src__->stats__.requested;
+	stats__.padding += src__->stats__.padding;
+	stats__.tail_waste += src__->stats__.tail_waste;
+	stats__.reserved += src__->stats__.reserved;
+	stats__.blocks += src__->stats__.blocks;
+	if(stats__.reserved > stats__.peak)
+	{
+		stats__.peak = stats__.reserved;
+	}
+	src__->stats__.requested = 0;
+	src__->stats__.padding = 0;
+	src__->stats__.tail_waste = 0;
+	src__->stats__.reserved = 0;
+	src__->stats__.blocks = 0;
+#endif
+
+	/* Join the other pool's own blocks to the blocks that it adopted */
+	chain__ = src__->blocks__;
+	tail__ = src__->last_block__;
+	if(!chain__)
+	{
+		chain__ = src__->adopted__;
+		tail__ = src__->adopted_last__;
+	}
+	else if(src__->adopted__)
+	{
+		tail__->next__ = src__->adopted__;
+		tail__ = src__->adopted_last__;
 	}
+	tail__->next__ = adopted__;
+	if(!adopted__)
+	{
+		adopted_last__ = tail__;
+	}
+	adopted__ = chain__;
+	src__->blocks__ = 0;
+	src__->last_block__ = 0;
+	src__->adopted__ = 0;
+	src__->adopted_last__ = 0;
+	src__->push_stack__ = 0;
+	src__->used__ = 0;
+	src__->blksize__ = YYNODESTATE_BLKSIZ;
 }
 
 /*
  * Clear the node allocation pool completely.
  */
 void YYNODESTATE::clear()
+{
+#ifdef YYNODESTATE_FINALIZERS
+	runlist__(&adopted_finals__, 0);
+	runfinal__(0);
+#endif
+	release__(0);
+	releaseadopted__();
+	push_stack__ = 0;
+	used__ = 0;
+	blksize__ = YYNODESTATE_BLKSIZ;
+#ifdef YYNODESTATE_FREE_LISTS
+	clearfree__();
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	YYNODESTATE_resource::release__(resource__->retired__);
+	resource__->retired__ = 0;
+#endif
+#ifdef YYNODESTATE_STATS
+	stats__.requested = 0;
+	stats__.padding = 0;
+	stats__.tail_waste = 0;
+#endif
+}
+
+/*
+ * Return all blocks in the retired block cache to the system.
+ */
+void YYNODESTATE::trim()
+{
+	struct YYNODESTATE_block *temp_block__;
+	while(free_blocks__ != 0)
+	{
+		temp_block__ = free_blocks__;
+		free_blocks__ = temp_block__->next__;
+		freeblock__(temp_block__);
+	}
+	num_free__ = 0;
+}
+
+/*
+ * Obtain a new block with room for at least "size__" bytes of
+ * node data, from the retired block cache or from the system.
+ */
+struct YYNODESTATE_block *YYNODESTATE::newblock__(size_t size__)
+{
+	struct YYNODESTATE_block *block__;
+
+	/* Re-use a block from the retired block cache if it is big enough */
+	block__ = free_blocks__;
+	if(block__ && block__->size__ >= size__)
+	{
+		free_blocks__ = block__->next__;
+		--num_free__;
+		return block__;
+	}
+
+	/* Very large blocks are mapped directly from the operating system */
+#ifdef YYNODESTATE_MMAP_THRESHOLD
+	if((YYNODESTATE_BLKHDR + size__) >= YYNODESTATE_MMAP_THRESHOLD)
+	{
+		block__ = (struct YYNODESTATE_block *)
+			mmap((void *)0, YYNODESTATE_BLKHDR + size__,
+				 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(block__ == (struct YYNODESTATE_block *)MAP_FAILED)
+		{
+			block__ = 0;
+		}
+	#ifdef MADV_HUGEPAGE
+		else
+		{
+			madvise((void *)block__, YYNODESTATE_BLKHDR + size__,
+					MADV_HUGEPAGE);
+		}
+	#endif
+	}
+	else
+#endif
+	{
+		block__ = (struct YYNODESTATE_block *)
+			(new char [YYNODESTATE_BLKHDR + size__]);
+	}
+	if(!block__)
+	{
+		/* The system is out of memory.  The programmer can
+		   inherit the "failed" method to report the
+		   out of memory state and/or abort the program */
+		failed();
+		return 0;
+	}
+	block__->size__ = (unsigned int)size__;
+	return block__;
+}
+
+/*
+ * Return a block to the system.
+ */
+void YYNODESTATE::freeblock__(struct YYNODESTATE_block *block__)
+{
+#ifdef YYNODESTATE_MMAP_THRESHOLD
+	if((YYNODESTATE_BLKHDR + block__->size__) >= YYNODESTATE_MMAP_THRESHOLD)
+	{
+		munmap((void *)block__, YYNODESTATE_BLKHDR + block__->size__);
+		return;
+	}
+#endif
+	delete [] (char *)block__;
+}
+
+/*
+ * Retire a block that has been removed from a chain, keeping ordinary
+ * blocks in the retired block cache if there is room for them.
+ */
+void YYNODESTATE::retire__(struct YYNODESTATE_block *block__)
+{
+#ifdef YYNODESTATE_STATS
+	stats__.reserved -= block__->size__;
+	--(stats__.blocks);
+#endif
+	if(block__->size__ <= YYNODESTATE_MAXBLKSIZ &&
+	   num_free__ < YYNODESTATE_CACHE)
+	{
+		block__->next__ = free_blocks__;
+		free_blocks__ = block__;
+		++num_free__;
+	}
+	else
+	{
+		freeblock__(block__);
+	}
+}
+
+/*
+ * Release all blocks above a saved block.
+ */
+void YYNODESTATE::release__(struct YYNODESTATE_block *saved_block__)
 {
 	struct YYNODESTATE_block *temp_block__;
-	while(blocks__ != 0)
+	while(blocks__ != saved_block__)
 	{
 		temp_block__ = blocks__;
 		blocks__ = temp_block__->next__;
-		delete temp_block__;
+		retire__(temp_block__);
+	}
+	if(!blocks__)
+	{
+		last_block__ = 0;
+	}
+}
+
+/*
+ * Release the blocks that were adopted from other node pools.
+ */
+void YYNODESTATE::releaseadopted__()
+{
+	struct YYNODESTATE_block *temp_block__;
+	while(adopted__ != 0)
+	{
+		temp_block__ = adopted__;
+		adopted__ = temp_block__->next__;
+		retire__(temp_block__);
+	}
+	adopted_last__ = 0;
+}
+
+#ifdef YYNODESTATE_FREE_LISTS
+
+/*
+ * Discard the contents of the free lists.
+ */
+void YYNODESTATE::clearfree__()
+{
+	for(int index__ = 0; index__ < YYNODESTATE_FREE_CLASSES; ++index__)
+	{
+		free_lists__[index__] = 0;
+	}
+}
+
+#endif /* YYNODESTATE_FREE_LISTS */
+
+#ifdef YYNODESTATE_FINALIZERS
+
+/*
+ * Allocate a finalizer record, recycling a cancelled one if possible,
+ * and add it to the front of the list with the next serial number.
+ */
+struct YYNODESTATE_finalizer *YYNODESTATE::newfinal__()
+{
+	struct YYNODESTATE_finalizer *final__ = free_finals__;
+	if(final__)
+	{
+		free_finals__ = final__->next__;
+	}
+	else
+	{
+		final__ = (struct YYNODESTATE_finalizer *)
+				alloc(sizeof(struct YYNODESTATE_finalizer));
+		if(!final__)
+		{
+			return 0;
+		}
+	}
+	final__->next__ = finalizers__;
+	final__->prev__ = &finalizers__;
+	if(finalizers__)
+	{
+		finalizers__->prev__ = &(final__->next__);
+	}
+	final__->same__ = 0;
+	final__->adopted__ = 0;
+	final__->serial__ = ++final_serial__;
+	finalizers__ = final__;
+	return final__;
+}
+
+/*
+ * Add a record that holds a list of finalizers from another node
+ * pool to the front of our list of adopted finalizers.
+ */
+void YYNODESTATE::adoptfinal__(struct YYNODESTATE_finalizer *final__,
+							   struct YYNODESTATE_finalizer *list__)
+{
+	final__->next__ = adopted_finals__;
+	final__->prev__ = &adopted_finals__;
+	if(adopted_finals__)
+	{
+		adopted_finals__->prev__ = &(final__->next__);
+	}
+	final__->same__ = 0;
+	final__->adopted__ = list__;
+	list__->prev__ = &(final__->adopted__);
+	final__->serial__ = 1;
+	final__->func__ = 0;
+	final__->obj__ = 0;
+	adopted_finals__ = final__;
+}
+
+/*
+ * Register a function to be called on "obj__" when the node allocation
+ * pool is popped, rolled back, or cleared past the current position.
+ * The records for an object are chained from "slot__", which is
+ * kept in the object so that they can be cancelled quickly.
+ */
+void YYNODESTATE::finalize__(void *obj__, void (*func__)(void *),
+							 Finalizers__ &slot__)
+{
+	struct YYNODESTATE_finalizer *final__ = newfinal__();
+	if(final__)
+	{
+		final__->func__ = func__;
+		final__->obj__ = obj__;
+		final__->same__ = slot__.list__;
+		slot__.list__ = final__;
+	}
+}
+
+/*
+ * Cancel the finalizers for an object that is being destroyed,
+ * and keep their records for re-use.
+ */
+void YYNODESTATE::unfinalize__(Finalizers__ &slot__)
+{
+	struct YYNODESTATE_finalizer *final__;
+	while((final__ = slot__.list__) != 0)
+	{
+		slot__.list__ = final__->same__;
+		*(final__->prev__) = final__->next__;
+		if(final__->next__)
+		{
+			final__->next__->prev__ = final__->prev__;
+		}
+		final__->next__ = free_finals__;
+		free_finals__ = final__;
+	}
+}
+
+/*
+ * Run the finalizers that were registered after the serial number
+ * "saved__", in the reverse order of registration.  The recycled
+ * records are discarded, because their blocks are about to be released.
+ */
+void YYNODESTATE::runfinal__(unsigned long saved__)
+{
+	runlist__(&finalizers__, saved__);
+	free_finals__ = 0;
+}
+
+/*
+ * Run the finalizers in a list that are newer than "saved__".
+ * Each record is unlinked before it is run, and left linked to
+ * itself in case its object is cancelled while being finalized.
+ */
+void YYNODESTATE::runlist__(struct YYNODESTATE_finalizer **list__,
+							unsigned long saved__)
+{
+	struct YYNODESTATE_finalizer *final__;
+	while((final__ = *list__) != 0 && final__->serial__ > saved__)
+	{
+		if(!(final__->func__))
+		{
+			runlist__(&(final__->adopted__), 0);
+		}
+		*list__ = final__->next__;
+		if(final__->next__)
+		{
+			final__->next__->prev__ = list__;
+		}
+		final__->next__ = 0;
+		final__->prev__ = &(final__->next__);
+		if(final__->func__)
+		{
+			(*(final__->func__))(final__->obj__);
+		}
+	}
+}
+
+#endif /* YYNODESTATE_FINALIZERS */
+
+#ifdef YYNODESTATE_STATS
+
+/*
+ * Update the statistics for a block that is about to be added
+ * to the chain.  The rest of the current block becomes waste.
+ */
+void YYNODESTATE::statblock__(struct YYNODESTATE_block *block__)
+{
+	if(blocks__)
+	{
+		stats__.tail_waste += blocks__->size__ - used__;
+	}
+	stats__.reserved += block__->size__;
+	++(stats__.blocks);
+	if(stats__.reserved > stats__.peak)
+	{
+		stats__.peak = stats__.reserved;
 	}
-	push_stack__ = 0;
-	used__ = 0;
 }
 
+#endif /* YYNODESTATE_STATS */
+
 #endif /* YYNODESTATE_USE_ALLOCATOR */
 
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+
+/*
+ * Allocate memory on behalf of a "std::pmr" container.  Requests
+ * for more than the default alignment are padded and aligned by hand.
+ */
+void *YYNODESTATE::do_allocate(size_t bytes__, size_t align__)
+{
+	void *result__;
+	if(bytes__ == 0)
+	{
+		bytes__ = 1;
+	}
+	if(align__ <= YYNODESTATE_ALIGNMENT)
+	{
+		result__ = alloc(bytes__);
+	}
+	else
+	{
+		result__ = alloc(bytes__ + align__ - 1);
+		if(result__)
+		{
+			result__ = (void *)((((size_t)result__) + align__ - 1) &
+								~(align__ - 1));
+		}
+	}
+	if(!result__)
+	{
+		throw std::bad_alloc();
+	}
+	return result__;
+}
+
+/*
+ * Deallocate memory on behalf of a "std::pmr" container.  The memory
+ * is recycled if free lists are in use, or reclaimed when the node
+ * pool is popped or cleared otherwise.
+ */
+void YYNODESTATE::do_deallocate(void *ptr__, size_t bytes__, size_t align__)
+{
+	if(align__ <= YYNODESTATE_ALIGNMENT)
+	{
+		dealloc(ptr__, (bytes__ != 0 ? bytes__ : 1));
+	}
+}
+
+/*
+ * Memory from one node pool cannot be released to another.
+ */
+bool YYNODESTATE::do_is_equal(const std::pmr::memory_resource &other__)
+	const noexcept
+{
+	return (this == &other__);
+}
+
+/*
+ * Get the memory resource for the fields of nodes that are
+ * allocated from this pool.
+ */
+std::pmr::memory_resource *YYNODESTATE::resource() const
+{
+	return resource__;
+}
+
+#endif /* YYNODESTATE_MEMORY_RESOURCE */
+
 /*
  * Default implementation of functions which may be overridden.
  */
@@ -1,5 +1,137 @@
+public:
+
+	struct Mark
+	{
+		struct YYNODESTATE_block *block__;
+		struct YYNODESTATE_push *push_stack__;
+		int used__;
+	#ifdef YYNODESTATE_STATS
+		unsigned long requested__;
+		unsigned long padding__;
+		unsigned long tail_waste__;
+	#endif
+	#ifdef YYNODESTATE_FINALIZERS
+		unsigned long final_serial__;
+	#endif
+	};
+
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+protected:
+
+	void *do_allocate(size_t bytes__, size_t align__);
+	void do_deallocate(void *ptr__, size_t bytes__, size_t align__);
+	bool do_is_equal(const std::pmr::memory_resource &other__)
+		const noexcept;
+
+public:
+
+	std::pmr::memory_resource *resource() const;
+
+	/* Construct a field value, passing the memory resource
+	   to its constructor if the field is allocator-aware */
+	template <typename T__, typename... A__>
+	static T__ construct__(YYNODESTATE *state__, A__&&... args__)
+		{
+			typedef std::pmr::polymorphic_allocator<char> alloc__;
+			if constexpr (std::is_constructible<T__, A__...,
+											const alloc__ &>::value)
+				return T__(std::forward<A__>(args__)...,
+						   alloc__(state__->resource()));
+			else
+				return T__(std::forward<A__>(args__)...);
+		}
+
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+public:
+
+	/* The finalizer records of a node, which are not copied
+	   when the node is copied */
+	struct Finalizers__
+	{
+		struct YYNODESTATE_finalizer *list__;
+
+		Finalizers__() : list__(0) {}
+		Finalizers__(const Finalizers__ &) : list__(0) {}
+		Finalizers__ &operator=(const Finalizers__ &) { return *this; }
+	};
+
+	void finalize__(void *obj__, void (*func__)(void *),
+					Finalizers__ &slot__);
+	void unfinalize__(Finalizers__ &slot__);
+	template <typename T__>
+	static void destroy__(T__ &value__) { value__.~T__(); }
+
+#endif
+#ifdef YYNODESTATE_STATS
+public:
+
+	struct Stats
+	{
+		unsigned long requested;
+		unsigned long reserved;
+		unsigned long padding;
+		unsigned long tail_waste;
+		unsigned long blocks;
+		unsigned long peak;
+		unsigned long kind_count[YYNODESTATE_NUM_KINDS];
+		unsigned long kind_bytes[YYNODESTATE_NUM_KINDS];
+	};
+
+	const Stats &stats() const { return stats__; }
+	void count__(int kind__, size_t size__)
+		{
+			++(stats__.kind_count[kind__]);
+			stats__.kind_bytes[kind__] += size__;
+		}
+
+#endif
 private:
 
 	struct YYNODESTATE_block *blocks__;
+	struct YYNODESTATE_block *last_block__;
+	struct YYNODESTATE_block *adopted__;
+	struct YYNODESTATE_block *adopted_last__;
 	struct YYNODESTATE_push *push_stack__;
 	int used__;
+	unsigned int blksize__;
+	struct YYNODESTATE_block *free_blocks__;
+	int num_free__;
+#ifdef YYNODESTATE_FREE_LISTS
+#ifndef YYNODESTATE_FREE_CLASSES
+#define	YYNODESTATE_FREE_CLASSES	64
+#endif
+	void *free_lists__[YYNODESTATE_FREE_CLASSES];
+#endif
+#ifdef YYNODESTATE_STATS
+	Stats stats__;
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	struct YYNODESTATE_finalizer *finalizers__;
+	struct YYNODESTATE_finalizer *adopted_finals__;
+	struct YYNODESTATE_finalizer *free_finals__;
+	unsigned long final_serial__;
+#endif
+#ifdef YYNODESTATE_MEMORY_RESOURCE
+	struct YYNODESTATE_resource *resource__;
+#endif
+
+	struct YYNODESTATE_block *newblock__(size_t size__);
+	static void freeblock__(struct YYNODESTATE_block *block__);
+	void retire__(struct YYNODESTATE_block *block__);
+	void release__(struct YYNODESTATE_block *saved_block__);
+	void releaseadopted__();
+#ifdef YYNODESTATE_FREE_LISTS
+	void clearfree__();
+#endif
+#ifdef YYNODESTATE_FINALIZERS
+	struct YYNODESTATE_finalizer *newfinal__();
+	void adoptfinal__(struct YYNODESTATE_finalizer *final__,
+					  struct YYNODESTATE_finalizer *list__);
+	void runfinal__(unsigned long saved__);
+	static void runlist__(struct YYNODESTATE_finalizer **list__,
+						  unsigned long saved__);
+#endif
+#ifdef YYNODESTATE_STATS
+	void statblock__(struct YYNODESTATE_block *block__);
+#endif
@@ -28,8 +28,161 @@
 extern	"C" {
 #endif
 
+/*
+ * Limits on the size of a virtual operation with "%dispatch auto"
+ * for it to be dispatched with an inline "switch" statement.
+ */
+#define	TREECC_AUTO_SWITCH_CASES	4
+#define	TREECC_AUTO_SWITCH_TYPES	16
+
+/*
+ * Count the node types in a hierarchy.
+ */
+static int CountNodeTypes(TreeCCNode *node)
+{
+	int count = 1;
+	node = node->firstChild;
+	while(node != 0)
+	{
+		count += CountNodeTypes(node);
+		node = node->nextSibling;
+	}
+	return count;
+}
+
+/*
+ * Resolve "%dispatch auto" on an operation to either "switch" or
+ * "vtable", based on the number of cases and the size of the
+ * node type hierarchy that the operation is declared on.
+ */
+static void ResolveDispatch(TreeCCContext *context, TreeCCOperation *oper)
+{
+	TreeCCNode *type;
+	if((oper->flags & TREECC_OPER_DISPATCH_AUTO) == 0)
+	{
+		return;
+	}
+	oper->flags &= ~TREECC_OPER_DISPATCH_AUTO;
+	if((oper->flags & TREECC_OPER_VIRTUAL) == 0)
+	{
+		return;
+	}
+	type = TreeCCNodeFindByType(context, oper->params->type);
+	if(type && oper->numCases <= TREECC_AUTO_SWITCH_CASES &&
+	   CountNodeTypes(type) <= TREECC_AUTO_SWITCH_TYPES)
+	{
+		oper->flags |= TREECC_OPER_DISPATCH_SWITCH;
+	}
+}
+
+/*
+ * Percentage of the profiled calls to an operation below which
+ * a case is cold, and moved out of line in "%inline" operations.
+ */
+#define	TREECC_PROFILE_COLD_PERCENT	1
+
+/*
+ * Assign indices to the operations that are instrumented by
+ * "%option profile_dispatch".  These are the virtual operations,
+ * and the non-virtual operations with a single node type trigger.
+ */
+static void NumberProfiledOperations(TreeCCContext *context)
+{
+	unsigned int hash;
+	TreeCCOperation *oper;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	int index = 0;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		oper = context->operHash[hash];
+		while(oper != 0)
+		{
+			if((oper->flags & TREECC_OPER_VIRTUAL) != 0)
+			{
+				oper->profileIndex = index++;
+			}
+			else if(oper->numTriggers == 1)
+			{
+				param = oper->params;
+				while((param->flags & TREECC_PARAM_TRIGGER) == 0)
+				{
+					param = param->next;
+				}
+				type = TreeCCNodeFindByType(context, param->type);
+				if(type && (type->flags & TREECC_NODE_ENUM) == 0)
+				{
+					oper->profileIndex = index++;
+				}
+			}
+			oper = oper->nextHash;
+		}
+	}
+}
+
+/*
+ * Add the hidden fields that cache the result of a "%memoize"
+ * operation to its trigger node type.  The generation stamp starts
+ * at zero, which never matches the current generation.  Memoization
+ * is only supported for C and C++.
+ */
+static void AddMemoFields(TreeCCContext *context, TreeCCOperation *oper)
+{
+	TreeCCNode *type;
+	char *name;
+	if((oper->flags & TREECC_OPER_MEMOIZE) == 0)
+	{
+		return;
+	}
+	if(context->language != TREECC_LANG_C &&
+	   context->language != TREECC_LANG_CPP)
+	{
+		oper->flags &= ~TREECC_OPER_MEMOIZE;
+		return;
+	}
+	type = TreeCCNodeFindByType(context, oper->params->type);
+	name = (char *)malloc(strlen(oper->name) + 9);
+	if(!name)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	sprintf(name, "%s_memo__", oper->name);
+	TreeCCFieldCreate(context, type, name,
+					  TreeCCDupString(oper->returnType), 0,
+					  TREECC_FIELD_NOCREATE);
+	name = (char *)malloc(strlen(oper->name) + 12);
+	if(!name)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	sprintf(name, "%s_memogen__", oper->name);
+	TreeCCFieldCreate(context, type, name,
+					  TreeCCDupString("unsigned long"),
+					  TreeCCDupString("0"), TREECC_FIELD_NOCREATE);
+}
+
 void TreeCCGenerate(TreeCCContext *context)
 {
+	/* Number the node kinds so that each subtree is a contiguous range */
+	if(context->kind_ranges)
+	{
+		TreeCCNodeNumberPreOrder(context);
+	}
+
+	/* Choose the dispatch style for "%dispatch auto" operations */
+	TreeCCOperationVisitAll(context, ResolveDispatch);
+
+	/* Add the result caches for "%memoize" operations */
+	TreeCCOperationVisitAll(context, AddMemoFields);
+
+	/* Select the operations to instrument for dispatch profiling */
+	if(context->profile_dispatch &&
+	   (context->language == TREECC_LANG_C ||
+	    context->language == TREECC_LANG_CPP))
+	{
+		NumberProfiledOperations(context);
+	}
+
 	switch(context->language)
 	{
 		case TREECC_LANG_C:
@@ -107,6 +260,135 @@ static int GenerateSelectors(TreeCCContext *context, TreeCCStream *stream,
 	return 1;
 }
 
+/*
+ * Generate the selector for a run of consecutive node kinds.
+ */
+static void GenerateRun(TreeCCContext *context, TreeCCStream *stream,
+						const TreeCCNonVirtual *nonVirt, TreeCCNode *first,
+						TreeCCNode *last, int triggerNum)
+{
+	if(first == last)
+	{
+		(*(nonVirt->genSelector))(context, stream, first, triggerNum);
+	}
+	else
+	{
+		(*(nonVirt->genRangeSelector))(context, stream, first,
+									   last, triggerNum);
+	}
+}
+
+/*
+ * Collect runs of consecutive node kinds within a subtree.
+ * Node types that were handled by another case leave gaps.
+ */
+static void CollectRuns(TreeCCContext *context, TreeCCStream *stream,
+						const TreeCCNonVirtual *nonVirt, TreeCCNode *node,
+						int markBit, int triggerNum,
+						TreeCCNode **first, TreeCCNode **last)
+{
+	/* Skip the subtree if we've already handled this case */
+	if((node->flags & markBit) != 0)
+	{
+		return;
+	}
+	node->flags |= markBit;
+
+	/* Extend the current run, or start a new one */
+	if(*last != 0 && node->number == (*last)->number + 1)
+	{
+		*last = node;
+	}
+	else
+	{
+		if(*first != 0)
+		{
+			GenerateRun(context, stream, nonVirt, *first, *last, triggerNum);
+		}
+		*first = node;
+		*last = node;
+	}
+
+	/* Collect runs for the children */
+	node = node->firstChild;
+	while(node != 0)
+	{
+		CollectRuns(context, stream, nonVirt, node, markBit,
+					triggerNum, first, last);
+		node = node->nextSibling;
+	}
+}
+
+/*
+ * Generate range selectors for one case of a "switch" statement.
+ * This relies upon the node kinds being numbered in pre-order.
+ */
+static int GenerateRangeSelectors(TreeCCContext *context,
+								  TreeCCStream *stream,
+								  const TreeCCNonVirtual *nonVirt,
+								  TreeCCNode *node, int markBit,
+								  int triggerNum)
+{
+	TreeCCNode *first = 0;
+	TreeCCNode *last = 0;
+
+	/* If the mark bit is already set, then we've already handled this case */
+	if((node->flags & markBit) != 0)
+	{
+		return 0;
+	}
+
+	/* Generate selectors for the runs of kinds in the subtree */
+	CollectRuns(context, stream, nonVirt, node, markBit,
+				triggerNum, &first, &last);
+	GenerateRun(context, stream, nonVirt, first, last, triggerNum);
+
+	/* We have done something non-trivial */
+	return 1;
+}
+
+/*
+ * Determine if an operation case is cold according to the profile.
+ */
+static int IsColdCase(TreeCCOperationCase *operCase)
+{
+	TreeCCOperation *oper = operCase->oper;
+	return (oper->hits != 0 &&
+			(double)(operCase->hits) * 100.0 <
+				(double)(oper->hits) * TREECC_PROFILE_COLD_PERCENT);
+}
+
+/*
+ * Determine if the code for an operation case is inserted directly
+ * into the "switch".  The cases of batch operations are moved out
+ * into functions so that the "switch" and the batch entry point
+ * can share the one copy of the code.
+ */
+static int IsInlineCase(TreeCCContext *context, TreeCCOperationCase *operCase)
+{
+	return ((operCase->oper->flags & TREECC_OPER_INLINE) != 0 &&
+			!IsColdCase(operCase) &&
+			!TreeCCIsBatchOperation(context, operCase->oper));
+}
+
+/*
+ * Output the code for an operation case within a "switch".
+ */
+static void GenerateCaseCode(TreeCCContext *context, TreeCCStream *stream,
+							 const TreeCCNonVirtual *nonVirt,
+							 TreeCCOperationCase *operCase, int level)
+{
+	if(IsInlineCase(context, operCase))
+	{
+		(*(nonVirt->genCaseInline))(context, stream, operCase, level);
+	}
+	else
+	{
+		(*(nonVirt->genCaseCall))(context, stream, operCase,
+								  operCase->number, level);
+	}
+}
+
 /*
  * Determine if the outer trigger levels of two operation cases match.
  */
@@ -143,6 +425,7 @@ static TreeCCOperationCase *GenerateSwitch
 	TreeCCTrigger *trigger;
 	TreeCCNode *node;
 	int isEnum;
+	int useRanges, handled;
 
 	/* Generate the head of the switch for this level */
 	param = oper->params;
@@ -167,20 +450,13 @@ static TreeCCOperationCase *GenerateSwitch
 	if(!param)
 	{
 		/* Output the code for the case */
-		if((oper->flags & TREECC_OPER_INLINE) != 0)
-		{
-			(*(nonVirt->genCaseInline))(context, stream, operCase,
-										triggerNum - 1);
-		}
-		else
-		{
-			(*(nonVirt->genCaseCall))(context, stream, operCase,
-									  operCase->number, triggerNum - 1);
-		}
+		GenerateCaseCode(context, stream, nonVirt, operCase, triggerNum - 1);
 		return operCase->next;
 	}
 	node = TreeCCNodeFindByType(context, param->type);
 	isEnum = ((node->flags & TREECC_NODE_ENUM) != 0);
+	useRanges = (context->kind_ranges && !isEnum &&
+				 nonVirt->genRangeSelector != 0);
 	if(param->name)
 	{
 		(*(nonVirt->genSwitchHead))(context, stream, param->name,
@@ -210,8 +486,19 @@ static TreeCCOperationCase *GenerateSwitch
 		}
 		if(trigger)
 		{
-			if(!GenerateSelectors(context, stream, nonVirt,
-							      trigger->node, markBit, triggerNum))
+			if(useRanges)
+			{
+				handled = GenerateRangeSelectors(context, stream, nonVirt,
+											     trigger->node, markBit,
+												 triggerNum);
+			}
+			else
+			{
+				handled = GenerateSelectors(context, stream, nonVirt,
+										    trigger->node, markBit,
+											triggerNum);
+			}
+			if(!handled)
 			{
 				/* We already output code for this with another case */
 				TreeCCErrorOnLine(context->input, operCase->filename,
@@ -237,6 +524,172 @@ static TreeCCOperationCase *GenerateSwitch
 	return operCase;
 }
 
+/*
+ * Collect the node types that are matched by one case of a "switch".
+ * Returns the new number of node types in "nodes".
+ */
+static int CollectSelectors(TreeCCNode *node, int markBit,
+							TreeCCNode **nodes, int num)
+{
+	if((node->flags & markBit) != 0)
+	{
+		return num;
+	}
+	node->flags |= markBit;
+	nodes[num++] = node;
+	node = node->firstChild;
+	while(node != 0)
+	{
+		num = CollectSelectors(node, markBit, nodes, num);
+		node = node->nextSibling;
+	}
+	return num;
+}
+
+/*
+ * Generate code for a "switch" on a single-trigger operation, with
+ * the cases in order of decreasing profiled calls.  The selectors
+ * are collected in the usual order first, so that each node type
+ * is still matched by its most specific case.
+ */
+static void GenerateProfiledSwitch(TreeCCContext *context,
+								   TreeCCStream *stream,
+								   const TreeCCNonVirtual *nonVirt,
+								   TreeCCOperation *oper)
+{
+	TreeCCParam *param;
+	TreeCCNode *type;
+	TreeCCNode **nodes;
+	TreeCCOperationCase **cases;
+	TreeCCOperationCase *operCase;
+	int *starts;
+	int *order;
+	int num, posn, temp, index;
+	int paramNum, isEnum, useRanges, markBit;
+	TreeCCNode *first, *last;
+
+	/* Find the trigger parameter */
+	param = oper->params;
+	paramNum = 1;
+	while((param->flags & TREECC_PARAM_TRIGGER) == 0)
+	{
+		if(!(param->name))
+		{
+			++paramNum;
+		}
+		param = param->next;
+	}
+	type = TreeCCNodeFindByType(context, param->type);
+	isEnum = ((type->flags & TREECC_NODE_ENUM) != 0);
+	useRanges = (context->kind_ranges && !isEnum &&
+				 nonVirt->genRangeSelector != 0);
+
+	/* Allocate space for the selectors and the case order */
+	nodes = (TreeCCNode **)malloc(sizeof(TreeCCNode *) * context->nodeNumber);
+	cases = (TreeCCOperationCase **)malloc
+			(sizeof(TreeCCOperationCase *) * oper->numCases);
+	starts = (int *)malloc(sizeof(int) * (oper->numCases + 1));
+	order = (int *)malloc(sizeof(int) * oper->numCases);
+	if(!nodes || !cases || !starts || !order)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+
+	/* Collect the selectors for each case */
+	markBit = TREECC_NODE_MARK(0);
+	TreeCCNodeClearMarking(context, markBit);
+	num = 0;
+	index = 0;
+	operCase = oper->firstCase;
+	while(operCase != 0)
+	{
+		cases[index] = operCase;
+		starts[index] = num;
+		num = CollectSelectors(operCase->triggers->node, markBit, nodes, num);
+		if(num == starts[index])
+		{
+			/* We already output code for this with another case */
+			TreeCCErrorOnLine(context->input, operCase->filename,
+							  operCase->linenum,
+							  "this operation case duplicates another");
+		}
+		order[index] = index;
+		++index;
+		operCase = operCase->next;
+	}
+	starts[index] = num;
+
+	/* Sort the cases by decreasing number of calls, keeping the
+	   original order for cases with the same number of calls */
+	for(posn = 1; posn < index; ++posn)
+	{
+		temp = order[posn];
+		num = posn;
+		while(num > 0 && cases[order[num - 1]]->hits < cases[temp]->hits)
+		{
+			order[num] = order[num - 1];
+			--num;
+		}
+		order[num] = temp;
+	}
+
+	/* Generate the head of the switch */
+	if(param->name)
+	{
+		(*(nonVirt->genSwitchHead))(context, stream, param->name, 0, isEnum);
+	}
+	else
+	{
+		char paramName[64];
+		sprintf(paramName, "P%d__", paramNum);
+		(*(nonVirt->genSwitchHead))(context, stream, paramName, 0, isEnum);
+	}
+
+	/* Output the cases in profile order */
+	for(posn = 0; posn < index; ++posn)
+	{
+		temp = order[posn];
+		first = 0;
+		last = 0;
+		for(num = starts[temp]; num < starts[temp + 1]; ++num)
+		{
+			if(!useRanges)
+			{
+				(*(nonVirt->genSelector))(context, stream, nodes[num], 0);
+			}
+			else if(last != 0 && nodes[num]->number == last->number + 1)
+			{
+				last = nodes[num];
+			}
+			else
+			{
+				if(first != 0)
+				{
+					GenerateRun(context, stream, nonVirt, first, last, 0);
+				}
+				first = nodes[num];
+				last = nodes[num];
+			}
+		}
+		if(first != 0)
+		{
+			GenerateRun(context, stream, nonVirt, first, last, 0);
+		}
+		(*(nonVirt->genEndSelectors))(context, stream, 0);
+		GenerateCaseCode(context, stream, nonVirt, cases[temp], 0);
+		(*(nonVirt->genEndCase))(context, stream, 0);
+	}
+
+	/* Generate the end of the switch */
+	(*(nonVirt->genEndSwitch))(context, stream, 0);
+
+	/* Clean up */
+	free(nodes);
+	free(cases);
+	free(starts);
+	free(order);
+}
+
 /*
  * Assign positions to the node types in a non-virtual operation.
  */
@@ -598,16 +1051,30 @@ static void GenerateNonVirtual(TreeCCContext *context,
 	/* Output start declarations for the operation */
 	(*(nonVirt->genStart))(context, stream, oper);
 
-	/* If the operation is not inline, then output functions for all cases */
-	if((oper->flags & TREECC_OPER_INLINE) == 0)
+	/* If the operation is not inline, then output functions for all
+	   cases.  Otherwise output functions for the out of line cases only */
+	number = 1;
+	operCase = oper->firstCase;
+	while(operCase != 0)
 	{
-		number = 1;
-		operCase = oper->firstCase;
-		while(operCase != 0)
+		if(!IsInlineCase(context, operCase))
 		{
 			(*(nonVirt->genCaseFunc))(context, stream, operCase, number);
 			operCase->number = number++;
-			operCase = operCase->next;
+		}
+		operCase = operCase->next;
+	}
+
+	/* Use a dispatch table if requested.  The language may decline,
+	   in which case the operation is dispatched with a "switch" */
+	if(oper->numTriggers >= 1 && context->dispatch_tables &&
+	   nonVirt->genDispatchTable != 0)
+	{
+		AssignTriggerPosns(context, oper);
+		if((*(nonVirt->genDispatchTable))(context, stream, oper))
+		{
+			(*(nonVirt->genEnd))(context, stream, oper);
+			return;
 		}
 	}
 
@@ -629,7 +1096,15 @@ static void GenerateNonVirtual(TreeCCContext *context,
 	/* Generate the switch statement for the outer-most level */
 	if(oper->numTriggers <= 1)
 	{
-		GenerateSwitch(context, stream, nonVirt, oper, oper->firstCase, 0);
+		if(oper->hits != 0)
+		{
+			GenerateProfiledSwitch(context, stream, nonVirt, oper);
+		}
+		else
+		{
+			GenerateSwitch(context, stream, nonVirt, oper,
+						   oper->firstCase, 0);
+		}
 	}
 	else
 	{
@@ -641,10 +1116,119 @@ static void GenerateNonVirtual(TreeCCContext *context,
 	/* Output the exit point for the operation */
 	(*(nonVirt->genExit))(context, stream, oper);
 
+	/* Output the batch entry point for the operation */
+	if(nonVirt->genBatch != 0 && TreeCCIsBatchOperation(context, oper))
+	{
+		(*(nonVirt->genBatch))(context, stream, oper);
+	}
+
 	/* Output the end declarations for the operation */
 	(*(nonVirt->genEnd))(context, stream, oper);
 }
 
+int TreeCCIsBatchOperation(TreeCCContext *context, TreeCCOperation *oper)
+{
+	TreeCCParam *param;
+	TreeCCNode *type;
+	if(!(context->batch_operations) || oper->numTriggers != 1 ||
+	   (oper->flags & (TREECC_OPER_VIRTUAL | TREECC_OPER_MEMOIZE)) != 0)
+	{
+		return 0;
+	}
+
+	/* Inline cases within C++ member functions may refer to "this",
+	   so they cannot be moved out into separate functions */
+	if(context->language == TREECC_LANG_CPP && oper->className &&
+	   (oper->flags & TREECC_OPER_INLINE) != 0)
+	{
+		return 0;
+	}
+
+	/* The trigger must be a node type */
+	param = oper->params;
+	while((param->flags & TREECC_PARAM_TRIGGER) == 0)
+	{
+		param = param->next;
+	}
+	type = TreeCCNodeFindByType(context, param->type);
+	return (type != 0 && (type->flags & TREECC_NODE_ENUM) == 0);
+}
+
+int TreeCCCollectTableKeys(TreeCCNode *node, TreeCCNode **nodes,
+						   int *keys, int count, int isEnum)
+{
+	TreeCCNode *child;
+	int value = 0;
+	if(!isEnum)
+	{
+		nodes[count] = node;
+		keys[count] = node->number;
+		++count;
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		if(!isEnum)
+		{
+			count = TreeCCCollectTableKeys(child, nodes, keys, count, 0);
+		}
+		else if((child->flags & TREECC_NODE_ENUM_VALUE) != 0)
+		{
+			nodes[count] = child;
+			keys[count] = value++;
+			++count;
+		}
+		child = child->nextSibling;
+	}
+	return count;
+}
+
+TreeCCOperationCase *TreeCCFindTableCase(TreeCCOperation *oper,
+										 TreeCCNode **triggers)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *node;
+	int index, multiplier, trigger;
+
+	/* Multiple triggers are looked up in the sorted case table */
+	if(oper->numTriggers > 1)
+	{
+		index = 0;
+		multiplier = 1;
+		trigger = 0;
+		param = oper->params;
+		while(param != 0)
+		{
+			if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+			{
+				index += triggers[trigger]->position * multiplier;
+				multiplier *= param->size;
+				++trigger;
+			}
+			param = param->next;
+		}
+		return oper->sortedCases[index];
+	}
+
+	/* Search up the hierarchy for the case that handles a single trigger */
+	node = triggers[0];
+	while(node != 0)
+	{
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->triggers->node == node)
+			{
+				return operCase;
+			}
+			operCase = operCase->next;
+		}
+		node = node->parent;
+	}
+	return 0;
+}
+
 void TreeCCGenerateNonVirtuals(TreeCCContext *context,
 							   const TreeCCNonVirtual *nonVirt)
 {
@@ -664,6 +1248,38 @@ void TreeCCGenerateNonVirtuals(TreeCCContext *context,
 	}
 }
 
+/*
+ * Output the last kinds for a subtree of node types, in pre-order.
+ */
+static int GenerateLastKinds(TreeCCStream *stream, TreeCCNode *node,
+							 const char *indent, int posn)
+{
+	if((posn % 8) == 0)
+	{
+		TreeCCStreamPrint(stream, "\n%s", indent);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, " ");
+	}
+	TreeCCStreamPrint(stream, "%d,", node->lastNumber);
+	++posn;
+	node = node->firstChild;
+	while(node != 0)
+	{
+		posn = GenerateLastKinds(stream, node, indent, posn);
+		node = node->nextSibling;
+	}
+	return posn;
+}
+
+void TreeCCGenerateLastKinds(TreeCCStream *stream, TreeCCNode *node,
+							 const char *indent)
+{
+	GenerateLastKinds(stream, node, indent, 0);
+	TreeCCStreamPrint(stream, "\n");
+}
+
 #ifdef	__cplusplus
 };
 #endif
@@ -67,6 +67,12 @@ typedef struct
 	void (*genSelector)(TreeCCContext *context, TreeCCStream *stream,
 					    TreeCCNode *node, int level);
 
+	/* Generate a selector for a range of node kinds, from "first" to
+	   "last" inclusive.  This is null if the language has no range
+	   selectors, in which case one selector is generated per kind */
+	void (*genRangeSelector)(TreeCCContext *context, TreeCCStream *stream,
+							 TreeCCNode *first, TreeCCNode *last, int level);
+
 	/* Terminate the selectors and begin the body of a "switch" case */
 	void (*genEndSelectors)(TreeCCContext *context, TreeCCStream *stream,
 						    int level);
@@ -103,6 +109,19 @@ typedef struct
 	void (*genEnd)(TreeCCContext *context, TreeCCStream *stream,
 				   TreeCCOperation *oper);
 
+	/* Generate a table-driven dispatcher for an operation, in place
+	   of nested "switch" statements.  Returns zero if a table cannot
+	   be used for the operation.  This is null if the language
+	   always uses "switch" statements */
+	int (*genDispatchTable)(TreeCCContext *context, TreeCCStream *stream,
+							TreeCCOperation *oper);
+
+	/* Generate a batch entry point for a single-trigger operation, which
+	   groups an array of nodes by case and then runs each case over its
+	   group.  This is null if the language has no batch entry points */
+	void (*genBatch)(TreeCCContext *context, TreeCCStream *stream,
+					 TreeCCOperation *oper);
+
 } TreeCCNonVirtual;
 
 /*
@@ -111,6 +130,62 @@ typedef struct
 void TreeCCGenerateNonVirtuals(TreeCCContext *context,
 							   const TreeCCNonVirtual *nonVirt);
 
+/*
+ * Determine if a batch entry point is generated for an operation.
+ */
+int TreeCCIsBatchOperation(TreeCCContext *context, TreeCCOperation *oper);
+
+/*
+ * Collect the node types in a trigger hierarchy, together with
+ * the key that selects each one in a dispatch table.  Node types
+ * are keyed on their kind, and enumerated values on their value.
+ * Returns the new number of entries in "nodes" and "keys".
+ */
+int TreeCCCollectTableKeys(TreeCCNode *node, TreeCCNode **nodes,
+						   int *keys, int count, int isEnum);
+
+/*
+ * Find the case of an operation that handles a combination of
+ * trigger types, which are listed in parameter order.  The trigger
+ * positions must be assigned if there is more than one trigger.
+ */
+TreeCCOperationCase *TreeCCFindTableCase(TreeCCOperation *oper,
+										 TreeCCNode **triggers);
+
+/*
+ * Generate the elements of an array initializer that holds the
+ * last kind in the subtree of each node type under "node".  The
+ * node kinds must have been numbered in pre-order, so that the
+ * element for a kind is at "kind - node->number".
+ */
+void TreeCCGenerateLastKinds(TreeCCStream *stream, TreeCCNode *node,
+							 const char *indent);
+
+/*
+ * Declare and implement the dispatch counters for
+ * "%option profile_dispatch" in C and C++.
+ */
+void TreeCCDeclareProfile(TreeCCContext *context, TreeCCStream *stream);
+void TreeCCImplementProfile(TreeCCContext *context, TreeCCStream *stream);
+
+/*
+ * Declare and implement the generation counter for the cached
+ * results of "%memoize" operations in C and C++.  If "threadLocal"
+ * is non-zero, then each thread has its own counter, which uses
+ * the "YYNODESTATE_THREAD_LOCAL" storage class.
+ */
+void TreeCCDeclareMemo(TreeCCContext *context, TreeCCStream *stream,
+					   int threadLocal);
+void TreeCCImplementMemo(TreeCCContext *context, TreeCCStream *stream,
+						 int threadLocal);
+
+/*
+ * Declare the batch entry point for "%option batch_operations"
+ * in C and C++, without the storage class.
+ */
+void TreeCCDeclareBatch(TreeCCContext *context, TreeCCStream *stream,
+						TreeCCOperation *oper);
+
 /*
  * Common non-virtual operations that are used for C and C++.
  */
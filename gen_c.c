@@ -22,11 +22,127 @@
 #include "input.h"
 #include "info.h"
 #include "gen.h"
+#include "errors.h"
 
 #ifdef	__cplusplus
 extern	"C" {
 #endif
 
+/*
+ * Determine if allocation statistics should be collected.
+ */
+static int UseNodeStats(TreeCCContext *context)
+{
+	return (context->node_stats && context->use_allocator &&
+			!(context->use_gc_allocator) &&
+			!(context->use_shared_allocator));
+}
+
+/*
+ * Determine if individual nodes can be freed and recycled.
+ */
+static int UseFreeLists(TreeCCContext *context)
+{
+	return (context->free_lists && context->use_allocator &&
+			!(context->use_gc_allocator) &&
+			!(context->use_shared_allocator));
+}
+
+/*
+ * Determine if nodes should be allocated from a pool that can be
+ * shared between threads.
+ */
+static int UseSharedAllocator(TreeCCContext *context)
+{
+	return (context->use_shared_allocator && !(context->use_gc_allocator));
+}
+
+/*
+ * Determine if a virtual operation is dispatched with an inline
+ * "switch" in the header instead of through the vtable.
+ */
+static int IsSwitchDispatch(TreeCCVirtual *virt)
+{
+	return ((virt->oper->flags & TREECC_OPER_DISPATCH_SWITCH) != 0);
+}
+
+/*
+ * Determine if any virtual operation is dispatched with a "switch".
+ */
+static int HaveSwitchDispatch(TreeCCContext *context)
+{
+	unsigned int hash;
+	TreeCCOperation *oper;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		for(oper = context->operHash[hash]; oper != 0; oper = oper->nextHash)
+		{
+			if((oper->flags & TREECC_OPER_VIRTUAL) != 0 &&
+			   (oper->flags & TREECC_OPER_DISPATCH_SWITCH) != 0)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Get the number of operations that are instrumented by
+ * "%option profile_dispatch".
+ */
+static int NumProfiledOperations(TreeCCContext *context)
+{
+	unsigned int hash;
+	TreeCCOperation *oper;
+	int num = 0;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		for(oper = context->operHash[hash]; oper != 0; oper = oper->nextHash)
+		{
+			if(oper->profileIndex >= num)
+			{
+				num = oper->profileIndex + 1;
+			}
+		}
+	}
+	return num;
+}
+
+/*
+ * Output a call that counts a dispatch of a profiled operation
+ * on the node called "name".
+ */
+static void ProfileHit(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCOperation *oper, const char *name)
+{
+	if(context->language == TREECC_LANG_CPP)
+	{
+		TreeCCStreamPrint(stream, "%sprofile_hit__(%d, %s->getKind());",
+						  context->yy_replacement, oper->profileIndex, name);
+	}
+	else if(context->kind_in_vtable)
+	{
+		TreeCCStreamPrint(stream, "%sprofile_hit__(%d, %s->vtable__->kind__);",
+						  context->yy_replacement, oper->profileIndex, name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "%sprofile_hit__(%d, %s->kind__);",
+						  context->yy_replacement, oper->profileIndex, name);
+	}
+}
+
+/*
+ * Determine if a field refers to another node, and so must be
+ * copied when a subtree is cloned.
+ */
+static int IsNodeField(TreeCCContext *context, TreeCCField *field)
+{
+	TreeCCNode *type = TreeCCNodeFindByType(context, field->type);
+	return (type != 0 && (type->flags & TREECC_NODE_ENUM) == 0);
+}
+
 /*
  * Define the node numbers.
  */
@@ -38,6 +154,14 @@ static void DefineNodeNumbers(TreeCCContext *context,
 	{
 		TreeCCStreamPrint(stream, "#define %s_kind %d\n",
 						  node->name, node->number);
+		if(context->kind_ranges)
+		{
+			/* The kinds of the node type and its descendants */
+			TreeCCStreamPrint(stream, "#define %s_first_kind %d\n",
+							  node->name, node->number);
+			TreeCCStreamPrint(stream, "#define %s_last_kind %d\n",
+							  node->name, node->lastNumber);
+		}
 	}
 }
 
@@ -77,6 +201,12 @@ static void DeclareVirtuals(TreeCCContext *context,
 	virt = node->virtuals;
 	while(virt != 0)
 	{
+		if(IsSwitchDispatch(virt))
+		{
+			/* There is no vtable slot for a switch-dispatched virtual */
+			virt = virt->next;
+			continue;
+		}
 		TreeCCStreamPrint(stream, "\t%s (*%s_v__)(%s *this__",
 						  virt->returnType, virt->name, node->name);
 		param = virt->params;
@@ -130,9 +260,16 @@ static void DeclareVirtualMacros(TreeCCContext *context,
 			param = param->next;
 		}
 		TreeCCStreamPrint(stream, ") \\\n");
-		TreeCCStreamPrint(stream,
-			"\t((*(((struct %s_vtable__ *)((this__)->vtable__))->%s_v__)) \\\n",
-			node->name, virt->name);
+		if(IsSwitchDispatch(virt))
+		{
+			TreeCCStreamPrint(stream, "\t(%s_dispatch__ \\\n", virt->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+				"\t((*(((struct %s_vtable__ *)((this__)->vtable__))->%s_v__)) \\\n",
+				node->name, virt->name);
+		}
 		TreeCCStreamPrint(stream, "\t\t((%s *)(this__)", node->name);
 		param = virt->params;
 		num = 1;
@@ -209,9 +346,10 @@ static int DeclareVirtualImpls(TreeCCContext *context, TreeCCStream *stream,
 	while(virt != 0)
 	{
 		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
-		if(!operCase)
+		if(!operCase || IsSwitchDispatch(virt))
 		{
-			/* We don't have a direct implementation in this class */
+			/* We don't have a direct implementation in this class,
+			   or the implementation is inline in the header file */
 			virt = virt->next;
 			continue;
 		}
@@ -470,6 +608,13 @@ static void DeclareNonVirtuals(TreeCCContext *context,
 		TreeCCStreamPrint(stream, "void");
 	}
 	TreeCCStreamPrint(stream, ");\n");
+
+	/* Output the prototype for the batch entry point */
+	if(TreeCCIsBatchOperation(context, oper))
+	{
+		TreeCCStreamPrint(stream, "extern ");
+		TreeCCDeclareBatch(context, stream, oper);
+	}
 }
 
 /*
@@ -527,11 +672,52 @@ static void OutputHelpers(TreeCCContext *context)
 	TreeCCStreamPrint(stream,
 			"#define %sisa(node__,type__) \\\n",
    			context->yy_replacement);
-	TreeCCStreamPrint(stream,
-		"\t(%sisa__((node__)->vtable__, (type__##_kind)))\n",
-		context->yy_replacement);
+	if(context->kind_ranges)
+	{
+		/* The kinds of a type's descendants form an interval, so
+		   the test is a single unsigned comparison on the kind */
+		TreeCCStreamPrint(stream,
+			"\t((unsigned int)((node__)->%skind__ - type__##_first_kind) <= \\\n",
+			(context->kind_in_vtable ? "vtable__->" : ""));
+		TreeCCStreamPrint(stream,
+			"\t (unsigned int)(type__##_last_kind - type__##_first_kind))\n");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+			"\t(%sisa__((node__)->vtable__, (type__##_kind)))\n",
+			context->yy_replacement);
+	}
 	TreeCCStreamPrint(stream, "#endif\n\n");
 
+	/* Storage class for per-thread non-reentrant state, or for
+	   the per-thread chunks of the shared allocator */
+	if((context->thread_local_state && !(context->reentrant)) ||
+	   UseSharedAllocator(context))
+	{
+		TreeCCStreamPrint(stream, "#ifndef %s_THREAD_LOCAL\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#if defined(__cplusplus) && "
+								  "__cplusplus >= 201103L\n");
+		TreeCCStreamPrint(stream, "#define %s_THREAD_LOCAL thread_local\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#elif !defined(__cplusplus) && "
+								  "defined(__STDC_VERSION__) && "
+								  "__STDC_VERSION__ >= 201112L\n");
+		TreeCCStreamPrint(stream,
+						  "#define %s_THREAD_LOCAL _Thread_local\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#elif defined(_MSC_VER)\n");
+		TreeCCStreamPrint(stream,
+						  "#define %s_THREAD_LOCAL __declspec(thread)\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#else\n");
+		TreeCCStreamPrint(stream, "#define %s_THREAD_LOCAL __thread\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#endif\n");
+		TreeCCStreamPrint(stream, "#endif\n\n");
+	}
+
 	/* Are we tracking line numbers? */
 	if(context->track_lines)
 	{
@@ -601,8 +787,10 @@ static void OutputHelpers(TreeCCContext *context)
 		TreeCCStreamPrint(stream, "#endif\n\n");
 	}
 
-	/* Declare the "yynodealloc", "yynodepush", "yynodepop", and
-	   "yynodeclear", and "yynodefailed" functions */
+	/* Declare the "yynodealloc", "yynodepush", "yynodepop",
+	   "yynodemark", "yynoderollback", "yynodecommit", "yynodeadopt",
+	   "yynodeclear", "yynodetrim", "yynodefailed", "yynodestats",
+	   "yynodedealloc", and "yynodefree" functions */
 	TreeCCStreamPrint(stream, "#ifndef %snodeops_declared\n",
 					  context->yy_replacement);
 	TreeCCStreamPrint(stream, "extern void %snodeinit(",
@@ -646,6 +834,38 @@ static void OutputHelpers(TreeCCContext *context)
 		TreeCCStreamPrint(stream, "void");
 	}
 	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream, "extern %s_mark %snodemark(",
+					  context->state_type, context->yy_replacement);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "%s *state__", context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "void");
+	}
+	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream, "extern void %snoderollback(",
+					  context->yy_replacement);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "%s *state__, ", context->state_type);
+	}
+	TreeCCStreamPrint(stream, "%s_mark mark__);\n", context->state_type);
+	TreeCCStreamPrint(stream, "extern void %snodecommit(",
+					  context->yy_replacement);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "%s *state__, ", context->state_type);
+	}
+	TreeCCStreamPrint(stream, "%s_mark mark__);\n", context->state_type);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+				"extern void %snodeadopt(%s *state__, %s *src__);\n",
+				context->yy_replacement, context->state_type,
+				context->state_type);
+	}
 	TreeCCStreamPrint(stream, "extern void %snodeclear(",
 					  context->yy_replacement);
 	if(context->reentrant)
@@ -657,6 +877,17 @@ static void OutputHelpers(TreeCCContext *context)
 		TreeCCStreamPrint(stream, "void");
 	}
 	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream, "extern void %snodetrim(",
+					  context->yy_replacement);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "%s *state__", context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "void");
+	}
+	TreeCCStreamPrint(stream, ");\n");
 	TreeCCStreamPrint(stream, "extern void %snodefailed(",
 					  context->yy_replacement);
 	if(context->reentrant)
@@ -668,88 +899,218 @@ static void OutputHelpers(TreeCCContext *context)
 		TreeCCStreamPrint(stream, "void");
 	}
 	TreeCCStreamPrint(stream, ");\n");
+	if(UseNodeStats(context))
+	{
+		TreeCCStreamPrint(stream, "extern const %s_stats *%snodestats(",
+						  context->state_type, context->yy_replacement);
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream, "%s *state__", context->state_type);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "void");
+		}
+		TreeCCStreamPrint(stream, ");\n");
+		TreeCCStreamPrint(stream, "extern void %snodecount__(",
+						  context->yy_replacement);
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream, "%s *state__, ", context->state_type);
+		}
+		TreeCCStreamPrint(stream, "int kind__, unsigned int size__);\n");
+	}
+	if(UseFreeLists(context))
+	{
+		TreeCCStreamPrint(stream, "extern void %snodedealloc(",
+						  context->yy_replacement);
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream, "%s *state__, ", context->state_type);
+		}
+		TreeCCStreamPrint(stream, "void *ptr__, unsigned int size__);\n");
+		TreeCCStreamPrint(stream, "extern void %snodefree__(",
+						  context->yy_replacement);
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream, "%s *state__, ", context->state_type);
+		}
+		TreeCCStreamPrint(stream, "const void *vtable__, void *node__);\n");
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream,
+				"#define %snodefree(state__,node__) \\\n",
+				context->yy_replacement);
+			TreeCCStreamPrint(stream,
+				"\t(%snodefree__((state__), (node__)->vtable__, "
+						"(void *)(node__)))\n",
+				context->yy_replacement);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+				"#define %snodefree(node__) \\\n",
+				context->yy_replacement);
+			TreeCCStreamPrint(stream,
+				"\t(%snodefree__((node__)->vtable__, (void *)(node__)))\n",
+				context->yy_replacement);
+		}
+	}
 	TreeCCStreamPrint(stream, "#define %snodeops_declared 1\n",
 					  context->yy_replacement);
 	TreeCCStreamPrint(stream, "#endif\n\n");
+
+	/* yyclone macro */
+	if(context->clone_nodes)
+	{
+		TreeCCStreamPrint(stream, "#ifndef %sclone\n",
+						  context->yy_replacement);
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream,
+				"extern void *%sclone__(%s *state__, const void *node__);\n",
+				context->yy_replacement, context->state_type);
+			TreeCCStreamPrint(stream,
+				"#define %sclone(state__,node__) \\\n",
+				context->yy_replacement);
+			TreeCCStreamPrint(stream,
+				"\t(%sclone__((state__), (const void *)(node__)))\n",
+				context->yy_replacement);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+				"extern void *%sclone__(const void *node__);\n",
+				context->yy_replacement);
+			TreeCCStreamPrint(stream,
+				"#define %sclone(node__) "
+						"(%sclone__((const void *)(node__)))\n",
+				context->yy_replacement, context->yy_replacement);
+		}
+		TreeCCStreamPrint(stream, "#endif\n\n");
+	}
+
+	/* Storage class for switch-dispatched virtuals in the header */
+	if(HaveSwitchDispatch(context))
+	{
+		TreeCCStreamPrint(stream, "#ifndef %sinline\n",
+						  context->yy_replacement);
+		TreeCCStreamPrint(stream, "#if defined(__cplusplus) || "
+						  "(defined(__STDC_VERSION__) && "
+						  "__STDC_VERSION__ >= 199901L)\n");
+		TreeCCStreamPrint(stream, "#define %sinline inline\n",
+						  context->yy_replacement);
+		TreeCCStreamPrint(stream, "#elif defined(__GNUC__)\n");
+		TreeCCStreamPrint(stream, "#define %sinline __inline__\n",
+						  context->yy_replacement);
+		TreeCCStreamPrint(stream, "#else\n");
+		TreeCCStreamPrint(stream, "#define %sinline\n",
+						  context->yy_replacement);
+		TreeCCStreamPrint(stream, "#endif\n");
+		TreeCCStreamPrint(stream, "#endif\n\n");
+	}
 }
 
 /*
- * Output the vtable function implementations for a node type.
+ * Output the implementation of a single virtual method case.
  */
-static void OutputVtableImpls(TreeCCContext *context, TreeCCStream *stream,
-							  TreeCCNode *node, TreeCCNode *actualNode)
+static void OutputVirtualCase(TreeCCContext *context, TreeCCStream *stream,
+							  TreeCCVirtual *virt, TreeCCOperationCase *operCase,
+							  TreeCCNode *actualNode, const char *prefix)
 {
-	TreeCCVirtual *virt;
 	TreeCCParam *param;
-	TreeCCOperationCase *operCase;
 	TreeCCOperation *oper;
 	int num;
 	int needComma;
-	if(node->parent)
-	{
-		OutputVtableImpls(context, stream, node->parent, actualNode);
-	}
-	virt = node->virtuals;
-	while(virt != 0)
+	TreeCCStreamPrint(stream, "%s%s %s_%s__(", prefix,
+					  virt->returnType, actualNode->name, virt->name);
+	oper = operCase->oper;
+	param = oper->params;
+	needComma = 0;
+	num = 1;
+	while(param != 0)
 	{
-		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
-		if(!operCase)
+		if(needComma)
 		{
-			/* We don't have a direct implementation in this class */
-			virt = virt->next;
-			continue;
+			TreeCCStreamPrint(stream, ", ");
 		}
-		TreeCCStreamPrint(stream, "%s %s_%s__(",
-						  virt->returnType, actualNode->name, virt->name);
-		oper = operCase->oper;
-		param = oper->params;
-		needComma = 0;
-		num = 1;
-		while(param != 0)
+		if(!needComma)
 		{
-			if(needComma)
-			{
-				TreeCCStreamPrint(stream, ", ");
-			}
-			if(!needComma)
+			/* First argument must be declared with the actual type */
+			if(param->name)
 			{
-				/* First argument must be declared with the actual type */
-				if(param->name)
-				{
-					TreeCCStreamPrint(stream, "%s *%s",
-									  actualNode->name, param->name);
-				}
-				else
-				{
-					TreeCCStreamPrint(stream, "%s *P%d__",
-									  actualNode->name, num);
-					++num;
-				}
+				TreeCCStreamPrint(stream, "%s *%s",
+								  actualNode->name, param->name);
 			}
 			else
 			{
-				if(param->name)
-				{
-					TreeCCStreamPrint(stream, "%s %s",
-									  param->type, param->name);
-				}
-				else
-				{
-					TreeCCStreamPrint(stream, "%s P%d__",
-									  param->type, num);
-					++num;
-				}
+				TreeCCStreamPrint(stream, "%s *P%d__",
+								  actualNode->name, num);
+				++num;
 			}
-			needComma = 1;
-			param = param->next;
 		}
-		TreeCCStreamPrint(stream, ")\n");
-		TreeCCStreamLine(stream, operCase->codeLinenum, operCase->codeFilename);
-		TreeCCStreamPrint(stream, "{");
-		TreeCCStreamCode(stream, operCase->code);
-		TreeCCStreamPrint(stream, "}\n");
-		TreeCCStreamFixLine(stream);
-		TreeCCStreamPrint(stream, "\n");
+		else
+		{
+			if(param->name)
+			{
+				TreeCCStreamPrint(stream, "%s %s",
+								  param->type, param->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "%s P%d__",
+								  param->type, num);
+				++num;
+			}
+		}
+		needComma = 1;
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, ")\n");
+	TreeCCStreamLine(stream, operCase->codeLinenum, operCase->codeFilename);
+	TreeCCStreamPrint(stream, "{");
+	if(oper->profileIndex >= 0)
+	{
+		/* Count the call on the same line, to keep the line numbers */
+		if(oper->params->name)
+		{
+			ProfileHit(context, stream, oper, oper->params->name);
+		}
+		else
+		{
+			ProfileHit(context, stream, oper, "P1__");
+		}
+	}
+	TreeCCStreamCode(stream, operCase->code);
+	TreeCCStreamPrint(stream, "}\n");
+	TreeCCStreamFixLine(stream);
+	TreeCCStreamPrint(stream, "\n");
+}
+
+/*
+ * Output the vtable function implementations for a node type.
+ */
+static void OutputVtableImpls(TreeCCContext *context, TreeCCStream *stream,
+							  TreeCCNode *node, TreeCCNode *actualNode)
+{
+	TreeCCVirtual *virt;
+	TreeCCOperationCase *operCase;
+	if(node->parent)
+	{
+		OutputVtableImpls(context, stream, node->parent, actualNode);
+	}
+	virt = node->virtuals;
+	while(virt != 0)
+	{
+		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
+		if(!operCase || IsSwitchDispatch(virt))
+		{
+			/* We don't have a direct implementation in this class,
+			   or the implementation is inline in the header file */
+			virt = virt->next;
+			continue;
+		}
+		OutputVirtualCase(context, stream, virt, operCase, actualNode, "");
 		virt = virt->next;
 	}
 }
@@ -772,6 +1133,12 @@ static void OutputVtableFuncs(TreeCCContext *context, TreeCCStream *stream,
 	virt = node->virtuals;
 	while(virt != 0)
 	{
+		if(IsSwitchDispatch(virt))
+		{
+			/* There is no vtable slot for a switch-dispatched virtual */
+			virt = virt->next;
+			continue;
+		}
 		TreeCCStreamPrint(stream, "\t(%s (*)(%s *this__",
 						  virt->returnType, node->name);
 		param = virt->params;
@@ -817,6 +1184,226 @@ static void OutputVtableFuncs(TreeCCContext *context, TreeCCStream *stream,
 	}
 }
 
+/*
+ * Print the parameters of a switch-dispatched virtual, declaring
+ * the first with the type "node", or print the call arguments.
+ */
+static void SwitchDispatchParams(TreeCCContext *context, TreeCCStream *stream,
+								 TreeCCOperation *oper, TreeCCNode *node,
+								 int isCall)
+{
+	TreeCCParam *param;
+	int num;
+	param = oper->params;
+	num = 1;
+	while(param != 0)
+	{
+		if(param != oper->params)
+		{
+			TreeCCStreamPrint(stream, ", ");
+			if(!isCall)
+			{
+				TreeCCStreamPrint(stream, "%s ", param->type);
+			}
+		}
+		else if(isCall)
+		{
+			TreeCCStreamPrint(stream, "(%s *)", node->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "%s *", node->name);
+		}
+		if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s", param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "P%d__", num);
+			++num;
+		}
+		param = param->next;
+	}
+}
+
+/*
+ * Declare the inline "switch" functions for the switch-dispatched
+ * virtuals in a node type, so that cases may call each other.
+ */
+static void DeclareSwitchVirtuals(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCVirtual *virt;
+	for(virt = node->virtuals; virt != 0; virt = virt->next)
+	{
+		if(IsSwitchDispatch(virt))
+		{
+			TreeCCStreamPrint(node->header, "static %sinline %s %s_dispatch__(",
+							  context->yy_replacement, virt->returnType,
+							  virt->name);
+			SwitchDispatchParams(context, node->header, virt->oper, node, 0);
+			TreeCCStreamPrint(node->header, ");\n");
+		}
+	}
+}
+
+/*
+ * Output the "case" labels for the node types that inherit the
+ * implementation of a switch-dispatched virtual from "node".
+ */
+static int SwitchDispatchLabels(TreeCCContext *context, TreeCCStream *stream,
+								TreeCCVirtual *virt, TreeCCNode *node)
+{
+	TreeCCNode *child;
+	int numLabels = 0;
+	if((node->flags & TREECC_NODE_ABSTRACT) == 0)
+	{
+		TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+		++numLabels;
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		if(!TreeCCOperationFindCase(context, child, virt->name))
+		{
+			numLabels += SwitchDispatchLabels(context, stream, virt, child);
+		}
+		child = child->nextSibling;
+	}
+	return numLabels;
+}
+
+/*
+ * Output the "switch" cases that call the implementations of a
+ * switch-dispatched virtual for a node type hierarchy.
+ */
+static void SwitchDispatchCases(TreeCCContext *context, TreeCCStream *stream,
+								TreeCCVirtual *virt, TreeCCNode *node,
+								int *needDefault)
+{
+	TreeCCNode *child;
+	if(TreeCCOperationFindCase(context, node, virt->name))
+	{
+		if(SwitchDispatchLabels(context, stream, virt, node) > 0)
+		{
+			/* The first case also handles unknown kinds if there
+			   is no default value to return for them */
+			if(*needDefault)
+			{
+				TreeCCStreamPrint(stream, "\t\tdefault:\n");
+				*needDefault = 0;
+			}
+			TreeCCStreamPrint(stream, "\t\t\t");
+			if(strcmp(virt->returnType, "void") != 0)
+			{
+				TreeCCStreamPrint(stream, "return ");
+			}
+			TreeCCStreamPrint(stream, "%s_%s__(", node->name, virt->name);
+			SwitchDispatchParams(context, stream, virt->oper, node, 1);
+			TreeCCStreamPrint(stream, ");\n");
+			if(!strcmp(virt->returnType, "void"))
+			{
+				TreeCCStreamPrint(stream, "\t\t\tbreak;\n");
+			}
+			TreeCCStreamPrint(stream, "\n");
+		}
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		SwitchDispatchCases(context, stream, virt, child, needDefault);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Output the implementations of the cases of a switch-dispatched
+ * virtual for a node type hierarchy.
+ */
+static void ImplementSwitchVirtualCases(TreeCCContext *context,
+										TreeCCStream *stream,
+										TreeCCVirtual *virt, TreeCCNode *node)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCNode *child;
+	char prefix[64];
+	operCase = TreeCCOperationFindCase(context, node, virt->name);
+	if(operCase)
+	{
+		sprintf(prefix, "static %.40sinline ", context->yy_replacement);
+		OutputVirtualCase(context, stream, virt, operCase, node, prefix);
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		ImplementSwitchVirtualCases(context, stream, virt, child);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Implement the switch-dispatched virtuals that are declared in a
+ * node type.  The definitions are inline in the header, so that
+ * small operations can be inlined into their callers.
+ */
+static void ImplementSwitchVirtuals(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream = node->header;
+	TreeCCVirtual *virt;
+	const char *thisName;
+	int needDefault;
+	virt = node->virtuals;
+	while(virt != 0)
+	{
+		if(!IsSwitchDispatch(virt))
+		{
+			virt = virt->next;
+			continue;
+		}
+
+		/* Output the implementations of the cases */
+		ImplementSwitchVirtualCases(context, stream, virt, node);
+
+		/* Output the entry point, which switches on the node kind */
+		TreeCCStreamPrint(stream, "static %sinline %s %s_dispatch__(",
+						  context->yy_replacement, virt->returnType,
+						  virt->name);
+		SwitchDispatchParams(context, stream, virt->oper, node, 0);
+		TreeCCStreamPrint(stream, ")\n{\n");
+		thisName = (virt->oper->params->name ?
+						virt->oper->params->name : "P1__");
+		if(context->kind_in_vtable)
+		{
+			TreeCCStreamPrint(stream, "\tswitch(%s->vtable__->kind__)\n\t{\n",
+							  thisName);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\tswitch(%s->kind__)\n\t{\n", thisName);
+		}
+		needDefault = (strcmp(virt->returnType, "void") != 0 &&
+					   virt->oper->defValue == 0);
+		SwitchDispatchCases(context, stream, virt, node, &needDefault);
+		if(strcmp(virt->returnType, "void") == 0 || virt->oper->defValue)
+		{
+			TreeCCStreamPrint(stream, "\t\tdefault: break;\n");
+		}
+		TreeCCStreamPrint(stream, "\t}\n");
+		if(virt->oper->defValue)
+		{
+			TreeCCStreamPrint(stream, "\treturn (%s);\n",
+							  virt->oper->defValue);
+		}
+		else if(needDefault)
+		{
+			/* There are no implementations at all */
+			TreeCCStreamPrint(stream, "\treturn 0;\n");
+		}
+		TreeCCStreamPrint(stream, "}\n\n");
+		virt = virt->next;
+	}
+}
+
 /*
  * Define a vtable for a node type.
  */
@@ -993,6 +1580,23 @@ static void ImplementCreateFuncs(TreeCCContext *context,
 		/* Bail out to the caller if "yynodealloc" returned NULL */
 		TreeCCStreamPrint(stream, "\tif(node__ == 0) return 0;\n");
 
+		/* Count the node for the allocation statistics */
+		if(UseNodeStats(context))
+		{
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream,
+					"\t%snodecount__(state__, %s_kind, sizeof(struct %s__));\n",
+					context->yy_replacement, node->name, node->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+					"\t%snodecount__(%s_kind, sizeof(struct %s__));\n",
+					context->yy_replacement, node->name, node->name);
+			}
+		}
+
 		/* Set the vtable and kind */
 		TreeCCStreamPrint(stream, "\tnode__->vtable__ = &%s_vt__;\n",
 						  node->name);
@@ -1036,6 +1640,86 @@ static void ImplementCreateFuncs(TreeCCContext *context,
 	TreeCCStreamPrint(stream, "}\n\n");
 }
 
+/*
+ * Output the "yyisa__" helper function for pre-order node kinds.
+ * The descendants of a node type have the kinds "kind__" to
+ * "yykind_last__[kind__]" inclusive.
+ */
+static void OutputKindRangeIsA(TreeCCContext *context, TreeCCStream *stream)
+{
+	unsigned int hash;
+	TreeCCNode *node;
+	int first, posn;
+	int *last;
+
+	/* Build the table of the last kind in each subtree */
+	first = context->nodeNumber;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		node = context->nodeHash[hash];
+		while(node != 0)
+		{
+			if(node->number < first)
+			{
+				first = node->number;
+			}
+			node = node->nextHash;
+		}
+	}
+	if(first >= context->nodeNumber)
+	{
+		first = context->nodeNumber - 1;
+	}
+	last = (int *)calloc(context->nodeNumber - first, sizeof(int));
+	if(!last)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		node = context->nodeHash[hash];
+		while(node != 0)
+		{
+			last[node->number - first] = node->lastNumber;
+			node = node->nextHash;
+		}
+	}
+
+	/* Output the table */
+	TreeCCStreamPrint(stream, "static const int %skind_last__[%d] = {",
+					  context->yy_replacement, context->nodeNumber - first);
+	for(posn = 0; posn < (context->nodeNumber - first); ++posn)
+	{
+		if((posn % 8) == 0)
+		{
+			TreeCCStreamPrint(stream, "\n\t");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, " ");
+		}
+		TreeCCStreamPrint(stream, "%d,", last[posn]);
+	}
+	TreeCCStreamPrint(stream, "\n};\n\n");
+	free(last);
+
+	/* Output the function */
+	TreeCCStreamPrint(stream,
+		"int %sisa__(const void *vtable__, int kind__)\n",
+		context->yy_replacement);
+	TreeCCStreamPrint(stream, "{\n");
+	TreeCCStreamPrint(stream, "\tint kind;\n");
+	TreeCCStreamPrint(stream,
+		"\tkind = ((const struct %s_vtable__ *)vtable__)->kind__;\n",
+		context->yy_replacement);
+	TreeCCStreamPrint(stream,
+		"\treturn (kind__ >= %d && kind__ <= kind &&\n", first);
+	TreeCCStreamPrint(stream,
+		"\t        kind <= %skind_last__[kind__ - %d]);\n",
+		context->yy_replacement, first);
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
 /*
  * Output the source code for the "yyisa__" helper function.
  */
@@ -1061,6 +1745,13 @@ static void OutputIsA(TreeCCContext *context)
 	TreeCCStreamPrint(stream, "\tint kind__;\n");
 	TreeCCStreamPrint(stream, "};\n\n");
 
+	/* With pre-order kinds, compare against the end of the interval */
+	if(context->kind_ranges)
+	{
+		OutputKindRangeIsA(context, stream);
+		return;
+	}
+
 	/* Output the function header */
 	TreeCCStreamPrint(stream,
 		"int %sisa__(const void *vtable__, int kind__)\n",
@@ -1107,29 +1798,15 @@ static void C_GenStart(TreeCCContext *context, TreeCCStream *stream,
 }
 
 /*
- * Generate the entry point for a non-virtual operation.
+ * Generate the parameter list for the entry point of
+ * a non-virtual operation.
  */
-static void CGenEntry(TreeCCContext *context, TreeCCStream *stream,
-					  TreeCCOperation *oper, int number)
+static void CGenParams(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCOperation *oper)
 {
 	TreeCCParam *param;
 	int num;
 	int needComma;
-	if(number != -1)
-	{
-		TreeCCStreamPrint(stream, "%s %s_split_%d__(",
-						  oper->returnType, oper->name, number);
-	}
-	else if(context->language == TREECC_LANG_C || !(oper->className))
-	{
-		TreeCCStreamPrint(stream, "%s %s(",
-						  oper->returnType, oper->name);
-	}
-	else
-	{
-		TreeCCStreamPrint(stream, "%s %s::%s(",
-						  oper->returnType, oper->className, oper->name);
-	}
 	param = oper->params;
 	num = 1;
 	needComma = 0;
@@ -1163,26 +1840,93 @@ static void CGenEntry(TreeCCContext *context, TreeCCStream *stream,
 	{
 		TreeCCStreamPrint(stream, "void");
 	}
-	TreeCCStreamPrint(stream, ")\n");
-	TreeCCStreamPrint(stream, "{\n");
-}
-
-/*
- * Generate the entry point for a split-out function.
- */
-static void C_GenSplitEntry(TreeCCContext *context, TreeCCStream *stream,
-					        TreeCCOperation *oper, int number)
-{
-	CGenEntry(context, stream, oper, number);
+	TreeCCStreamPrint(stream, ")");
 }
 
 /*
  * Generate the entry point for a non-virtual operation.
  */
-static void C_GenEntry(TreeCCContext *context, TreeCCStream *stream,
-					   TreeCCOperation *oper)
+static void CGenEntry(TreeCCContext *context, TreeCCStream *stream,
+					  TreeCCOperation *oper, int number)
 {
-	CGenEntry(context, stream, oper, -1);
+	if(number != -1)
+	{
+		TreeCCStreamPrint(stream, "%s %s_split_%d__(",
+						  oper->returnType, oper->name, number);
+	}
+	else if((oper->flags & TREECC_OPER_MEMOIZE) != 0)
+	{
+		/* The result is computed by a helper that is called from
+		   the memoizing entry point that "C_GenEnd" outputs */
+		if(context->language == TREECC_LANG_C || !(oper->className))
+		{
+			TreeCCStreamPrint(stream, "static %s %s_compute__(",
+							  oper->returnType, oper->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "%s %s::%s_compute__(",
+							  oper->returnType, oper->className, oper->name);
+		}
+	}
+	else if(context->language == TREECC_LANG_C || !(oper->className))
+	{
+		TreeCCStreamPrint(stream, "%s %s(",
+						  oper->returnType, oper->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "%s %s::%s(",
+						  oper->returnType, oper->className, oper->name);
+	}
+	CGenParams(context, stream, oper);
+	TreeCCStreamPrint(stream, "\n");
+	TreeCCStreamPrint(stream, "{\n");
+	if(number == -1 && oper->profileIndex >= 0 &&
+	   (oper->flags & TREECC_OPER_VIRTUAL) == 0)
+	{
+		/* Count the call against the kind of the trigger parameter */
+		TreeCCParam *param = oper->params;
+		char name[64];
+		int num = 1;
+		while((param->flags & TREECC_PARAM_TRIGGER) == 0)
+		{
+			if(!(param->name))
+			{
+				++num;
+			}
+			param = param->next;
+		}
+		if(param->name)
+		{
+			sprintf(name, "%.60s__", param->name);
+		}
+		else
+		{
+			sprintf(name, "P%d____", num);
+		}
+		TreeCCStreamPrint(stream, "\t");
+		ProfileHit(context, stream, oper, name);
+		TreeCCStreamPrint(stream, "\n");
+	}
+}
+
+/*
+ * Generate the entry point for a split-out function.
+ */
+static void C_GenSplitEntry(TreeCCContext *context, TreeCCStream *stream,
+					        TreeCCOperation *oper, int number)
+{
+	CGenEntry(context, stream, oper, number);
+}
+
+/*
+ * Generate the entry point for a non-virtual operation.
+ */
+static void C_GenEntry(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCOperation *oper)
+{
+	CGenEntry(context, stream, oper, -1);
 }
 
 /*
@@ -1572,178 +2316,1424 @@ static void C_GenExit(TreeCCContext *context, TreeCCStream *stream,
 static void C_GenEnd(TreeCCContext *context, TreeCCStream *stream,
 					 TreeCCOperation *oper)
 {
-	/* Nothing to do here for C and C++ */
+	const char *yy = context->yy_replacement;
+	const char *name;
+
+	/* Output the memoizing entry point, which only calls the helper
+	   if the cached result is from an earlier generation */
+	if((oper->flags & TREECC_OPER_MEMOIZE) == 0)
+	{
+		return;
+	}
+	if(context->language == TREECC_LANG_C || !(oper->className))
+	{
+		TreeCCStreamPrint(stream, "%s %s(", oper->returnType, oper->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "%s %s::%s(",
+						  oper->returnType, oper->className, oper->name);
+	}
+	CGenParams(context, stream, oper);
+	TreeCCStreamPrint(stream, "\n{\n");
+	name = (oper->params->name ? oper->params->name : "P1__");
+	TreeCCStreamPrint(stream,
+			"\tif(%s__->%s_memogen__ != %smemo_generation__)\n\t{\n",
+			name, oper->name, yy);
+	TreeCCStreamPrint(stream, "\t\t%s__->%s_memo__ = %s_compute__(%s__);\n",
+					  name, oper->name, oper->name, name);
+	TreeCCStreamPrint(stream,
+			"\t\t%s__->%s_memogen__ = %smemo_generation__;\n\t}\n",
+			name, oper->name, yy);
+	TreeCCStreamPrint(stream, "\treturn %s__->%s_memo__;\n}\n\n",
+					  name, oper->name);
 }
 
 /*
- * Table of non-virtual code generation functions.
+ * Determine the range of kind values within a node type hierarchy.
  */
-TreeCCNonVirtual const TreeCCNonVirtualFuncsC = {
-	C_GenStart,
-	C_GenEntry,
-	C_GenSplitEntry,
-	C_GenSwitchHead,
-	C_GenSelector,
-	C_GenEndSelectors,
-	C_GenCaseFunc,
-	C_GenCaseCall,
-	C_GenCaseInline,
-	C_GenCaseSplit,
-	C_GenEndCase,
-	C_GenEndSwitch,
-	C_GenExit,
-	C_GenEnd,
-};
+static void KindBounds(TreeCCNode *node, int *min, int *max)
+{
+	if(node->number < *min)
+	{
+		*min = node->number;
+	}
+	if(node->number > *max)
+	{
+		*max = node->number;
+	}
+	node = node->firstChild;
+	while(node != 0)
+	{
+		KindBounds(node, min, max);
+		node = node->nextSibling;
+	}
+}
 
 /*
- * Write out header information for all streams.
+ * Fill in the kind-to-index map for a node type hierarchy.
  */
-static void WriteHeaders(TreeCCContext *context)
+static void FillKindMap(TreeCCNode *node, int *map, int min, int multiplier)
 {
-	TreeCCStream *stream = context->streamList;
-	while(stream != 0)
+	map[node->number - min] = node->position * multiplier;
+	node = node->firstChild;
+	while(node != 0)
 	{
-		if(stream->isHeader)
-		{
-			TreeCCStreamHeaderTop(stream);
-			TreeCCStreamPrint(stream, "\n");
-			TreeCCStreamPrint(stream, "#ifdef __cplusplus\n");
-			TreeCCStreamPrint(stream, "extern \"C\" {\n");
-			TreeCCStreamPrint(stream, "#endif\n");
-			TreeCCStreamPrint(stream, "\n");
-		}
-		else
-		{
-			TreeCCStreamSourceTop(stream);
-			TreeCCStreamPrint(stream, "\n");
-		}
-		if(stream->defaultFile)
-		{
-			/* Reset the dirty flag if this is a default stream,
-			   because we don't want to write out the final file
-			   if it isn't actually written to in practice */
-			stream->dirty = 0;
-		}
-		stream = stream->nextStream;
+		FillKindMap(node, map, min, multiplier);
+		node = node->nextSibling;
 	}
 }
 
 /*
- * Write out footer information for all streams.
+ * Generate the arguments to pass from the entry point of a
+ * non-virtual operation to one of its dispatch table entries.
  */
-static void WriteFooters(TreeCCContext *context)
+static void CGenArgs(TreeCCContext *context, TreeCCStream *stream,
+					 TreeCCOperation *oper)
 {
-	TreeCCStream *stream = context->streamList;
-	while(stream != 0)
+	TreeCCParam *param;
+	int num;
+	int needComma;
+	param = oper->params;
+	num = 1;
+	needComma = 0;
+	while(param != 0)
 	{
-		if(stream->defaultFile && !(stream->dirty))
+		if(needComma)
 		{
-			/* Clear the default file's contents, which we don't need */
-			TreeCCStreamClear(stream);
+			TreeCCStreamPrint(stream, ", ");
 		}
-		else if(stream->isHeader)
+		if(param->name)
 		{
-			TreeCCStreamPrint(stream, "#ifdef __cplusplus\n");
-			TreeCCStreamPrint(stream, "};\n");
-			TreeCCStreamPrint(stream, "#endif\n");
-			TreeCCStreamPrint(stream, "\n");
-			TreeCCStreamHeaderBottom(stream);
+			TreeCCStreamPrint(stream, "%s", param->name);
 		}
 		else
 		{
-			TreeCCStreamSourceBottom(stream);
+			TreeCCStreamPrint(stream, "P%d__", num);
+			++num;
 		}
-		stream = stream->nextStream;
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			if(!IsEnumType(context, param->type))
+			{
+				TreeCCStreamPrint(stream, "__");
+			}
+		}
+		needComma = 1;
+		param = param->next;
 	}
 }
 
 /*
- * Write the skeleton for the node memory manager to a source stream.
+ * Generate a table-driven dispatcher for a multi-trigger operation.
+ * Each trigger is mapped to its contribution to the index of the
+ * flattened "sortedCases" array, and the sum is used to select
+ * a function with the generic signature of the operation.
  */
-static void WriteSourceSkeleton(TreeCCContext *context, TreeCCStream *stream)
+static int C_GenDispatchTable(TreeCCContext *context, TreeCCStream *stream,
+							  TreeCCOperation *oper)
 {
-	if(context->block_size)
-	{
-		TreeCCStreamPrint(stream, "#define %s_BLKSIZ %d\n",
-						  context->state_type, context->block_size);
-	}
-	if(context->reentrant)
-	{
-		TreeCCStreamPrint(stream, "#define %s_REENTRANT 1\n",
-						  context->state_type);
-	}
-	if(context->track_lines)
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	int total, index, number, num;
+	int multiplier, trigger, min, max;
+	int needDefault;
+	int *map;
+
+	/* A "switch" on a single trigger is already a table jump */
+	if(oper->numTriggers < 2)
 	{
-		TreeCCStreamPrint(stream, "#define %s_TRACK_LINES 1\n",
-						  context->state_type);
+		return 0;
 	}
-	if(context->use_gc_allocator)
+
+	/* Inline cases within member functions may refer to "this",
+	   so they cannot be moved out into separate functions */
+	if(context->language == TREECC_LANG_CPP && oper->className &&
+	   (oper->flags & TREECC_OPER_INLINE) != 0)
 	{
-		TreeCCIncludeSkeleton(context, stream, "c_gc_skel.c");
+		return 0;
 	}
-	else
+
+	/* Determine the size of the table */
+	total = 1;
+	param = oper->params;
+	while(param != 0)
 	{
-		TreeCCIncludeSkeleton(context, stream, "c_skel.c");
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			total *= param->size;
+		}
+		param = param->next;
 	}
-}
 
-void TreeCCGenerateC(TreeCCContext *context)
-{
-	/* Write all stream headers */
-	WriteHeaders(context);
-
-	/* Generate the contents of the header stream */
-	TreeCCNodeVisitAll(context, DefineNodeNumbers);
-	TreeCCStreamPrint(context->headerStream, "\n");
-	TreeCCNodeVisitAll(context, DeclareTypeDefs);
-	TreeCCStreamPrint(context->headerStream, "\n");
-	if(context->use_gc_allocator)
+	/* Output a function with the generic signature for each case */
+	number = 1;
+	operCase = oper->firstCase;
+	while(operCase != 0)
 	{
-		if(context->commonHeader)
+		if((oper->flags & TREECC_OPER_INLINE) != 0)
 		{
-			TreeCCIncludeSkeleton
-				(context, context->commonHeader, "c_gc_skel.h");
+			operCase->number = number++;
+		}
+		TreeCCStreamPrint(stream, "static %s %s_entry_%d__(",
+						  oper->returnType, oper->name, operCase->number);
+		CGenParams(context, stream, oper);
+		TreeCCStreamPrint(stream, "\n{\n");
+		if((oper->flags & TREECC_OPER_INLINE) != 0)
+		{
+			C_GenCaseInline(context, stream, operCase, -1);
+			C_GenExit(context, stream, oper);
 		}
 		else
 		{
-			TreeCCIncludeSkeleton
-				(context, context->headerStream, "c_gc_skel.h");
+			C_GenCaseCall(context, stream, operCase, operCase->number, -1);
+			TreeCCStreamPrint(stream, "}\n\n");
 		}
+		operCase = operCase->next;
 	}
-	else
+
+	/* Combinations without a case fall back to the default value */
+	needDefault = 0;
+	for(index = 0; index < total; ++index)
 	{
-		if(context->commonHeader)
-		{
-			TreeCCIncludeSkeleton(context, context->commonHeader, "c_skel.h");
-		}
-		else
+		if(!(oper->sortedCases[index]))
 		{
-			TreeCCIncludeSkeleton(context, context->headerStream, "c_skel.h");
+			needDefault = 1;
+			break;
 		}
 	}
-	TreeCCNodeVisitAll(context, BuildTypeDecls);
-	TreeCCNodeVisitAll(context, DeclareCreateFuncs);
-	TreeCCStreamPrint(context->headerStream, "\n");
-	TreeCCOperationVisitAll(context, DeclareNonVirtuals);
-	TreeCCStreamPrint(context->headerStream, "\n");
-	OutputHelpers(context);
+	if(needDefault)
+	{
+		TreeCCStreamPrint(stream, "static %s %s_default__(",
+						  oper->returnType, oper->name);
+		CGenParams(context, stream, oper);
+		TreeCCStreamPrint(stream, "\n{\n");
+		C_GenExit(context, stream, oper);
+	}
 
-	/* Generate the contents of the source stream */
-	if(context->use_allocator)
+	/* Output the dispatch table */
+	TreeCCStreamPrint(stream, "typedef %s (*%s_entry__)(",
+					  oper->returnType, oper->name);
+	CGenParams(context, stream, oper);
+	TreeCCStreamPrint(stream, ";\n");
+	TreeCCStreamPrint(stream, "static %s_entry__ const %s_table__[%d] = {\n",
+					  oper->name, oper->name, total);
+	for(index = 0; index < total; ++index)
 	{
-		if(context->commonSource)
+		operCase = oper->sortedCases[index];
+		if(operCase)
 		{
-			WriteSourceSkeleton(context, context->commonSource);
+			TreeCCStreamPrint(stream, "\t%s_entry_%d__,\n",
+							  oper->name, operCase->number);
 		}
 		else
 		{
-			WriteSourceSkeleton(context, context->sourceStream);
+			TreeCCStreamPrint(stream, "\t%s_default__,\n", oper->name);
 		}
 	}
-	TreeCCNodeVisitAll(context, DefineVtables);
-	TreeCCNodeVisitAll(context, ImplementCreateFuncs);
-	TreeCCGenerateNonVirtuals(context, &TreeCCNonVirtualFuncsC);
-	OutputIsA(context);
+	TreeCCStreamPrint(stream, "};\n");
+
+	/* Output the kind-to-index maps for the node type triggers.
+	   Kinds that are not in the hierarchy map to an out of range
+	   index, so that the entry point returns the default value */
+	multiplier = 1;
+	trigger = 1;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			type = TreeCCNodeFindByType(context, param->type);
+			if((type->flags & TREECC_NODE_ENUM) == 0)
+			{
+				min = max = type->number;
+				KindBounds(type, &min, &max);
+				map = (int *)malloc(sizeof(int) * (max - min + 1));
+				if(!map)
+				{
+					TreeCCOutOfMemory(context->input);
+				}
+				for(index = 0; index <= (max - min); ++index)
+				{
+					map[index] = total;
+				}
+				FillKindMap(type, map, min, multiplier);
+				TreeCCStreamPrint(stream,
+						"static const unsigned int %s_map_%d__[%d] = {",
+						oper->name, trigger, max - min + 1);
+				for(index = 0; index <= (max - min); ++index)
+				{
+					if((index % 8) == 0)
+					{
+						TreeCCStreamPrint(stream, "\n\t");
+					}
+					else
+					{
+						TreeCCStreamPrint(stream, " ");
+					}
+					TreeCCStreamPrint(stream, "%d,", map[index]);
+				}
+				TreeCCStreamPrint(stream, "\n};\n");
+				free(map);
+			}
+			multiplier *= param->size;
+			++trigger;
+		}
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, "\n");
+
+	/* Output the entry point, which sums the contributions of
+	   each trigger and then calls through the table */
+	CGenEntry(context, stream, oper, -1);
+	TreeCCStreamPrint(stream, "\tunsigned int index__ = 0;\n");
+	multiplier = 1;
+	trigger = 1;
+	num = 1;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			char paramName[64];
+			if(param->name)
+			{
+				sprintf(paramName, "%.60s", param->name);
+			}
+			else
+			{
+				sprintf(paramName, "P%d__", num);
+			}
+			type = TreeCCNodeFindByType(context, param->type);
+			if((type->flags & TREECC_NODE_ENUM) != 0)
+			{
+				TreeCCStreamPrint(stream,
+						"\tindex__ += (unsigned int)(%s) * %d;\n",
+						paramName, multiplier);
+			}
+			else
+			{
+				min = max = type->number;
+				KindBounds(type, &min, &max);
+				TreeCCStreamPrint(stream, "\tindex__ += %s_map_%d__[",
+								  oper->name, trigger);
+				if(context->language == TREECC_LANG_CPP)
+				{
+					TreeCCStreamPrint(stream, "%s__->getKind()", paramName);
+				}
+				else if(context->kind_in_vtable)
+				{
+					TreeCCStreamPrint(stream, "%s__->vtable__->kind__",
+									  paramName);
+				}
+				else
+				{
+					TreeCCStreamPrint(stream, "%s__->kind__", paramName);
+				}
+				if(min != 0)
+				{
+					TreeCCStreamPrint(stream, " - %d", min);
+				}
+				TreeCCStreamPrint(stream, "];\n");
+			}
+			multiplier *= param->size;
+			++trigger;
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, "\tif(index__ < %d)\n", total);
+	TreeCCStreamPrint(stream, "\t{\n\t\t");
+	if(strcmp(oper->returnType, "void") != 0)
+	{
+		TreeCCStreamPrint(stream, "return ");
+	}
+	TreeCCStreamPrint(stream, "(*(%s_table__[index__]))(", oper->name);
+	CGenArgs(context, stream, oper);
+	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream, "\t}\n");
+	C_GenExit(context, stream, oper);
+	return 1;
+}
+
+/*
+ * Fill in the kind-to-slot map for the batch entry point of an
+ * operation.  Each node type maps to the 1-based position of the
+ * case that handles it, or zero if no case handles it.
+ */
+static void FillBatchMap(TreeCCNode *node, TreeCCOperation *oper,
+						 int *map, int min, int slot)
+{
+	TreeCCOperationCase *operCase;
+	int posn = 1;
+	operCase = oper->firstCase;
+	while(operCase != 0)
+	{
+		if(operCase->triggers->node == node)
+		{
+			slot = posn;
+			break;
+		}
+		++posn;
+		operCase = operCase->next;
+	}
+	map[node->number - min] = slot;
+	node = node->firstChild;
+	while(node != 0)
+	{
+		FillBatchMap(node, oper, map, min, slot);
+		node = node->nextSibling;
+	}
+}
+
+/*
+ * Generate the parameter list for the batch entry point of
+ * a non-virtual operation.
+ */
+static void CGenBatchParams(TreeCCContext *context, TreeCCStream *stream,
+							TreeCCOperation *oper)
+{
+	TreeCCParam *param;
+	int num;
+	int needComma;
+	param = oper->params;
+	num = 1;
+	needComma = 0;
+	while(param != 0)
+	{
+		if(needComma)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			/* The array of nodes takes the place of the trigger */
+			TreeCCStreamPrint(stream, "%s *nodes__, size_t count__",
+							  param->type);
+		}
+		else if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s %s", param->type, param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "%s P%d__", param->type, num);
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		needComma = 1;
+		param = param->next;
+	}
+	if(strcmp(oper->returnType, "void") != 0)
+	{
+		TreeCCStreamPrint(stream, ", %s *results__", oper->returnType);
+	}
+	TreeCCStreamPrint(stream, ")");
+}
+
+void TreeCCDeclareBatch(TreeCCContext *context, TreeCCStream *stream,
+						TreeCCOperation *oper)
+{
+	TreeCCStreamPrint(stream, "void %s_batch(", oper->name);
+	CGenBatchParams(context, stream, oper);
+	TreeCCStreamPrint(stream, ";\n");
+}
+
+/*
+ * Generate a call to a batch case function for the node at "posn__".
+ */
+static void CGenBatchCall(TreeCCContext *context, TreeCCStream *stream,
+						  TreeCCOperation *oper, int number)
+{
+	TreeCCParam *param;
+	int num;
+	int needComma;
+	TreeCCStreamPrint(stream, "%s_batch_%d__(", oper->name, number);
+	param = oper->params;
+	num = 1;
+	needComma = 0;
+	while(param != 0)
+	{
+		if(needComma)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			TreeCCStreamPrint(stream, "nodes__[posn__]");
+		}
+		else if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s", param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "P%d__", num);
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		needComma = 1;
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, ")");
+}
+
+/*
+ * Generate the batch entry point for a single-trigger operation.
+ * The nodes are sorted into buckets by case with a counting sort,
+ * and then each case is run over all of the nodes in its bucket.
+ */
+static void C_GenBatch(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCOperation *oper)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	int numCases, number, index, min, max, num;
+	int isVoid = (strcmp(oper->returnType, "void") == 0);
+	int *map;
+
+	/* Output a function with the generic signature for each case.
+	   The code for the case is always in a case function, even if
+	   the operation is inline, so that it is not duplicated */
+	numCases = 0;
+	operCase = oper->firstCase;
+	while(operCase != 0)
+	{
+		++numCases;
+		TreeCCStreamPrint(stream, "static %s %s_batch_%d__(",
+						  oper->returnType, oper->name, numCases);
+		CGenParams(context, stream, oper);
+		TreeCCStreamPrint(stream, "\n{\n");
+		C_GenCaseCall(context, stream, operCase, operCase->number, -1);
+		TreeCCStreamPrint(stream, "}\n\n");
+		operCase = operCase->next;
+	}
+
+	/* Output the kind-to-slot map.  Kinds that are not in the
+	   hierarchy of the trigger type map to the default slot */
+	param = oper->params;
+	num = 1;
+	while((param->flags & TREECC_PARAM_TRIGGER) == 0)
+	{
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	type = TreeCCNodeFindByType(context, param->type);
+	min = max = type->number;
+	KindBounds(type, &min, &max);
+	map = (int *)malloc(sizeof(int) * (max - min + 1));
+	if(!map)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	for(index = 0; index <= (max - min); ++index)
+	{
+		map[index] = 0;
+	}
+	FillBatchMap(type, oper, map, min, 0);
+	TreeCCStreamPrint(stream,
+			"static const unsigned %s %s_batch_map__[%d] = {",
+			(numCases < 256 ? "char" : "int"), oper->name, max - min + 1);
+	for(index = 0; index <= (max - min); ++index)
+	{
+		if((index % 8) == 0)
+		{
+			TreeCCStreamPrint(stream, "\n\t");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, " ");
+		}
+		TreeCCStreamPrint(stream, "%d,", map[index]);
+	}
+	TreeCCStreamPrint(stream, "\n};\n");
+	free(map);
+
+	/* Output a function that maps a node to its slot */
+	TreeCCStreamPrint(stream,
+			"static unsigned int %s_batch_slot__(%snode__)\n",
+			oper->name, param->type);
+	TreeCCStreamPrint(stream, "{\n\tunsigned int kind__ = (unsigned int)");
+	if(context->language == TREECC_LANG_CPP)
+	{
+		TreeCCStreamPrint(stream, "(node__->getKind()");
+	}
+	else if(context->kind_in_vtable)
+	{
+		TreeCCStreamPrint(stream, "(node__->vtable__->kind__");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "(node__->kind__");
+	}
+	if(min != 0)
+	{
+		TreeCCStreamPrint(stream, " - %d", min);
+	}
+	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream,
+			"\treturn (kind__ < %d ? %s_batch_map__[kind__] : 0);\n",
+			max - min + 1, oper->name);
+	TreeCCStreamPrint(stream, "}\n\n");
+
+	/* Output the head of the batch entry point */
+	if(context->language == TREECC_LANG_C || !(oper->className))
+	{
+		TreeCCStreamPrint(stream, "void %s_batch(", oper->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "void %s::%s_batch(",
+						  oper->className, oper->name);
+	}
+	CGenBatchParams(context, stream, oper);
+	TreeCCStreamPrint(stream, "\n{\n");
+	TreeCCStreamPrint(stream, "\tsize_t starts__[%d];\n", numCases + 2);
+	TreeCCStreamPrint(stream, "\tsize_t *order__;\n");
+	TreeCCStreamPrint(stream, "\tsize_t index__, posn__;\n");
+	TreeCCStreamPrint(stream, "\tunsigned int slot__;\n\n");
+
+	/* Fall back to calling the operation on each node in turn
+	   if there is insufficient memory to sort the nodes */
+	TreeCCStreamPrint(stream,
+			"\torder__ = (size_t *)malloc(count__ * sizeof(size_t));\n");
+	TreeCCStreamPrint(stream, "\tif(!order__)\n\t{\n");
+	TreeCCStreamPrint(stream,
+			"\t\tfor(posn__ = 0; posn__ < count__; ++posn__)\n\t\t{\n\t\t\t");
+	if(!isVoid)
+	{
+		TreeCCStreamPrint(stream, "results__[posn__] = ");
+	}
+	if(context->language == TREECC_LANG_CPP && oper->className)
+	{
+		TreeCCStreamPrint(stream, "%s::", oper->className);
+	}
+	TreeCCStreamPrint(stream, "%s(", oper->name);
+	param = oper->params;
+	num = 1;
+	number = 0;
+	while(param != 0)
+	{
+		if(number)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			TreeCCStreamPrint(stream, "nodes__[posn__]");
+		}
+		else if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s", param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "P%d__", num);
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		number = 1;
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, ");\n\t\t}\n\t\treturn;\n\t}\n\n");
+
+	/* Count the number of nodes in each slot and then convert
+	   the counts into the starting position of each bucket */
+	TreeCCStreamPrint(stream,
+			"\tfor(slot__ = 0; slot__ < %d; ++slot__)\n\t{\n"
+			"\t\tstarts__[slot__] = 0;\n\t}\n", numCases + 2);
+	TreeCCStreamPrint(stream,
+			"\tfor(index__ = 0; index__ < count__; ++index__)\n\t{\n"
+			"\t\t++(starts__[%s_batch_slot__(nodes__[index__]) + 1]);\n\t}\n",
+			oper->name);
+	TreeCCStreamPrint(stream,
+			"\tfor(slot__ = 1; slot__ < %d; ++slot__)\n\t{\n"
+			"\t\tstarts__[slot__] += starts__[slot__ - 1];\n\t}\n",
+			numCases + 2);
+
+	/* Distribute the node positions into the buckets.  Afterwards,
+	   "starts__[N]" is the end of bucket N and the start of N + 1 */
+	TreeCCStreamPrint(stream,
+			"\tfor(index__ = 0; index__ < count__; ++index__)\n\t{\n"
+			"\t\tslot__ = %s_batch_slot__(nodes__[index__]);\n"
+			"\t\torder__[(starts__[slot__])++] = index__;\n\t}\n\n",
+			oper->name);
+
+	/* Nodes without a case receive the default value */
+	if(isVoid)
+	{
+		TreeCCStreamPrint(stream, "\tindex__ = starts__[0];\n");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+				"\tfor(index__ = 0; index__ < starts__[0]; ++index__)\n\t{\n");
+		if(oper->defValue)
+		{
+			TreeCCStreamPrint(stream,
+					"\t\tresults__[order__[index__]] = (%s);\n\t}\n",
+					oper->defValue);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+					"\t\tresults__[order__[index__]] = 0;\n\t}\n");
+		}
+	}
+
+	/* Run each case over the nodes in its bucket */
+	for(number = 1; number <= numCases; ++number)
+	{
+		TreeCCStreamPrint(stream,
+				"\tfor(; index__ < starts__[%d]; ++index__)\n\t{\n"
+				"\t\tposn__ = order__[index__];\n\t\t", number);
+		if(!isVoid)
+		{
+			TreeCCStreamPrint(stream, "results__[posn__] = ");
+		}
+		CGenBatchCall(context, stream, oper, number);
+		TreeCCStreamPrint(stream, ";\n\t}\n");
+	}
+	TreeCCStreamPrint(stream, "\tfree(order__);\n}\n\n");
+}
+
+/*
+ * Determine if there are any "%memoize" operations.
+ */
+static int HaveMemoize(TreeCCContext *context)
+{
+	unsigned int hash;
+	TreeCCOperation *oper;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		for(oper = context->operHash[hash]; oper != 0; oper = oper->nextHash)
+		{
+			if((oper->flags & TREECC_OPER_MEMOIZE) != 0)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Write the storage class for the memo generation counter.
+ */
+static void MemoStorageClass(TreeCCContext *context, TreeCCStream *stream,
+							 int threadLocal)
+{
+	if(threadLocal)
+	{
+		TreeCCStreamPrint(stream, "%s_THREAD_LOCAL ", context->state_type);
+	}
+}
+
+void TreeCCDeclareMemo(TreeCCContext *context, TreeCCStream *stream,
+					   int threadLocal)
+{
+	if(!HaveMemoize(context))
+	{
+		return;
+	}
+	TreeCCStreamPrint(stream, "extern ");
+	MemoStorageClass(context, stream, threadLocal);
+	TreeCCStreamPrint(stream, "unsigned long %smemo_generation__;\n",
+					  context->yy_replacement);
+	TreeCCStreamPrint(stream, "extern void %smemoinvalidate(void);\n\n",
+					  context->yy_replacement);
+}
+
+void TreeCCImplementMemo(TreeCCContext *context, TreeCCStream *stream,
+						 int threadLocal)
+{
+	if(!HaveMemoize(context))
+	{
+		return;
+	}
+	MemoStorageClass(context, stream, threadLocal);
+	TreeCCStreamPrint(stream, "unsigned long %smemo_generation__ = 1;\n\n",
+					  context->yy_replacement);
+	TreeCCStreamPrint(stream, "void %smemoinvalidate(void)\n{\n",
+					  context->yy_replacement);
+	TreeCCStreamPrint(stream, "\t++%smemo_generation__;\n}\n\n",
+					  context->yy_replacement);
+}
+
+void TreeCCDeclareProfile(TreeCCContext *context, TreeCCStream *stream)
+{
+	if(NumProfiledOperations(context) == 0)
+	{
+		return;
+	}
+	TreeCCStreamPrint(stream,
+			"extern void %sprofile_hit__(int oper__, int kind__);\n\n",
+			context->yy_replacement);
+}
+
+void TreeCCImplementProfile(TreeCCContext *context, TreeCCStream *stream)
+{
+	const char *yy = context->yy_replacement;
+	int numOpers = NumProfiledOperations(context);
+	int numKinds = context->nodeNumber;
+	const char **kindNames;
+	unsigned int hash;
+	TreeCCOperation *oper;
+	TreeCCNode *node;
+	int index;
+	if(numOpers == 0)
+	{
+		return;
+	}
+
+	/* Output the names of the profiled operations, by index */
+	TreeCCStreamPrint(stream,
+			"static const char * const %sprofile_opers__[%d] = {\n",
+			yy, numOpers);
+	for(index = 0; index < numOpers; ++index)
+	{
+		for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+		{
+			for(oper = context->operHash[hash]; oper != 0;
+				oper = oper->nextHash)
+			{
+				if(oper->profileIndex == index)
+				{
+					TreeCCStreamPrint(stream, "\t\"%s\",\n", oper->name);
+				}
+			}
+		}
+	}
+	TreeCCStreamPrint(stream, "};\n");
+
+	/* Output the names of the node types, by kind */
+	if((kindNames = (const char **)calloc(numKinds, sizeof(char *))) == 0)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		for(node = context->nodeHash[hash]; node != 0; node = node->nextHash)
+		{
+			if((node->flags & (TREECC_NODE_ENUM |
+							   TREECC_NODE_ENUM_VALUE)) == 0 &&
+			   node->number < numKinds)
+			{
+				kindNames[node->number] = node->name;
+			}
+		}
+	}
+	TreeCCStreamPrint(stream,
+			"static const char * const %sprofile_kinds__[%d] = {\n",
+			yy, numKinds);
+	for(index = 0; index < numKinds; ++index)
+	{
+		if(kindNames[index])
+		{
+			TreeCCStreamPrint(stream, "\t\"%s\",\n", kindNames[index]);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\t0,\n");
+		}
+	}
+	TreeCCStreamPrint(stream, "};\n");
+	free(kindNames);
+
+	/* Output the counters */
+	TreeCCStreamPrint(stream,
+			"static unsigned long %sprofile_counts__[%d][%d];\n",
+			yy, numOpers, numKinds);
+	TreeCCStreamPrint(stream, "static int %sprofile_started__ = 0;\n\n", yy);
+
+	/* Output the function that writes the profile at exit */
+	TreeCCStreamPrint(stream, "static void %sprofile_dump__(void)\n{\n", yy);
+	TreeCCStreamPrint(stream,
+			"\tFILE *file__ = fopen(\"%s\", \"w\");\n",
+			context->profileFile);
+	TreeCCStreamPrint(stream, "\tint oper__, kind__;\n");
+	TreeCCStreamPrint(stream, "\tif(!file__)\n\t{\n\t\treturn;\n\t}\n");
+	TreeCCStreamPrint(stream,
+			"\tfputs(\"# treecc dispatch profile\\n\", file__);\n");
+	TreeCCStreamPrint(stream,
+			"\tfor(oper__ = 0; oper__ < %d; ++oper__)\n\t{\n", numOpers);
+	TreeCCStreamPrint(stream,
+			"\t\tfor(kind__ = 0; kind__ < %d; ++kind__)\n\t\t{\n",
+			numKinds);
+	TreeCCStreamPrint(stream,
+			"\t\t\tif(%sprofile_counts__[oper__][kind__] != 0)\n"
+			"\t\t\t{\n", yy);
+	TreeCCStreamPrint(stream,
+			"\t\t\t\tfprintf(file__, \"%%s %%s %%lu\\n\",\n"
+			"\t\t\t\t\t\t%sprofile_opers__[oper__],\n"
+			"\t\t\t\t\t\t%sprofile_kinds__[kind__],\n"
+			"\t\t\t\t\t\t%sprofile_counts__[oper__][kind__]);\n",
+			yy, yy, yy);
+	TreeCCStreamPrint(stream, "\t\t\t}\n\t\t}\n\t}\n");
+	TreeCCStreamPrint(stream, "\tfclose(file__);\n}\n\n");
+
+	/* Output the function that counts a dispatch */
+	TreeCCStreamPrint(stream,
+			"void %sprofile_hit__(int oper__, int kind__)\n{\n", yy);
+	TreeCCStreamPrint(stream, "\tif(!%sprofile_started__)\n\t{\n", yy);
+	TreeCCStreamPrint(stream, "\t\t%sprofile_started__ = 1;\n", yy);
+	TreeCCStreamPrint(stream, "\t\tatexit(%sprofile_dump__);\n\t}\n", yy);
+	TreeCCStreamPrint(stream,
+			"\t++(%sprofile_counts__[oper__][kind__]);\n}\n\n", yy);
+}
+
+/*
+ * Table of non-virtual code generation functions.
+ */
+TreeCCNonVirtual const TreeCCNonVirtualFuncsC = {
+	C_GenStart,
+	C_GenEntry,
+	C_GenSplitEntry,
+	C_GenSwitchHead,
+	C_GenSelector,
+	0,
+	C_GenEndSelectors,
+	C_GenCaseFunc,
+	C_GenCaseCall,
+	C_GenCaseInline,
+	C_GenCaseSplit,
+	C_GenEndCase,
+	C_GenEndSwitch,
+	C_GenExit,
+	C_GenEnd,
+	C_GenDispatchTable,
+	C_GenBatch,
+};
+
+/*
+ * Write out header information for all streams.
+ */
+static void WriteHeaders(TreeCCContext *context)
+{
+	TreeCCStream *stream = context->streamList;
+	while(stream != 0)
+	{
+		if(stream->isHeader)
+		{
+			TreeCCStreamHeaderTop(stream);
+			TreeCCStreamPrint(stream, "\n");
+			if(context->batch_operations)
+			{
+				/* Batch entry points take "size_t" counts */
+				TreeCCStreamPrint(stream, "#include <stddef.h>\n");
+				TreeCCStreamPrint(stream, "\n");
+			}
+			TreeCCStreamPrint(stream, "#ifdef __cplusplus\n");
+			TreeCCStreamPrint(stream, "extern \"C\" {\n");
+			TreeCCStreamPrint(stream, "#endif\n");
+			TreeCCStreamPrint(stream, "\n");
+		}
+		else
+		{
+			TreeCCStreamSourceTop(stream);
+			TreeCCStreamPrint(stream, "\n");
+			if(context->profile_dispatch || context->batch_operations)
+			{
+				/* The profile is written with "fprintf" at exit, and
+				   batch entry points sort the nodes with "malloc" */
+				if(context->profile_dispatch)
+				{
+					TreeCCStreamPrint(stream, "#include <stdio.h>\n");
+				}
+				TreeCCStreamPrint(stream, "#include <stdlib.h>\n");
+				TreeCCStreamPrint(stream, "\n");
+			}
+		}
+		if(stream->defaultFile)
+		{
+			/* Reset the dirty flag if this is a default stream,
+			   because we don't want to write out the final file
+			   if it isn't actually written to in practice */
+			stream->dirty = 0;
+		}
+		stream = stream->nextStream;
+	}
+}
+
+/*
+ * Write out footer information for all streams.
+ */
+static void WriteFooters(TreeCCContext *context)
+{
+	TreeCCStream *stream = context->streamList;
+	while(stream != 0)
+	{
+		if(stream->defaultFile && !(stream->dirty))
+		{
+			/* Clear the default file's contents, which we don't need */
+			TreeCCStreamClear(stream);
+		}
+		else if(stream->isHeader)
+		{
+			TreeCCStreamPrint(stream, "#ifdef __cplusplus\n");
+			TreeCCStreamPrint(stream, "};\n");
+			TreeCCStreamPrint(stream, "#endif\n");
+			TreeCCStreamPrint(stream, "\n");
+			TreeCCStreamHeaderBottom(stream);
+		}
+		else
+		{
+			TreeCCStreamSourceBottom(stream);
+		}
+		stream = stream->nextStream;
+	}
+}
+
+/*
+ * Write the skeleton for the node memory manager to a source stream.
+ */
+static void WriteSourceSkeleton(TreeCCContext *context, TreeCCStream *stream)
+{
+	if(context->block_size)
+	{
+		TreeCCStreamPrint(stream, "#define %s_BLKSIZ %d\n",
+						  context->state_type, context->block_size);
+	}
+	if(context->block_cache)
+	{
+		TreeCCStreamPrint(stream, "#define %s_CACHE %d\n",
+						  context->state_type, context->block_cache);
+	}
+	if(context->max_block_size)
+	{
+		TreeCCStreamPrint(stream, "#define %s_MAXBLKSIZ %d\n",
+						  context->state_type, context->max_block_size);
+	}
+	if(context->mmap_threshold)
+	{
+		TreeCCStreamPrint(stream, "#define %s_MMAP_THRESHOLD %d\n",
+						  context->state_type, context->mmap_threshold);
+	}
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "#define %s_REENTRANT 1\n",
+						  context->state_type);
+	}
+	if(context->track_lines)
+	{
+		TreeCCStreamPrint(stream, "#define %s_TRACK_LINES 1\n",
+						  context->state_type);
+	}
+	if(context->use_gc_allocator)
+	{
+		TreeCCIncludeSkeleton(context, stream, "c_gc_skel.c");
+	}
+	else if(UseSharedAllocator(context))
+	{
+		TreeCCIncludeSkeleton(context, stream, "c_shared_skel.c");
+	}
+	else
+	{
+		TreeCCIncludeSkeleton(context, stream, "c_skel.c");
+	}
+}
+
+/*
+ * Output a case for the "yynodefree__" helper function.
+ */
+static void NodeFreeCase(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream;
+
+	/* Ignore enumerated types, abstract types, and singletons */
+	if((node->flags & (TREECC_NODE_ENUM | TREECC_NODE_ENUM_VALUE |
+					   TREECC_NODE_ABSTRACT)) != 0)
+	{
+		return;
+	}
+	if(!(context->track_lines) && !(context->no_singletons) &&
+	   TreeCCNodeIsSingleton(node))
+	{
+		return;
+	}
+
+	/* Determine which stream to write to */
+	if(context->commonSource)
+	{
+		stream = context->commonSource;
+	}
+	else
+	{
+		stream = context->sourceStream;
+	}
+
+	/* Output the case */
+	TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+			"\t\t\t%snodedealloc(state__, node__, sizeof(struct %s__));\n",
+			context->yy_replacement, node->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+			"\t\t\t%snodedealloc(node__, sizeof(struct %s__));\n",
+			context->yy_replacement, node->name);
+	}
+	TreeCCStreamPrint(stream, "\t\t\tbreak;\n");
+}
+
+/*
+ * Output the source code for the "yynodefree__" helper function,
+ * which recycles a node using the size for its kind.
+ */
+static void OutputNodeFree(TreeCCContext *context)
+{
+	TreeCCStream *stream;
+
+	/* Determine which stream to write to */
+	if(context->commonSource)
+	{
+		stream = context->commonSource;
+	}
+	else
+	{
+		stream = context->sourceStream;
+	}
+
+	/* Output the function header */
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+			"void %snodefree__(%s *state__, const void *vtable__, "
+					"void *node__)\n",
+			context->yy_replacement, context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+			"void %snodefree__(const void *vtable__, void *node__)\n",
+			context->yy_replacement);
+	}
+
+	/* Output the body of the function */
+	TreeCCStreamPrint(stream, "{\n");
+	TreeCCStreamPrint(stream,
+		"\tswitch(((const struct %s_vtable__ *)vtable__)->kind__)\n",
+		context->yy_replacement);
+	TreeCCStreamPrint(stream, "\t{\n");
+	TreeCCNodeVisitAll(context, NodeFreeCase);
+	TreeCCStreamPrint(stream, "\t\tdefault: break;\n");
+	TreeCCStreamPrint(stream, "\t}\n");
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
+/*
+ * Copy the node fields of a type and its ancestors within a case
+ * of the "yyclone__" helper function.
+ */
+static void CloneFields(TreeCCContext *context, TreeCCStream *stream,
+						TreeCCNode *node)
+{
+	TreeCCField *field;
+	if(node->parent)
+	{
+		CloneFields(context, stream, node->parent);
+	}
+	field = node->fields;
+	while(field != 0)
+	{
+		if(IsNodeField(context, field))
+		{
+			TreeCCStreamPrint(stream, "\t\t\tif(copy__->%s != 0 &&\n",
+							  field->name);
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream,
+					"\t\t\t   (copy__->%s = (%s)%sclone__"
+							"(state__, copy__->%s)) == 0)\n",
+					field->name, field->type,
+					context->yy_replacement, field->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+					"\t\t\t   (copy__->%s = (%s)%sclone__"
+							"(copy__->%s)) == 0)\n",
+					field->name, field->type,
+					context->yy_replacement, field->name);
+			}
+			TreeCCStreamPrint(stream, "\t\t\t\treturn 0;\n");
+		}
+		field = field->next;
+	}
+}
+
+/*
+ * Output a case for the "yyclone__" helper function.
+ */
+static void CloneCase(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream;
+
+	/* Ignore enumerated types and abstract types */
+	if((node->flags & (TREECC_NODE_ENUM | TREECC_NODE_ENUM_VALUE |
+					   TREECC_NODE_ABSTRACT)) != 0)
+	{
+		return;
+	}
+
+	/* Determine which stream to write to */
+	if(context->commonSource)
+	{
+		stream = context->commonSource;
+	}
+	else
+	{
+		stream = context->sourceStream;
+	}
+
+	/* Singletons are shared, so the original can be returned as-is */
+	if(!(context->track_lines) && !(context->no_singletons) &&
+	   TreeCCNodeIsSingleton(node))
+	{
+		TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+		TreeCCStreamPrint(stream, "\t\t\treturn (void *)node__;\n");
+		return;
+	}
+
+	/* Allocate the copy and take a shallow copy of the original */
+	TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+	TreeCCStreamPrint(stream, "\t\t{\n");
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+			"\t\t\tstruct %s__ *copy__ = (struct %s__ *)\n"
+			"\t\t\t\t%snodealloc(state__, sizeof(struct %s__));\n",
+			node->name, node->name, context->yy_replacement, node->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+			"\t\t\tstruct %s__ *copy__ = (struct %s__ *)\n"
+			"\t\t\t\t%snodealloc(sizeof(struct %s__));\n",
+			node->name, node->name, context->yy_replacement, node->name);
+	}
+	TreeCCStreamPrint(stream, "\t\t\tif(copy__ == 0) return 0;\n");
+	if(UseNodeStats(context))
+	{
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream,
+				"\t\t\t%snodecount__(state__, %s_kind, "
+						"sizeof(struct %s__));\n",
+				context->yy_replacement, node->name, node->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+				"\t\t\t%snodecount__(%s_kind, sizeof(struct %s__));\n",
+				context->yy_replacement, node->name, node->name);
+		}
+	}
+	TreeCCStreamPrint(stream,
+		"\t\t\t*copy__ = *((const struct %s__ *)node__);\n", node->name);
+
+	/* Replace the node fields with copies of the subtrees */
+	CloneFields(context, stream, node);
+
+	/* Return the copy to the caller */
+	TreeCCStreamPrint(stream, "\t\t\treturn copy__;\n");
+	TreeCCStreamPrint(stream, "\t\t}\n");
+}
+
+/*
+ * Output the source code for the "yyclone__" helper function,
+ * which copies a subtree into a node state.
+ */
+static void OutputClone(TreeCCContext *context)
+{
+	TreeCCStream *stream;
+
+	/* Determine which stream to write to */
+	if(context->commonSource)
+	{
+		stream = context->commonSource;
+	}
+	else
+	{
+		stream = context->sourceStream;
+	}
+
+	/* Output the function header */
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+			"void *%sclone__(%s *state__, const void *node__)\n",
+			context->yy_replacement, context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+			"void *%sclone__(const void *node__)\n",
+			context->yy_replacement);
+	}
+
+	/* Output the body of the function.  Every node type starts
+	   with its vtable pointer, which we use to find the kind */
+	TreeCCStreamPrint(stream, "{\n");
+	TreeCCStreamPrint(stream, "\tif(node__ == 0) return 0;\n");
+	TreeCCStreamPrint(stream,
+		"\tswitch((*((const struct %s_vtable__ * const *)node__))->kind__)\n",
+		context->yy_replacement);
+	TreeCCStreamPrint(stream, "\t{\n");
+	TreeCCNodeVisitAll(context, CloneCase);
+	TreeCCStreamPrint(stream, "\t\tdefault: break;\n");
+	TreeCCStreamPrint(stream, "\t}\n");
+	TreeCCStreamPrint(stream, "\treturn 0;\n");
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
+void TreeCCGenerateC(TreeCCContext *context)
+{
+	int threadLocal;
+
+	/* Write all stream headers */
+	WriteHeaders(context);
+
+	/* Generate the contents of the header stream */
+	TreeCCNodeVisitAll(context, DefineNodeNumbers);
+	TreeCCStreamPrint(context->headerStream, "\n");
+	TreeCCNodeVisitAll(context, DeclareTypeDefs);
+	TreeCCStreamPrint(context->headerStream, "\n");
+	if(context->use_gc_allocator)
+	{
+		if(context->commonHeader)
+		{
+			TreeCCIncludeSkeleton
+				(context, context->commonHeader, "c_gc_skel.h");
+		}
+		else
+		{
+			TreeCCIncludeSkeleton
+				(context, context->headerStream, "c_gc_skel.h");
+		}
+	}
+	else if(UseSharedAllocator(context))
+	{
+		if(context->commonHeader)
+		{
+			TreeCCIncludeSkeleton
+				(context, context->commonHeader, "c_shared_skel.h");
+		}
+		else
+		{
+			TreeCCIncludeSkeleton
+				(context, context->headerStream, "c_shared_skel.h");
+		}
+	}
+	else
+	{
+		TreeCCStream *stream;
+		if(context->commonHeader)
+		{
+			stream = context->commonHeader;
+		}
+		else
+		{
+			stream = context->headerStream;
+		}
+		if(UseNodeStats(context))
+		{
+			TreeCCStreamPrint(stream, "#define %s_STATS 1\n",
+							  context->state_type);
+			TreeCCStreamPrint(stream, "#define %s_NUM_KINDS %d\n",
+							  context->state_type, context->nodeNumber);
+		}
+		if(UseFreeLists(context))
+		{
+			TreeCCStreamPrint(stream, "#define %s_FREE_LISTS 1\n",
+							  context->state_type);
+		}
+		TreeCCIncludeSkeleton(context, stream, "c_skel.h");
+	}
+	TreeCCNodeVisitAll(context, BuildTypeDecls);
+	TreeCCNodeVisitAll(context, DeclareCreateFuncs);
+	TreeCCStreamPrint(context->headerStream, "\n");
+	TreeCCOperationVisitAll(context, DeclareNonVirtuals);
+	TreeCCStreamPrint(context->headerStream, "\n");
+	if(context->commonHeader)
+	{
+		TreeCCDeclareProfile(context, context->commonHeader);
+	}
+	else
+	{
+		TreeCCDeclareProfile(context, context->headerStream);
+	}
+	OutputHelpers(context);
+
+	/* The memo generation counter needs the thread-local storage
+	   class from the helpers, if the state is per-thread */
+	threadLocal = (context->thread_local_state && !(context->reentrant));
+	if(context->commonHeader)
+	{
+		TreeCCDeclareMemo(context, context->commonHeader, threadLocal);
+	}
+	else
+	{
+		TreeCCDeclareMemo(context, context->headerStream, threadLocal);
+	}
+	if(HaveSwitchDispatch(context))
+	{
+		TreeCCNodeVisitAll(context, DeclareSwitchVirtuals);
+		TreeCCStreamPrint(context->headerStream, "\n");
+		TreeCCNodeVisitAll(context, ImplementSwitchVirtuals);
+	}
+
+	/* Generate the contents of the source stream */
+	if(context->use_allocator)
+	{
+		if(context->commonSource)
+		{
+			WriteSourceSkeleton(context, context->commonSource);
+		}
+		else
+		{
+			WriteSourceSkeleton(context, context->sourceStream);
+		}
+	}
+	if(context->commonSource)
+	{
+		TreeCCImplementProfile(context, context->commonSource);
+		TreeCCImplementMemo(context, context->commonSource, threadLocal);
+	}
+	else
+	{
+		TreeCCImplementProfile(context, context->sourceStream);
+		TreeCCImplementMemo(context, context->sourceStream, threadLocal);
+	}
+	TreeCCNodeVisitAll(context, DefineVtables);
+	TreeCCNodeVisitAll(context, ImplementCreateFuncs);
+	TreeCCGenerateNonVirtuals(context, &TreeCCNonVirtualFuncsC);
+	OutputIsA(context);
+	if(UseFreeLists(context))
+	{
+		OutputNodeFree(context);
+	}
+	if(context->clone_nodes)
+	{
+		OutputClone(context);
+	}
 
 	/* Write all stream footers */
 	WriteFooters(context);
@@ -27,6 +27,160 @@
 extern	"C" {
 #endif
 
+/*
+ * Determine if allocation statistics should be collected.
+ */
+static int UseNodeStats(TreeCCContext *context)
+{
+	return (context->node_stats && context->use_allocator &&
+			!(context->use_gc_allocator) &&
+			!(context->use_shared_allocator));
+}
+
+/*
+ * Determine if individual nodes can be freed and recycled.
+ */
+static int UseFreeLists(TreeCCContext *context)
+{
+	return (context->free_lists && context->use_allocator &&
+			!(context->use_gc_allocator) &&
+			!(context->use_shared_allocator));
+}
+
+/*
+ * Determine if nodes should be allocated from a pool that can be
+ * shared between threads.
+ */
+static int UseSharedAllocator(TreeCCContext *context)
+{
+	return (context->use_shared_allocator && !(context->use_gc_allocator));
+}
+
+/*
+ * Determine if each thread should have its own singleton state.
+ */
+static int UseThreadLocalState(TreeCCContext *context)
+{
+	return (context->thread_local_state && !(context->reentrant) &&
+			!(context->use_gc_allocator) && !UseSharedAllocator(context));
+}
+
+/*
+ * Determine if the state type should be a "std::pmr::memory_resource".
+ */
+static int UseMemoryResource(TreeCCContext *context)
+{
+	return (context->memory_resource && !(context->use_gc_allocator) &&
+			!UseSharedAllocator(context));
+}
+
+/*
+ * Determine if fields should be constructed with the state type
+ * as their memory resource.
+ */
+static int UsePropagateResource(TreeCCContext *context)
+{
+	return (context->propagate_resource && UseMemoryResource(context));
+}
+
+/*
+ * Determine if cloned nodes should construct their fields with
+ * the state's memory resource, instead of the copy constructor.
+ */
+static int UseCloneConstructor(TreeCCContext *context)
+{
+	return (context->clone_nodes && UsePropagateResource(context));
+}
+
+/*
+ * Determine if node fields should be destroyed by finalizers.
+ */
+static int UseFinalizers(TreeCCContext *context)
+{
+	return (context->finalizers && context->use_allocator &&
+			!(context->use_gc_allocator) && !UseSharedAllocator(context));
+}
+
+/*
+ * Determine if a virtual operation is dispatched with an inline
+ * "switch" in the header instead of through the vtable.
+ */
+static int IsSwitchDispatch(TreeCCVirtual *virt)
+{
+	return ((virt->oper->flags & TREECC_OPER_DISPATCH_SWITCH) != 0);
+}
+
+/*
+ * Register the finalizer for the fields that are declared directly
+ * in a node type, if any of them need to be destroyed.  The test
+ * is a compile-time constant, so trivial node types pay nothing.
+ */
+static void RegisterFinalizer(TreeCCContext *context, TreeCCStream *stream,
+							  TreeCCNode *node, const char *obj,
+							  const char *indent)
+{
+	TreeCCField *field = node->fields;
+	if(!field)
+	{
+		return;
+	}
+	TreeCCStreamPrint(stream, "%sif(!(", indent);
+	while(field != 0)
+	{
+		TreeCCStreamPrint(stream, "std::is_trivially_destructible<%s>::value",
+						  field->type);
+		field = field->next;
+		if(field)
+		{
+			TreeCCStreamPrint(stream, " &&\n%s     ", indent);
+		}
+	}
+	TreeCCStreamPrint(stream, "))\n");
+	TreeCCStreamPrint(stream, "%s{\n", indent);
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream,
+				"%s\tstate__->finalize__(%s, &%s::finalize__,\n"
+				"%s\t                    %s->finalizers__);\n",
+				indent, obj, node->name, indent, obj);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream,
+				"%s\t%s::getState()->finalize__(%s, &%s::finalize__,\n"
+				"%s\t\t%s->finalizers__);\n",
+				indent, context->state_type, obj, node->name, indent, obj);
+	}
+	TreeCCStreamPrint(stream, "%s}\n", indent);
+}
+
+/*
+ * Output a field's parameter as an argument to a constructor,
+ * moving it if the field is constructed by moving.
+ */
+static void FieldArgument(TreeCCContext *context, TreeCCStream *stream,
+						  TreeCCField *field)
+{
+	if(context->move_fields)
+	{
+		TreeCCStreamPrint(stream, "std::move(%s)", field->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "%s", field->name);
+	}
+}
+
+/*
+ * Determine if a field refers to another node, and so must be
+ * copied when a subtree is cloned.
+ */
+static int IsNodeField(TreeCCContext *context, TreeCCField *field)
+{
+	TreeCCNode *type = TreeCCNodeFindByType(context, field->type);
+	return (type != 0 && (type->flags & TREECC_NODE_ENUM) == 0);
+}
+
 /*
  * Define the node numbers.
  */
@@ -38,6 +192,14 @@ static void DefineNodeNumbers(TreeCCContext *context,
 	{
 		TreeCCStreamPrint(stream, "const int %s_kind = %d;\n",
 						  node->name, node->number);
+		if(context->kind_ranges)
+		{
+			/* The kinds of the node type and its descendants */
+			TreeCCStreamPrint(stream, "const int %s_first_kind = %d;\n",
+							  node->name, node->number);
+			TreeCCStreamPrint(stream, "const int %s_last_kind = %d;\n",
+							  node->name, node->lastNumber);
+		}
 	}
 }
 
@@ -56,6 +218,40 @@ static void DeclareFields(TreeCCContext *context,
 	}
 }
 
+/*
+ * Declare the non-instance parameters of a virtual method.
+ */
+static void DeclareVirtualParams(TreeCCContext *context, TreeCCStream *stream,
+								 TreeCCVirtual *virt)
+{
+	TreeCCParam *param;
+	int num, needComma;
+	param = virt->params;
+	num = 1;
+	needComma = 0;
+	while(param != 0)
+	{
+		if(needComma)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		else
+		{
+			needComma = 1;
+		}
+		if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s %s", param->type, param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "%s P%d__", param->type, num);
+			++num;
+		}
+		param = param->next;
+	}
+}
+
 /*
  * Declare the virtuals for a node type.
  */
@@ -75,6 +271,28 @@ static void DeclareVirtuals(TreeCCContext *context, TreeCCStream *stream,
 	virt = node->virtuals;
 	while(virt != 0)
 	{
+		/* Switch-dispatched virtuals have a non-virtual entry point
+		   in the declaring type, and non-virtual "__" cases */
+		if(IsSwitchDispatch(virt))
+		{
+			if(node == actualNode)
+			{
+				TreeCCStreamPrint(stream, "\t%s %s(",
+								  virt->returnType, virt->name);
+				DeclareVirtualParams(context, stream, virt);
+				TreeCCStreamPrint(stream, ");\n");
+			}
+			if(TreeCCOperationFindCase(context, actualNode, virt->name))
+			{
+				TreeCCStreamPrint(stream, "\t%s %s__(",
+								  virt->returnType, virt->name);
+				DeclareVirtualParams(context, stream, virt);
+				TreeCCStreamPrint(stream, ");\n");
+			}
+			virt = virt->next;
+			continue;
+		}
+
 		/* Determine if we need a definition for this virtual,
 		   and whether the definition is real or abstract */
 		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
@@ -222,6 +440,16 @@ static void BuildTypeDecls(TreeCCContext *context,
 		/* Inherit from a specified parent type */
 		TreeCCStreamPrint(stream, "class %s : public %s\n{\n",
 						  node->name, node->parent->name);
+
+		/* Count allocations of this type for the statistics */
+		if(UseNodeStats(context) && !(context->reentrant) &&
+		   (node->flags & TREECC_NODE_ABSTRACT) == 0)
+		{
+			TreeCCStreamPrint(stream, "public:\n\n");
+			TreeCCStreamPrint(stream, "\tvoid *operator new(size_t);\n");
+			TreeCCStreamPrint(stream,
+					"\tvoid operator delete(void *, size_t);\n\n");
+		}
 	}
 	else
 	{
@@ -248,6 +476,16 @@ static void BuildTypeDecls(TreeCCContext *context,
 			TreeCCStreamPrint(stream, "\tlong linenum__;\n");
 		}
 
+		/* Declare the finalizer records, which the state type
+		   cancels when it frees the node */
+		if(UseFinalizers(context))
+		{
+			TreeCCStreamPrint(stream, "\t%s::Finalizers__ finalizers__;\n",
+							  context->state_type);
+			TreeCCStreamPrint(stream, "\tfriend class %s;\n",
+							  context->state_type);
+		}
+
 		/* Declare the public methods for access to the above fields */
 		TreeCCStreamPrint(stream, "\npublic:\n\n");
 		TreeCCStreamPrint(stream, "\tint getKind() const { return kind__; }\n");
@@ -316,8 +554,14 @@ static void BuildTypeDecls(TreeCCContext *context,
 	CreateParams(context, stream, node, needComma);
 	TreeCCStreamPrint(stream, ");\n\n");
 
-	/* Declare the fields */
+	/* Declare the fields, preceded by the constructor that "clone"
+	   uses to copy the fields with the state's memory resource */
 	TreeCCStreamPrint(stream, "public:\n\n");
+	if(UseCloneConstructor(context))
+	{
+		TreeCCStreamPrint(stream, "\t%s(const %s &other__, %s *state__);\n\n",
+						  node->name, node->name, context->state_type);
+	}
 	if(node->fields)
 	{
 		DeclareFields(context, stream, node);
@@ -328,15 +572,60 @@ static void BuildTypeDecls(TreeCCContext *context,
 	DeclareVirtuals(context, stream, node, node);
 	TreeCCStreamPrint(stream, "\n");
 
-	/* Declare the "isA" and "getKindName" helper methods */
-	TreeCCStreamPrint(stream, "\tvirtual int isA(int kind) const;\n");
+	/* Declare the "isA" and "getKindName" helper methods.  With
+	   pre-order kinds, "isA" is an inline test in the root type
+	   against the interval of kinds for "kind" */
+	if(!(context->kind_ranges))
+	{
+		TreeCCStreamPrint(stream, "\tvirtual int isA(int kind) const;\n");
+	}
+	else if(!(node->parent))
+	{
+		TreeCCStreamPrint(stream, "\tint isA(int kind) const\n");
+		TreeCCStreamPrint(stream,
+			"\t\t{ return (kind >= %d && kind <= kind__ &&\n", node->number);
+		TreeCCStreamPrint(stream,
+			"\t\t          kind__ <= lastKinds__[kind - %d]); }\n",
+			node->number);
+		TreeCCStreamPrint(stream, "\tstatic const int lastKinds__[%d];\n",
+						  node->lastNumber - node->number + 1);
+	}
 	TreeCCStreamPrint(stream, "\tvirtual const char *getKindName() const;\n\n");
 
+	/* Declare the finalizer for the fields in this node type */
+	if(UseFinalizers(context) && node->fields)
+	{
+		TreeCCStreamPrint(stream, "\tstatic void finalize__(void *node__);\n\n");
+	}
+
+	/* Declare the subtree clone method in the root node type */
+	if(context->clone_nodes && !(node->parent))
+	{
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream, "\t%s *clone(%s *state__) const;\n\n",
+							  node->name, context->state_type);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\t%s *clone() const;\n\n",
+							  node->name);
+		}
+	}
+
 	/* Declare the protected destructor for the node type.
 	   The destructor is never called, but we need it to
 	   keep C++ compilers from whinging about classes with
-	   virtuals, but no virtual destructor */
-	TreeCCStreamPrint(stream, "protected:\n\n");
+	   virtuals, but no virtual destructor.  If nodes can be
+	   freed individually, then the destructor is public */
+	if(UseFreeLists(context))
+	{
+		TreeCCStreamPrint(stream, "public:\n\n");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "protected:\n\n");
+	}
 	TreeCCStreamPrint(stream, "\tvirtual ~%s();\n\n", node->name);
 
 	/* Output the class footer */
@@ -398,6 +687,32 @@ static void DeclareNonVirtuals(TreeCCContext *context,
 	}
 	TreeCCStreamPrint(stream, ");\n");
 
+	/* Output the prototype for the batch entry point */
+	if(TreeCCIsBatchOperation(context, oper))
+	{
+		if(oper->className)
+		{
+			TreeCCStreamPrint(stream, "\tstatic ");
+		}
+		TreeCCDeclareBatch(context, stream, oper);
+	}
+
+	/* Output the prototype for the helper that computes the result
+	   of a memoized operation, which is a member of the class */
+	if(oper->className && (oper->flags & TREECC_OPER_MEMOIZE) != 0)
+	{
+		TreeCCStreamPrint(stream, "\tstatic %s %s_compute__(%s ",
+						  oper->returnType, oper->name, oper->params->type);
+		if(oper->params->name)
+		{
+			TreeCCStreamPrint(stream, "%s);\n", oper->params->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "P1__);\n");
+		}
+	}
+
 	/* Output a class footer if the operation is inside a class */
 	if(oper->className)
 	{
@@ -455,7 +770,7 @@ static int InheritParamsSource(TreeCCContext *context, TreeCCStream *stream,
 			{
 				TreeCCStreamPrint(stream, ", ");
 			}
-			TreeCCStreamPrint(stream, "%s", field->name);
+			FieldArgument(context, stream, field);
 			needComma = 1;
 		}
 		field = field->next;
@@ -503,6 +818,64 @@ static void ImplementConstructor(TreeCCContext *context, TreeCCStream *stream,
 		TreeCCStreamPrint(stream, ")\n");
 	}
 
+	/* Construct the fields with the state as their memory resource */
+	if(UsePropagateResource(context))
+	{
+		const char *sep = (node->parent ? "," : ":");
+		const char *resource = (context->reentrant ? "state__" : 0);
+		field = node->fields;
+		while(field != 0)
+		{
+			TreeCCStreamPrint(stream, "\t%s %s(%s::construct__<%s>(",
+							  sep, field->name, context->state_type,
+							  field->type);
+			if(resource)
+			{
+				TreeCCStreamPrint(stream, "%s", resource);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "%s::getState()",
+								  context->state_type);
+			}
+			if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+			{
+				TreeCCStreamPrint(stream, ", ");
+				FieldArgument(context, stream, field);
+			}
+			else if(field->value && *(field->value) != '\0')
+			{
+				TreeCCStreamPrint(stream, ", %s", field->value);
+			}
+			TreeCCStreamPrint(stream, "))\n");
+			sep = ",";
+			field = field->next;
+		}
+	}
+	else if(context->move_fields)
+	{
+		/* Move the parameters into the fields */
+		const char *sep = (node->parent ? "," : ":");
+		field = node->fields;
+		while(field != 0)
+		{
+			if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+			{
+				TreeCCStreamPrint(stream, "\t%s %s(", sep, field->name);
+				FieldArgument(context, stream, field);
+				TreeCCStreamPrint(stream, ")\n");
+				sep = ",";
+			}
+			else if(field->value && *(field->value) != '\0')
+			{
+				TreeCCStreamPrint(stream, "\t%s %s(%s)\n",
+								  sep, field->name, field->value);
+				sep = ",";
+			}
+			field = field->next;
+		}
+	}
+
 	/* Output the beginning of the function body */
 	TreeCCStreamPrint(stream, "{\n");
 
@@ -530,8 +903,16 @@ static void ImplementConstructor(TreeCCContext *context, TreeCCStream *stream,
 		}
 	}
 
-	/* Initialize the fields that are specific to this node type */
-	field = node->fields;
+	/* Initialize the fields that are specific to this node type,
+	   unless they were already constructed by the initializer list */
+	if(UsePropagateResource(context) || context->move_fields)
+	{
+		field = 0;
+	}
+	else
+	{
+		field = node->fields;
+	}
 	while(field != 0)
 	{
 		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
@@ -547,102 +928,496 @@ static void ImplementConstructor(TreeCCContext *context, TreeCCStream *stream,
 		field = field->next;
 	}
 
+	/* Register the finalizer that destroys the fields */
+	if(UseFinalizers(context))
+	{
+		RegisterFinalizer(context, stream, node, "this", "\t");
+	}
+
 	/* Output the constructor function footer */
 	TreeCCStreamPrint(stream, "}\n\n");
 }
 
 /*
- * Implement the virtual methods that have implementations in a node type.
+ * Output the implementation of the constructor that copies a node
+ * for "clone", constructing the fields with the memory resource.
  */
-static void ImplementVirtuals(TreeCCContext *context, TreeCCStream *stream,
-							  TreeCCNode *node, TreeCCNode *actualNode)
+static void ImplementCloneConstructor(TreeCCContext *context,
+									  TreeCCStream *stream, TreeCCNode *node)
 {
-	TreeCCVirtual *virt;
-	TreeCCParam *param;
-	TreeCCOperationCase *operCase;
-	TreeCCOperation *oper;
-	int num, first;
-	int needComma;
+	TreeCCField *field;
+	const char *sep;
+
+	/* Output the constructor function header */
+	TreeCCStreamPrint(stream, "%s::%s(const %s &other__, %s *state__)\n",
+					  node->name, node->name, node->name,
+					  context->state_type);
+
+	/* Copy the parent class, and then the fields of this class */
 	if(node->parent)
 	{
-		ImplementVirtuals(context, stream, node->parent, actualNode);
+		TreeCCStreamPrint(stream, "\t: %s(other__, state__)\n",
+						  node->parent->name);
+		sep = ",";
 	}
-	virt = node->virtuals;
-	while(virt != 0)
+	else if(context->baseType)
 	{
-		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
-		if(!operCase)
+		TreeCCStreamPrint(stream, "\t: %s(other__)\n", context->baseType);
+		sep = ",";
+	}
+	else
+	{
+		sep = ":";
+	}
+	field = node->fields;
+	while(field != 0)
+	{
+		TreeCCStreamPrint(stream,
+						  "\t%s %s(%s::construct__<%s>(state__, other__.%s))\n",
+						  sep, field->name, context->state_type,
+						  field->type, field->name);
+		sep = ",";
+		field = field->next;
+	}
+
+	/* The root class copies the node kind and position */
+	TreeCCStreamPrint(stream, "{\n");
+	if(!(node->parent))
+	{
+		TreeCCStreamPrint(stream, "\tthis->kind__ = other__.kind__;\n");
+		if(context->track_lines)
 		{
-			/* We don't have a direct implementation in this class */
-			virt = virt->next;
-			continue;
+			TreeCCStreamPrint(stream,
+					"\tthis->filename__ = other__.filename__;\n");
+			TreeCCStreamPrint(stream,
+					"\tthis->linenum__ = other__.linenum__;\n");
 		}
-		TreeCCStreamPrint(stream, "%s %s::%s(", virt->returnType,
-						  actualNode->name, virt->name);
-		oper = operCase->oper;
-		param = oper->params;
-		needComma = 0;
-		num = 1;
-		first = 1;
-		while(param != 0)
-		{
-			if(needComma)
-			{
-				TreeCCStreamPrint(stream, ", ");
-			}
-			if(first)
-			{
-				/* Skip the first argument, which corresponds to "this" */
-				if(!(param->name))
-				{
-					++num;
-				}
-				first = 0;
-			}
+	}
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
+/*
+ * Register the finalizers for a cloned node, from the root
+ * node type down, in the same order as the constructors.
+ */
+static void CloneFinalizers(TreeCCContext *context, TreeCCStream *stream,
+							TreeCCNode *node)
+{
+	if(node->parent)
+	{
+		CloneFinalizers(context, stream, node->parent);
+	}
+	RegisterFinalizer(context, stream, node, "copy__", "\t\t\t");
+}
+
+/*
+ * Output the cases for a node type and its descendents
+ * within a "clone" method.
+ */
+static void CloneCases(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCNode *node)
+{
+	TreeCCNode *child;
+	TreeCCNode *type;
+	TreeCCField *field;
+
+	/* Output the case for this node type if it is not abstract */
+	if((node->flags & TREECC_NODE_ABSTRACT) == 0)
+	{
+		/* Take a shallow copy of the node with its copy constructor */
+		TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+		TreeCCStreamPrint(stream, "\t\t{\n");
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream,
+					"\t\t\tvoid *buf__ = state__->alloc(sizeof(%s));\n",
+					node->name);
+			TreeCCStreamPrint(stream, "\t\t\tif(buf__ == 0) return 0;\n");
+			if(UseNodeStats(context))
+			{
+				TreeCCStreamPrint(stream,
+						"\t\t\tstate__->count__(%s_kind, sizeof(%s));\n",
+						node->name, node->name);
+			}
+			if(UseCloneConstructor(context))
+			{
+				TreeCCStreamPrint(stream,
+						"\t\t\t%s *copy__ = new (buf__) %s\n"
+						"\t\t\t\t(*static_cast<const %s *>(this), state__);\n",
+						node->name, node->name, node->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+						"\t\t\t%s *copy__ = new (buf__) %s\n"
+						"\t\t\t\t(*static_cast<const %s *>(this));\n",
+						node->name, node->name, node->name);
+			}
+		}
+		else if(UseCloneConstructor(context))
+		{
+			TreeCCStreamPrint(stream,
+					"\t\t\t%s *copy__ = new %s\n"
+					"\t\t\t\t(*static_cast<const %s *>(this), %s::getState());\n",
+					node->name, node->name, node->name, context->state_type);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+					"\t\t\t%s *copy__ = new %s"
+							"(*static_cast<const %s *>(this));\n",
+					node->name, node->name, node->name);
+		}
+
+		/* The copy constructor does not register finalizers */
+		if(UseFinalizers(context))
+		{
+			CloneFinalizers(context, stream, node);
+		}
+
+		/* Replace the node fields with copies of the subtrees */
+		type = node;
+		while(type != 0)
+		{
+			field = type->fields;
+			while(field != 0)
+			{
+				if(IsNodeField(context, field))
+				{
+					TreeCCStreamPrint(stream,
+						"\t\t\tif(copy__->%s != 0 &&\n", field->name);
+					TreeCCStreamPrint(stream,
+						"\t\t\t   (copy__->%s = static_cast<%s>\n"
+						"\t\t\t\t\t(copy__->%s->clone(%s))) == 0)\n",
+						field->name, field->type, field->name,
+						(context->reentrant ? "state__" : ""));
+					TreeCCStreamPrint(stream, "\t\t\t\treturn 0;\n");
+				}
+				field = field->next;
+			}
+			type = type->parent;
+		}
+		TreeCCStreamPrint(stream, "\t\t\treturn copy__;\n");
+		TreeCCStreamPrint(stream, "\t\t}\n");
+	}
+
+	/* Output the cases for the children */
+	child = node->firstChild;
+	while(child != 0)
+	{
+		CloneCases(context, stream, child);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Implement the subtree clone method for a root node type.
+ */
+static void ImplementClone(TreeCCContext *context, TreeCCStream *stream,
+						   TreeCCNode *node)
+{
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "%s *%s::clone(%s *state__) const\n",
+						  node->name, node->name, context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "%s *%s::clone() const\n",
+						  node->name, node->name);
+	}
+	TreeCCStreamPrint(stream, "{\n");
+	TreeCCStreamPrint(stream, "\tswitch(this->kind__)\n");
+	TreeCCStreamPrint(stream, "\t{\n");
+	CloneCases(context, stream, node);
+	TreeCCStreamPrint(stream, "\t\tdefault: break;\n");
+	TreeCCStreamPrint(stream, "\t}\n");
+	TreeCCStreamPrint(stream, "\treturn 0;\n");
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
+/*
+ * Implement a single case of a virtual method.
+ */
+static void ImplementVirtualCase(TreeCCContext *context, TreeCCStream *stream,
+								 TreeCCVirtual *virt,
+								 TreeCCOperationCase *operCase,
+								 TreeCCNode *actualNode, const char *prefix,
+								 const char *suffix)
+{
+	TreeCCParam *param;
+	TreeCCOperation *oper;
+	int num, first;
+	int needComma;
+	TreeCCStreamPrint(stream, "%s%s %s::%s%s(", prefix, virt->returnType,
+					  actualNode->name, virt->name, suffix);
+	oper = operCase->oper;
+	param = oper->params;
+	needComma = 0;
+	num = 1;
+	first = 1;
+	while(param != 0)
+	{
+		if(needComma)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		if(first)
+		{
+			/* Skip the first argument, which corresponds to "this" */
+			if(!(param->name))
+			{
+				++num;
+			}
+			first = 0;
+		}
+		else
+		{
+			if(param->name)
+			{
+				TreeCCStreamPrint(stream, "%s %s",
+								  param->type, param->name);
+			}
 			else
+			{
+				TreeCCStreamPrint(stream, "%s P%d__",
+								  param->type, num);
+				++num;
+			}
+			needComma = 1;
+		}
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, ")\n");
+	if(!(oper->params->name) || !strcmp(oper->params->name, "this"))
+	{
+		/* The first parameter is called "this", so we don't
+		   need to declare it at the head of the function */
+		TreeCCStreamLine(stream, operCase->codeLinenum,
+						 operCase->codeFilename);
+		TreeCCStreamPrint(stream, "{");
+		if(oper->profileIndex >= 0)
+		{
+			/* Count the call on the same line, to keep the line numbers */
+			TreeCCStreamPrint(stream, "%sprofile_hit__(%d, this->kind__);",
+							  context->yy_replacement, oper->profileIndex);
+		}
+		TreeCCStreamCode(stream, operCase->code);
+		TreeCCStreamPrint(stream, "}\n");
+		TreeCCStreamFixLine(stream);
+	}
+	else
+	{
+		/* The first parameter is called something else,
+		   so create a temporary variable to hold "this" */
+	   	TreeCCStreamPrint(stream, "{\n\t%s *%s = this;\n",
+						  actualNode->name, oper->params->name);
+		if(oper->profileIndex >= 0)
+		{
+			TreeCCStreamPrint(stream, "\t%sprofile_hit__(%d, this->kind__);\n",
+							  context->yy_replacement, oper->profileIndex);
+		}
+		TreeCCStreamLine(stream, operCase->codeLinenum,
+						 operCase->codeFilename);
+		TreeCCStreamPrint(stream, "\t{");
+		TreeCCStreamCodeIndent(stream, operCase->code, 1);
+		TreeCCStreamPrint(stream, "}\n");
+		TreeCCStreamFixLine(stream);
+		TreeCCStreamPrint(stream, "}\n");
+	}
+	TreeCCStreamPrint(stream, "\n");
+}
+
+/*
+ * Output the "case" labels for the node types that inherit the
+ * implementation of a switch-dispatched virtual from "node".
+ */
+static int SwitchDispatchLabels(TreeCCContext *context, TreeCCStream *stream,
+								TreeCCVirtual *virt, TreeCCNode *node)
+{
+	TreeCCNode *child;
+	int numLabels = 0;
+	if((node->flags & TREECC_NODE_ABSTRACT) == 0)
+	{
+		TreeCCStreamPrint(stream, "\t\tcase %s_kind:\n", node->name);
+		++numLabels;
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		if(!TreeCCOperationFindCase(context, child, virt->name))
+		{
+			numLabels += SwitchDispatchLabels(context, stream, virt, child);
+		}
+		child = child->nextSibling;
+	}
+	return numLabels;
+}
+
+/*
+ * Output the "switch" cases for the implementations of a
+ * switch-dispatched virtual in a node type hierarchy.
+ */
+static void SwitchDispatchCases(TreeCCContext *context, TreeCCStream *stream,
+								TreeCCVirtual *virt, TreeCCNode *node,
+								int *needDefault)
+{
+	TreeCCParam *param;
+	TreeCCNode *child;
+	int num;
+	if(TreeCCOperationFindCase(context, node, virt->name))
+	{
+		if(SwitchDispatchLabels(context, stream, virt, node) > 0)
+		{
+			/* The first case also handles unknown kinds if there
+			   is no default value to return for them */
+			if(*needDefault)
+			{
+				TreeCCStreamPrint(stream, "\t\tdefault:\n");
+				*needDefault = 0;
+			}
+			TreeCCStreamPrint(stream, "\t\t\t");
+			if(strcmp(virt->returnType, "void") != 0)
+			{
+				TreeCCStreamPrint(stream, "return ");
+			}
+			TreeCCStreamPrint(stream, "static_cast<%s *>(this)->%s__(",
+							  node->name, virt->name);
+			param = virt->params;
+			num = 1;
+			while(param != 0)
 			{
 				if(param->name)
 				{
-					TreeCCStreamPrint(stream, "%s %s",
-									  param->type, param->name);
+					TreeCCStreamPrint(stream, "%s", param->name);
 				}
 				else
 				{
-					TreeCCStreamPrint(stream, "%s P%d__",
-									  param->type, num);
+					TreeCCStreamPrint(stream, "P%d__", num);
 					++num;
 				}
-				needComma = 1;
+				param = param->next;
+				if(param)
+				{
+					TreeCCStreamPrint(stream, ", ");
+				}
+			}
+			TreeCCStreamPrint(stream, ");\n");
+			if(!strcmp(virt->returnType, "void"))
+			{
+				TreeCCStreamPrint(stream, "\t\t\tbreak;\n");
 			}
-			param = param->next;
+			TreeCCStreamPrint(stream, "\n");
 		}
-		TreeCCStreamPrint(stream, ")\n");
-		if(!(oper->params->name) || !strcmp(oper->params->name, "this"))
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		SwitchDispatchCases(context, stream, virt, child, needDefault);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Output a case to the header for each implementation of a
+ * switch-dispatched virtual in a node type hierarchy.
+ */
+static void ImplementSwitchVirtualCases(TreeCCContext *context,
+										TreeCCStream *stream,
+										TreeCCVirtual *virt, TreeCCNode *node)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCNode *child;
+	operCase = TreeCCOperationFindCase(context, node, virt->name);
+	if(operCase)
+	{
+		ImplementVirtualCase(context, stream, virt, operCase,
+							 node, "inline ", "__");
+	}
+	child = node->firstChild;
+	while(child != 0)
+	{
+		ImplementSwitchVirtualCases(context, stream, virt, child);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Implement the switch-dispatched virtuals that are declared in a
+ * node type.  The definitions are inline in the header, so that
+ * small operations can be inlined into their callers.
+ */
+static void ImplementSwitchVirtuals(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream = node->header;
+	TreeCCVirtual *virt;
+	int needDefault;
+	virt = node->virtuals;
+	while(virt != 0)
+	{
+		if(!IsSwitchDispatch(virt))
 		{
-			/* The first parameter is called "this", so we don't
-			   need to declare it at the head of the function */
-			TreeCCStreamLine(stream, operCase->codeLinenum,
-							 operCase->codeFilename);
-			TreeCCStreamPrint(stream, "{");
-			TreeCCStreamCode(stream, operCase->code);
-			TreeCCStreamPrint(stream, "}\n");
-			TreeCCStreamFixLine(stream);
+			virt = virt->next;
+			continue;
 		}
-		else
+
+		/* Output the implementations of the cases */
+		ImplementSwitchVirtualCases(context, stream, virt, node);
+
+		/* Output the entry point, which switches on the node kind */
+		TreeCCStreamPrint(stream, "inline %s %s::%s(",
+						  virt->returnType, node->name, virt->name);
+		DeclareVirtualParams(context, stream, virt);
+		TreeCCStreamPrint(stream, ")\n{\n");
+		TreeCCStreamPrint(stream, "\tswitch(this->kind__)\n\t{\n");
+		needDefault = (strcmp(virt->returnType, "void") != 0 &&
+					   virt->oper->defValue == 0);
+		SwitchDispatchCases(context, stream, virt, node, &needDefault);
+		if(strcmp(virt->returnType, "void") == 0 || virt->oper->defValue)
 		{
-			/* The first parameter is called something else,
-			   so create a temporary variable to hold "this" */
-		   	TreeCCStreamPrint(stream, "{\n\t%s *%s = this;\n",
-							  actualNode->name, oper->params->name);
-			TreeCCStreamLine(stream, operCase->codeLinenum,
-							 operCase->codeFilename);
-			TreeCCStreamPrint(stream, "\t{");
-			TreeCCStreamCodeIndent(stream, operCase->code, 1);
-			TreeCCStreamPrint(stream, "}\n");
-			TreeCCStreamFixLine(stream);
-			TreeCCStreamPrint(stream, "}\n");
+			TreeCCStreamPrint(stream, "\t\tdefault: break;\n");
 		}
-		TreeCCStreamPrint(stream, "\n");
+		TreeCCStreamPrint(stream, "\t}\n");
+		if(virt->oper->defValue)
+		{
+			TreeCCStreamPrint(stream, "\treturn (%s);\n",
+							  virt->oper->defValue);
+		}
+		else if(needDefault)
+		{
+			/* There are no implementations at all */
+			TreeCCStreamPrint(stream, "\treturn %s();\n", virt->returnType);
+		}
+		TreeCCStreamPrint(stream, "}\n\n");
+		virt = virt->next;
+	}
+}
+
+/*
+ * Implement the virtual methods that have implementations in a node type.
+ */
+static void ImplementVirtuals(TreeCCContext *context, TreeCCStream *stream,
+							  TreeCCNode *node, TreeCCNode *actualNode)
+{
+	TreeCCVirtual *virt;
+	TreeCCOperationCase *operCase;
+	if(node->parent)
+	{
+		ImplementVirtuals(context, stream, node->parent, actualNode);
+	}
+	virt = node->virtuals;
+	while(virt != 0)
+	{
+		operCase = TreeCCOperationFindCase(context, actualNode, virt->name);
+		if(!operCase || IsSwitchDispatch(virt))
+		{
+			/* We don't have a direct implementation in this class,
+			   or the implementation is inline in the header file */
+			virt = virt->next;
+			continue;
+		}
+		ImplementVirtualCase(context, stream, virt, operCase,
+							 actualNode, "", "");
 		virt = virt->next;
 	}
 }
@@ -666,6 +1441,33 @@ static void ImplementNodeTypes(TreeCCContext *context, TreeCCNode *node)
 		TreeCCStreamPrint(stream, "void *%s::operator new(size_t size__)\n",
 						  node->name);
 		TreeCCStreamPrint(stream, "{\n");
+		if(UseNodeStats(context) && (node->flags & TREECC_NODE_ABSTRACT) == 0)
+		{
+			TreeCCStreamPrint(stream,
+					"\t%s::getState()->count__(%s_kind, size__);\n",
+					context->state_type, node->name);
+		}
+		TreeCCStreamPrint(stream, "\treturn %s::getState()->alloc(size__);\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "}\n\n");
+		TreeCCStreamPrint(stream,
+				"void %s::operator delete(void *ptr__, size_t size__)\n",
+						  node->name);
+		TreeCCStreamPrint(stream, "{\n");
+		TreeCCStreamPrint(stream, "\t%s::getState()->dealloc(ptr__, size__);\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "}\n\n");
+	}
+	else if(UseNodeStats(context) && !(context->reentrant) &&
+			(node->flags & TREECC_NODE_ABSTRACT) == 0)
+	{
+		/* Count allocations of this type for the statistics */
+		TreeCCStreamPrint(stream, "void *%s::operator new(size_t size__)\n",
+						  node->name);
+		TreeCCStreamPrint(stream, "{\n");
+		TreeCCStreamPrint(stream,
+				"\t%s::getState()->count__(%s_kind, size__);\n",
+				context->state_type, node->name);
 		TreeCCStreamPrint(stream, "\treturn %s::getState()->alloc(size__);\n",
 						  context->state_type);
 		TreeCCStreamPrint(stream, "}\n\n");
@@ -680,32 +1482,90 @@ static void ImplementNodeTypes(TreeCCContext *context, TreeCCNode *node)
 
 	/* Implement the constructor */
 	ImplementConstructor(context, stream, node);
+	if(UseCloneConstructor(context))
+	{
+		ImplementCloneConstructor(context, stream, node);
+	}
 
 	/* Implement the destructor */
 	TreeCCStreamPrint(stream, "%s::~%s()\n", node->name, node->name);
 	TreeCCStreamPrint(stream, "{\n");
-	TreeCCStreamPrint(stream, "\t// not used\n");
+	if(UseFinalizers(context) && !(node->parent) && !(context->reentrant))
+	{
+		/* Cancel the finalizers of a node that is deleted */
+		TreeCCStreamPrint(stream,
+				"\t%s::getState()->unfinalize__(this->finalizers__);\n",
+				context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "\t// not used\n");
+	}
 	TreeCCStreamPrint(stream, "}\n\n");
 
+	/* Implement the finalizer, which destroys the fields that are
+	   declared in this node type in the reverse order of declaration */
+	if(UseFinalizers(context) && node->fields)
+	{
+		TreeCCField *field;
+		int numFields = 0;
+		int index;
+		TreeCCStreamPrint(stream, "void %s::finalize__(void *node__)\n",
+						  node->name);
+		TreeCCStreamPrint(stream, "{\n");
+		TreeCCStreamPrint(stream,
+				"\t%s *self__ = static_cast<%s *>(node__);\n",
+				node->name, node->name);
+		for(field = node->fields; field != 0; field = field->next)
+		{
+			++numFields;
+		}
+		while(numFields > 0)
+		{
+			--numFields;
+			field = node->fields;
+			for(index = 0; index < numFields; ++index)
+			{
+				field = field->next;
+			}
+			TreeCCStreamPrint(stream, "\t%s::destroy__(self__->%s);\n",
+							  context->state_type, field->name);
+		}
+		TreeCCStreamPrint(stream, "}\n\n");
+	}
+
 	/* Implement the virtual methods that reside in this node type */
 	ImplementVirtuals(context, stream, node, node);
 
 	/* Implement the "isA" helper method */
-	TreeCCStreamPrint(stream, "int %s::isA(int kind) const\n", node->name);
-	TreeCCStreamPrint(stream, "{\n");
-	TreeCCStreamPrint(stream, "\tif(kind == %s_kind)\n", node->name);
-	TreeCCStreamPrint(stream, "\t\treturn 1;\n");
-	TreeCCStreamPrint(stream, "\telse\n");
-	if(node->parent)
+	if(context->kind_ranges)
 	{
-		TreeCCStreamPrint(stream, "\t\treturn %s::isA(kind);\n",
-						  node->parent->name);
+		if(!(node->parent))
+		{
+			TreeCCStreamPrint(stream, "const int %s::lastKinds__[%d] = {",
+							  node->name, node->lastNumber - node->number + 1);
+			TreeCCGenerateLastKinds(stream, node, "\t");
+			TreeCCStreamPrint(stream, "};\n\n");
+		}
 	}
 	else
 	{
-		TreeCCStreamPrint(stream, "\t\treturn 0;\n");
+		TreeCCStreamPrint(stream, "int %s::isA(int kind) const\n", node->name);
+		TreeCCStreamPrint(stream, "{\n");
+		TreeCCStreamPrint(stream, "\tif(kind == %s_kind)\n", node->name);
+		TreeCCStreamPrint(stream, "\t\treturn 1;\n");
+		TreeCCStreamPrint(stream, "\telse\n");
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "\t\treturn %s::isA(kind);\n",
+							  node->parent->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\t\treturn 0;\n");
+		}
+		TreeCCStreamPrint(stream, "}\n\n");
 	}
-	TreeCCStreamPrint(stream, "}\n\n");
 
 	/* Implement the "getKindName" helper method */
 	TreeCCStreamPrint(stream, "const char *%s::getKindName() const\n",
@@ -713,6 +1573,12 @@ static void ImplementNodeTypes(TreeCCContext *context, TreeCCNode *node)
 	TreeCCStreamPrint(stream, "{\n");
 	TreeCCStreamPrint(stream, "\treturn \"%s\";\n", node->name);
 	TreeCCStreamPrint(stream, "}\n\n");
+
+	/* Implement the subtree clone method in the root node type */
+	if(context->clone_nodes && !(node->parent))
+	{
+		ImplementClone(context, stream, node);
+	}
 }
 
 /*
@@ -799,13 +1665,94 @@ static void DeclareCreateFuncs(TreeCCContext *context, TreeCCNode *node)
 	}
 }
 
+/*
+ * Declare the free function for a root node type.
+ */
+static void DeclareFreeFuncs(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream;
+
+	/* Ignore if this is an enumerated type node or not a root */
+	if((node->flags & (TREECC_NODE_ENUM | TREECC_NODE_ENUM_VALUE)) != 0 ||
+	   node->parent)
+	{
+		return;
+	}
+
+	/* Determine which stream to write to */
+	if(context->commonHeader)
+	{
+		stream = context->commonHeader;
+	}
+	else
+	{
+		stream = context->headerStream;
+	}
+
+	/* Output the function definition */
+	TreeCCStreamPrint(stream, "\tvoid nodeFree(%s *node__);\n", node->name);
+}
+
 /*
  * Declare the state type in the header stream.
  */
 static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 {
+	/* Enable the allocation statistics and free lists if necessary */
+	if(UseNodeStats(context))
+	{
+		TreeCCStreamPrint(stream, "#define %s_STATS 1\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#define %s_NUM_KINDS %d\n\n",
+						  context->state_type, context->nodeNumber);
+	}
+	if(UseFreeLists(context))
+	{
+		TreeCCStreamPrint(stream, "#define %s_FREE_LISTS 1\n\n",
+						  context->state_type);
+	}
+
+	/* Storage class for the per-thread singleton instance */
+	if(UseThreadLocalState(context))
+	{
+		TreeCCStreamPrint(stream, "#ifndef %s_THREAD_LOCAL\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#if __cplusplus >= 201103L\n");
+		TreeCCStreamPrint(stream, "#define %s_THREAD_LOCAL thread_local\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#elif defined(_MSC_VER)\n");
+		TreeCCStreamPrint(stream,
+						  "#define %s_THREAD_LOCAL __declspec(thread)\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#else\n");
+		TreeCCStreamPrint(stream, "#define %s_THREAD_LOCAL __thread\n",
+						  context->state_type);
+		TreeCCStreamPrint(stream, "#endif\n");
+		TreeCCStreamPrint(stream, "#endif\n\n");
+	}
+
+	if(UseMemoryResource(context))
+	{
+		TreeCCStreamPrint(stream, "#define %s_MEMORY_RESOURCE 1\n\n",
+						  context->state_type);
+	}
+	if(UseFinalizers(context))
+	{
+		TreeCCStreamPrint(stream, "#define %s_FINALIZERS 1\n\n",
+						  context->state_type);
+	}
+
 	/* Declare the class header */
-	TreeCCStreamPrint(stream, "class %s\n{\n", context->state_type);
+	if(UseMemoryResource(context))
+	{
+		TreeCCStreamPrint(stream,
+				"class %s : public std::pmr::memory_resource\n{\n",
+				context->state_type);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "class %s\n{\n", context->state_type);
+	}
 
 	/* Declare the constructor and destructor */
 	TreeCCStreamPrint(stream, "public:\n\n");
@@ -817,6 +1764,10 @@ static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 	{
 		TreeCCIncludeSkeleton(context, stream, "cpp_gc_skel.h");
 	}
+	else if(UseSharedAllocator(context))
+	{
+		TreeCCIncludeSkeleton(context, stream, "cpp_shared_skel.h");
+	}
 	else
 	{
 		TreeCCIncludeSkeleton(context, stream, "cpp_skel.h");
@@ -826,8 +1777,17 @@ static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 	if(!(context->reentrant))
 	{
 		TreeCCStreamPrint(stream, "private:\n\n");
-		TreeCCStreamPrint(stream, "\tstatic %s *state__;\n\n",
-						  context->state_type);
+		if(UseThreadLocalState(context))
+		{
+			TreeCCStreamPrint(stream,
+							  "\tstatic %s_THREAD_LOCAL %s *state__;\n\n",
+							  context->state_type, context->state_type);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\tstatic %s *state__;\n\n",
+							  context->state_type);
+		}
 		TreeCCStreamPrint(stream, "public:\n\n");
 		TreeCCStreamPrint(stream, "\tstatic %s *getState()\n",
 						  context->state_type);
@@ -837,6 +1797,24 @@ static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 						  context->state_type);
 		TreeCCStreamPrint(stream, "\t\t\treturn state__;\n");
 		TreeCCStreamPrint(stream, "\t\t}\n\n");
+
+		/* Explicit control over the calling thread's instance */
+		if(UseThreadLocalState(context))
+		{
+			TreeCCStreamPrint(stream, "\tstatic %s *install(%s *state)\n",
+							  context->state_type, context->state_type);
+			TreeCCStreamPrint(stream, "\t\t{\n");
+			TreeCCStreamPrint(stream, "\t\t\t%s *prev__ = state__;\n",
+							  context->state_type);
+			TreeCCStreamPrint(stream, "\t\t\tstate__ = state;\n");
+			TreeCCStreamPrint(stream, "\t\t\treturn prev__;\n");
+			TreeCCStreamPrint(stream, "\t\t}\n\n");
+			TreeCCStreamPrint(stream, "\tstatic %s *uninstall()\n",
+							  context->state_type);
+			TreeCCStreamPrint(stream, "\t\t{\n");
+			TreeCCStreamPrint(stream, "\t\t\treturn install(0);\n");
+			TreeCCStreamPrint(stream, "\t\t}\n\n");
+		}
 	}
 
 	/* Declare the create functions for all of the node types */
@@ -845,6 +1823,11 @@ static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 		TreeCCStreamPrint(stream, "public:\n\n");
 		TreeCCNodeVisitAll(context, DeclareCreateFuncs);
 		TreeCCStreamPrint(stream, "\n");
+		if(UseFreeLists(context))
+		{
+			TreeCCNodeVisitAll(context, DeclareFreeFuncs);
+			TreeCCStreamPrint(stream, "\n");
+		}
 	}
 
 	/* Declare the node pool handling functions */
@@ -853,7 +1836,12 @@ static void DeclareStateType(TreeCCContext *context, TreeCCStream *stream)
 	TreeCCStreamPrint(stream, "\tvoid dealloc(void *, size_t);\n");
 	TreeCCStreamPrint(stream, "\tint push();\n");
 	TreeCCStreamPrint(stream, "\tvoid pop();\n");
+	TreeCCStreamPrint(stream, "\tMark mark() const;\n");
+	TreeCCStreamPrint(stream, "\tvoid rollback(const Mark &);\n");
+	TreeCCStreamPrint(stream, "\tvoid commit(const Mark &);\n");
+	TreeCCStreamPrint(stream, "\tvoid adopt(%s *);\n", context->state_type);
 	TreeCCStreamPrint(stream, "\tvoid clear();\n");
+	TreeCCStreamPrint(stream, "\tvoid trim();\n");
 
 	/* Declare the "failed" method for out of memory error reporting */
 	TreeCCStreamPrint(stream, "\tvirtual void failed();\n");
@@ -891,7 +1879,7 @@ static int FactoryInvokeParams(TreeCCContext *context, TreeCCStream *stream,
 			{
 				TreeCCStreamPrint(stream, ", ");
 			}
-			TreeCCStreamPrint(stream, "%s", field->name);
+			FieldArgument(context, stream, field);
 			needComma = 1;
 		}
 		field = field->next;
@@ -944,6 +1932,14 @@ static void ImplementCreateFuncs(TreeCCContext *context, TreeCCNode *node)
 	/* Bail out to the caller if "alloc" returned NULL */
 	TreeCCStreamPrint(stream, "\tif(buf__ == 0) return 0;\n");
 
+	/* Count the node for the allocation statistics */
+	if(UseNodeStats(context))
+	{
+		TreeCCStreamPrint(stream,
+				"\tthis->count__(%s_kind, sizeof(%s));\n",
+				node->name, node->name);
+	}
+
 	/* Invoke the constructor and return the node to the caller */
 	TreeCCStreamPrint(stream, "\treturn new (buf__) %s(this", node->name);
 	FactoryInvokeParams(context, stream, node, 1);
@@ -951,6 +1947,77 @@ static void ImplementCreateFuncs(TreeCCContext *context, TreeCCNode *node)
 	TreeCCStreamPrint(stream, "}\n\n");
 }
 
+/*
+ * Output the cases for a node type and its descendents
+ * within a "nodeFree" method.
+ */
+static void FreeFuncCases(TreeCCContext *context, TreeCCStream *stream,
+						  TreeCCNode *node)
+{
+	TreeCCNode *child;
+
+	/* Output the case for this node type if it is not abstract */
+	if((node->flags & TREECC_NODE_ABSTRACT) == 0)
+	{
+		TreeCCStreamPrint(stream,
+				"\t\tcase %s_kind: size__ = sizeof(%s); break;\n",
+				node->name, node->name);
+	}
+
+	/* Output the cases for the children */
+	child = node->firstChild;
+	while(child != 0)
+	{
+		FreeFuncCases(context, stream, child);
+		child = child->nextSibling;
+	}
+}
+
+/*
+ * Implement the free function for a root node type.
+ */
+static void ImplementFreeFuncs(TreeCCContext *context, TreeCCNode *node)
+{
+	TreeCCStream *stream;
+
+	/* Ignore if this is an enumerated type node or not a root */
+	if((node->flags & (TREECC_NODE_ENUM | TREECC_NODE_ENUM_VALUE)) != 0 ||
+	   node->parent)
+	{
+		return;
+	}
+
+	/* Determine which stream to write to */
+	if(context->commonSource)
+	{
+		stream = context->commonSource;
+	}
+	else
+	{
+		stream = context->sourceStream;
+	}
+
+	/* Determine the size of the node from its kind, then
+	   destroy it and return its memory to the free lists */
+	TreeCCStreamPrint(stream, "void %s::nodeFree(%s *node__)\n",
+					  context->state_type, node->name);
+	TreeCCStreamPrint(stream, "{\n");
+	TreeCCStreamPrint(stream, "\tsize_t size__;\n");
+	TreeCCStreamPrint(stream, "\tswitch(node__->getKind())\n");
+	TreeCCStreamPrint(stream, "\t{\n");
+	FreeFuncCases(context, stream, node);
+	TreeCCStreamPrint(stream, "\t\tdefault: return;\n");
+	TreeCCStreamPrint(stream, "\t}\n");
+	if(UseFinalizers(context))
+	{
+		TreeCCStreamPrint(stream,
+				"\tthis->unfinalize__(node__->finalizers__);\n");
+	}
+	TreeCCStreamPrint(stream, "\tnode__->~%s();\n", node->name);
+	TreeCCStreamPrint(stream, "\tthis->dealloc(node__, size__);\n");
+	TreeCCStreamPrint(stream, "}\n\n");
+}
+
 /*
  * Implement the state type in the source stream.
  */
@@ -962,6 +2029,21 @@ static void ImplementStateType(TreeCCContext *context, TreeCCStream *stream)
 		TreeCCStreamPrint(stream, "#define %s_BLKSIZ %d\n",
 						  context->state_type, context->block_size);
 	}
+	if(context->block_cache)
+	{
+		TreeCCStreamPrint(stream, "#define %s_CACHE %d\n",
+						  context->state_type, context->block_cache);
+	}
+	if(context->max_block_size)
+	{
+		TreeCCStreamPrint(stream, "#define %s_MAXBLKSIZ %d\n",
+						  context->state_type, context->max_block_size);
+	}
+	if(context->mmap_threshold)
+	{
+		TreeCCStreamPrint(stream, "#define %s_MMAP_THRESHOLD %d\n",
+						  context->state_type, context->mmap_threshold);
+	}
 	if(context->reentrant)
 	{
 		TreeCCStreamPrint(stream, "#define %s_REENTRANT 1\n",
@@ -981,6 +2063,10 @@ static void ImplementStateType(TreeCCContext *context, TreeCCStream *stream)
 	{
 		TreeCCIncludeSkeleton(context, stream, "cpp_gc_skel.cc");
 	}
+	else if(UseSharedAllocator(context))
+	{
+		TreeCCIncludeSkeleton(context, stream, "cpp_shared_skel.cc");
+	}
 	else
 	{
 		TreeCCIncludeSkeleton(context, stream, "cpp_skel.cc");
@@ -991,6 +2077,12 @@ static void ImplementStateType(TreeCCContext *context, TreeCCStream *stream)
 	{
 		TreeCCNodeVisitAll(context, ImplementCreateFuncs);
 	}
+
+	/* Implement the free functions for all of the root node types */
+	if(context->reentrant && UseFreeLists(context))
+	{
+		TreeCCNodeVisitAll(context, ImplementFreeFuncs);
+	}
 }
 
 /*
@@ -1006,12 +2098,55 @@ static void WriteCPPHeaders(TreeCCContext *context)
 			TreeCCStreamHeaderTop(stream);
 			TreeCCStreamPrint(stream, "\n");
 			TreeCCStreamPrint(stream, "#include <new>\n");
+			if(context->batch_operations)
+			{
+				TreeCCStreamPrint(stream, "#include <stddef.h>\n");
+			}
+			if(UseSharedAllocator(context))
+			{
+				TreeCCStreamPrint(stream, "#include <atomic>\n");
+			}
+			if(UseMemoryResource(context))
+			{
+				TreeCCStreamPrint(stream, "#include <memory_resource>\n");
+				TreeCCStreamPrint(stream, "#include <type_traits>\n");
+				TreeCCStreamPrint(stream, "#include <utility>\n");
+			}
+			else
+			{
+				if(UseFinalizers(context))
+				{
+					TreeCCStreamPrint(stream, "#include <type_traits>\n");
+				}
+				if(context->move_fields)
+				{
+					TreeCCStreamPrint(stream, "#include <utility>\n");
+				}
+			}
 			TreeCCStreamPrint(stream, "\n");
 		}
 		else
 		{
 			TreeCCStreamSourceTop(stream);
 			TreeCCStreamPrint(stream, "\n");
+			if(context->mmap_threshold && context->use_allocator &&
+			   !(context->use_gc_allocator) && !UseSharedAllocator(context))
+			{
+				/* The skeleton maps large blocks with "mmap" */
+				TreeCCStreamPrint(stream, "#include <sys/mman.h>\n");
+				TreeCCStreamPrint(stream, "\n");
+			}
+			if(context->profile_dispatch || context->batch_operations)
+			{
+				/* The profile is written with "fprintf" at exit, and
+				   batch entry points sort the nodes with "malloc" */
+				if(context->profile_dispatch)
+				{
+					TreeCCStreamPrint(stream, "#include <stdio.h>\n");
+				}
+				TreeCCStreamPrint(stream, "#include <stdlib.h>\n");
+				TreeCCStreamPrint(stream, "\n");
+			}
 		}
 		if(context->namespace)
 		{
@@ -1074,24 +2209,37 @@ void TreeCCGenerateCPP(TreeCCContext *context)
 	if(context->commonHeader)
 	{
 		DeclareStateType(context, context->commonHeader);
+		TreeCCDeclareProfile(context, context->commonHeader);
+		TreeCCDeclareMemo(context, context->commonHeader,
+						  UseThreadLocalState(context));
 	}
 	else
 	{
 		DeclareStateType(context, context->headerStream);
+		TreeCCDeclareProfile(context, context->headerStream);
+		TreeCCDeclareMemo(context, context->headerStream,
+						  UseThreadLocalState(context));
 	}
 	TreeCCNodeVisitAll(context, BuildTypeDecls);
 	TreeCCStreamPrint(context->headerStream, "\n");
 	TreeCCOperationVisitAll(context, DeclareNonVirtuals);
 	TreeCCStreamPrint(context->headerStream, "\n");
+	TreeCCNodeVisitAll(context, ImplementSwitchVirtuals);
 
 	/* Implement the state type */
 	if(context->commonSource)
 	{
 		ImplementStateType(context, context->commonSource);
+		TreeCCImplementProfile(context, context->commonSource);
+		TreeCCImplementMemo(context, context->commonSource,
+							UseThreadLocalState(context));
 	}
 	else
 	{
 		ImplementStateType(context, context->sourceStream);
+		TreeCCImplementProfile(context, context->sourceStream);
+		TreeCCImplementMemo(context, context->sourceStream,
+							UseThreadLocalState(context));
 	}
 
 	/* Generate the contents of the source stream */
@@ -390,14 +390,35 @@ static void BuildTypeDecls(TreeCCContext *context,
 	/* Declare the kind value */
 	if(node->parent)
 	{
-		TreeCCStreamPrint(stream, "\tpublic new const int KIND = %d;\n\n",
+		TreeCCStreamPrint(stream, "\tpublic new const int KIND = %d;\n",
 						  node->number);
+		if(context->kind_ranges)
+		{
+			/* The kinds of the node type and its descendants */
+			TreeCCStreamPrint(stream,
+							  "\tpublic new const int FIRST_KIND = %d;\n",
+							  node->number);
+			TreeCCStreamPrint(stream,
+							  "\tpublic new const int LAST_KIND = %d;\n",
+							  node->lastNumber);
+		}
 	}
 	else
 	{
-		TreeCCStreamPrint(stream, "\tpublic const int KIND = %d;\n\n",
+		TreeCCStreamPrint(stream, "\tpublic const int KIND = %d;\n",
 						  node->number);
+		if(context->kind_ranges)
+		{
+			/* The kinds of the node type and its descendants */
+			TreeCCStreamPrint(stream,
+							  "\tpublic const int FIRST_KIND = %d;\n",
+							  node->number);
+			TreeCCStreamPrint(stream,
+							  "\tpublic const int LAST_KIND = %d;\n",
+							  node->lastNumber);
+		}
 	}
+	TreeCCStreamPrint(stream, "\n");
 
 	/* Declare the fields */
 	if(node->fields)
@@ -505,28 +526,50 @@ static void BuildTypeDecls(TreeCCContext *context,
 	/* Implement the virtual functions */
 	ImplementVirtuals(context, stream, node, node);
 
-	/* Declare the "isA" and "getKindName" helper methods */
-	if(node->parent)
+	/* Declare the "isA" and "getKindName" helper methods.  With
+	   pre-order kinds, "isA" is a non-virtual method in the root type
+	   that tests against the interval of kinds for "kind" */
+	if(!(context->kind_ranges))
 	{
-		TreeCCStreamPrint(stream, "\tpublic override int isA(int kind)\n");
-	}
-	else
-	{
-		TreeCCStreamPrint(stream, "\tpublic virtual int isA(int kind)\n");
-	}
-	TreeCCStreamPrint(stream, "\t{\n");
-	TreeCCStreamPrint(stream, "\t\tif(kind == KIND)\n");
-	TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
-	TreeCCStreamPrint(stream, "\t\telse\n");
-	if(node->parent)
-	{
-		TreeCCStreamPrint(stream, "\t\t\treturn base.isA(kind);\n");
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "\tpublic override int isA(int kind)\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\tpublic virtual int isA(int kind)\n");
+		}
+		TreeCCStreamPrint(stream, "\t{\n");
+		TreeCCStreamPrint(stream, "\t\tif(kind == KIND)\n");
+		TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
+		TreeCCStreamPrint(stream, "\t\telse\n");
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "\t\t\treturn base.isA(kind);\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\t\t\treturn 0;\n");
+		}
+		TreeCCStreamPrint(stream, "\t}\n\n");
 	}
-	else
+	else if(!(node->parent))
 	{
+		TreeCCStreamPrint(stream,
+				"\tprivate static readonly int[] lastKinds__ = {");
+		TreeCCGenerateLastKinds(stream, node, "\t\t");
+		TreeCCStreamPrint(stream, "\t};\n\n");
+		TreeCCStreamPrint(stream, "\tpublic int isA(int kind)\n");
+		TreeCCStreamPrint(stream, "\t{\n");
+		TreeCCStreamPrint(stream,
+				"\t\tif(kind >= %d && kind <= kind__ &&\n", node->number);
+		TreeCCStreamPrint(stream,
+				"\t\t   kind__ <= lastKinds__[kind - %d])\n", node->number);
+		TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
+		TreeCCStreamPrint(stream, "\t\telse\n");
 		TreeCCStreamPrint(stream, "\t\t\treturn 0;\n");
+		TreeCCStreamPrint(stream, "\t}\n\n");
 	}
-	TreeCCStreamPrint(stream, "\t}\n\n");
 	if(node->parent)
 	{
 		TreeCCStreamPrint(stream, "\tpublic override String getKindName()\n");
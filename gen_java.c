@@ -376,8 +376,19 @@ static void BuildTypeDecls(TreeCCContext *context,
 	}
 
 	/* Declare the kind value */
-	TreeCCStreamPrint(stream, "\tpublic static final int KIND = %d;\n\n",
+	TreeCCStreamPrint(stream, "\tpublic static final int KIND = %d;\n",
 					  node->number);
+	if(context->kind_ranges)
+	{
+		/* The kinds of the node type and its descendants */
+		TreeCCStreamPrint(stream,
+						  "\tpublic static final int FIRST_KIND = %d;\n",
+						  node->number);
+		TreeCCStreamPrint(stream,
+						  "\tpublic static final int LAST_KIND = %d;\n",
+						  node->lastNumber);
+	}
+	TreeCCStreamPrint(stream, "\n");
 
 	/* Declare the fields */
 	if(node->fields)
@@ -491,21 +502,43 @@ static void BuildTypeDecls(TreeCCContext *context,
 	/* Implement the virtual functions */
 	ImplementVirtuals(context, stream, node, node);
 
-	/* Declare the "isA" and "getKindName" helper methods */
-	TreeCCStreamPrint(stream, "\tpublic int isA(int kind)\n");
-	TreeCCStreamPrint(stream, "\t{\n");
-	TreeCCStreamPrint(stream, "\t\tif(kind == KIND)\n");
-	TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
-	TreeCCStreamPrint(stream, "\t\telse\n");
-	if(node->parent)
+	/* Declare the "isA" and "getKindName" helper methods.  With
+	   pre-order kinds, "isA" is a final method in the root type that
+	   tests against the interval of kinds for "kind" */
+	if(!(context->kind_ranges))
 	{
-		TreeCCStreamPrint(stream, "\t\t\treturn super.isA(kind);\n");
+		TreeCCStreamPrint(stream, "\tpublic int isA(int kind)\n");
+		TreeCCStreamPrint(stream, "\t{\n");
+		TreeCCStreamPrint(stream, "\t\tif(kind == KIND)\n");
+		TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
+		TreeCCStreamPrint(stream, "\t\telse\n");
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "\t\t\treturn super.isA(kind);\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "\t\t\treturn 0;\n");
+		}
+		TreeCCStreamPrint(stream, "\t}\n\n");
 	}
-	else
+	else if(!(node->parent))
 	{
+		TreeCCStreamPrint(stream,
+				"\tprivate static final int[] LAST_KINDS__ = {");
+		TreeCCGenerateLastKinds(stream, node, "\t\t");
+		TreeCCStreamPrint(stream, "\t};\n\n");
+		TreeCCStreamPrint(stream, "\tpublic final int isA(int kind)\n");
+		TreeCCStreamPrint(stream, "\t{\n");
+		TreeCCStreamPrint(stream,
+				"\t\tif(kind >= %d && kind <= kind__ &&\n", node->number);
+		TreeCCStreamPrint(stream,
+				"\t\t   kind__ <= LAST_KINDS__[kind - %d])\n", node->number);
+		TreeCCStreamPrint(stream, "\t\t\treturn 1;\n");
+		TreeCCStreamPrint(stream, "\t\telse\n");
 		TreeCCStreamPrint(stream, "\t\t\treturn 0;\n");
+		TreeCCStreamPrint(stream, "\t}\n\n");
 	}
-	TreeCCStreamPrint(stream, "\t}\n\n");
 	TreeCCStreamPrint(stream, "\tpublic String getKindName()\n");
 	TreeCCStreamPrint(stream, "\t{\n");
 	TreeCCStreamPrint(stream, "\t\treturn \"%s\";\n", node->name);
@@ -1221,6 +1254,7 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsJava = {
 	Java_GenSplitEntry,
 	Java_GenSwitchHead,
 	Java_GenSelector,
+	0,
 	Java_GenEndSelectors,
 	Java_GenCaseFunc,
 	Java_GenCaseCall,
@@ -1230,6 +1264,8 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsJava = {
 	Java_GenEndSwitch,
 	Java_GenExit,
 	Java_GenEnd,
+	0,
+	0,
 };
 
 /*
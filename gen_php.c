@@ -22,11 +22,68 @@
 #include "input.h"
 #include "info.h"
 #include "gen.h"
+#include "errors.h"
 
 #ifdef	__cplusplus
 extern	"C" {
 #endif
 
+/*
+ * Declare a field as a typed property.  The type is only declared
+ * if it has a PHP equivalent and the constructor assigns the field,
+ * because reading an uninitialized typed property is an error.
+ */
+static void DeclareTypedField(TreeCCContext *context,
+							  TreeCCStream *stream, TreeCCField *field)
+{
+	static const char * const types[] = {
+		"int", "int",
+		"long", "int",
+		"short", "int",
+		"unsigned", "int",
+		"unsigned int", "int",
+		"unsigned long", "int",
+		"size_t", "int",
+		"float", "float",
+		"double", "float",
+		"bool", "bool",
+		"boolean", "bool",
+		"string", "?string",
+		"String", "?string",
+		"char *", "?string",
+		"const char *", "?string",
+		0
+	};
+	TreeCCNode *type;
+	int index;
+
+	TreeCCStreamPrint(stream, "    public ");
+	if((field->flags & TREECC_FIELD_NOCREATE) == 0 || field->value)
+	{
+		type = TreeCCNodeFindByType(context, field->type);
+		if(type && (type->flags & TREECC_NODE_ENUM) != 0)
+		{
+			TreeCCStreamPrint(stream, "int ");
+		}
+		else if(type)
+		{
+			TreeCCStreamPrint(stream, "?%s ", type->name);
+		}
+		else
+		{
+			for(index = 0; types[index] != 0; index += 2)
+			{
+				if(!strcmp(field->type, types[index]))
+				{
+					TreeCCStreamPrint(stream, "%s ", types[index + 1]);
+					break;
+				}
+			}
+		}
+	}
+	TreeCCStreamPrint(stream, "$%s;\n", field->name);
+}
+
 /*
  * Declare the fields for a node type.
  */
@@ -37,8 +94,15 @@ static void DeclareFields(TreeCCContext *context,
 	field = node->fields;
 	while(field != 0)
 	{
-		TreeCCStreamPrint(stream, "    var $%s;\n",
-						  /*field->type, */ field->name);
+		if(context->flat_nodes)
+		{
+			DeclareTypedField(context, stream, field);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "    var $%s;\n",
+							  /*field->type, */ field->name);
+		}
 		field = field->next;
 	}
 }
@@ -287,6 +351,81 @@ static void ImplementVirtuals(TreeCCContext *context, TreeCCStream *stream,
 	}
 }
 
+/*
+ * Assign the fields of a node type and its ancestors directly,
+ * instead of calling the constructors of the ancestor classes.
+ */
+static void InitFields(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCNode *node)
+{
+	TreeCCField *field;
+	if(node->parent)
+	{
+		InitFields(context, stream, node->parent);
+	}
+	field = node->fields;
+	while(field != 0)
+	{
+		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+		{
+			TreeCCStreamPrint(stream, "        $this->%s = $%s;\n",
+							  field->name, field->name);
+		}
+		else if(field->value)
+		{
+			TreeCCStreamPrint(stream, "        $this->%s = %s;\n",
+							  field->name, field->value);
+		}
+		field = field->next;
+	}
+}
+
+/*
+ * Implement a flattened constructor for a node type, which sets
+ * the kind, the position, and every field without calling the
+ * constructor of the parent class.
+ */
+static void ImplementFlatConstructor(TreeCCContext *context,
+									 TreeCCStream *stream, TreeCCNode *node)
+{
+	int needComma;
+	TreeCCStreamPrint(stream, "    function __construct(");
+	if(context->reentrant)
+	{
+		TreeCCStreamPrint(stream, "&$state__");
+		needComma = 1;
+	}
+	else
+	{
+		needComma = 0;
+	}
+	CreateParams(context, stream, node, needComma);
+	TreeCCStreamPrint(stream, ")\n");
+	TreeCCStreamPrint(stream, "    {\n");
+	TreeCCStreamPrint(stream, "        $this->kind__ = %s_KIND;\n", node->name);
+	if(context->track_lines)
+	{
+		if(context->reentrant)
+		{
+			TreeCCStreamPrint(stream,
+					"        $this->filename__ = $state__->currFilename();\n");
+			TreeCCStreamPrint(stream,
+					"        $this->linenum__ = $state__->currLinenum();\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream,
+					"        $_tmp = &%s::getState(); $this->filename__ = $_tmp->currFilename();\n",
+					context->state_type);
+			TreeCCStreamPrint(stream,
+					"        $_tmp = &%s::getState(); $this->linenum__ = $_tmp->currLinenum();\n",
+					context->state_type);
+		}
+	}
+	InitFields(context, stream, node);
+	TreeCCStreamPrint(stream, "    }\n\n");
+}
+
 /*
  * Build the type declarations for a node type.
  */
@@ -328,6 +467,14 @@ static void BuildTypeDecls(TreeCCContext *context,
 		TreeCCStreamPrint(stream, "define('%s_KIND', %d);\n",
 						  node->name,node->number);
 	}
+	if(context->kind_ranges)
+	{
+		/* The kinds of the node type and its descendants */
+		TreeCCStreamPrint(stream, "define('%s_FIRST_KIND', %d);\n",
+						  node->name, node->number);
+		TreeCCStreamPrint(stream, "define('%s_LAST_KIND', %d);\n",
+						  node->name, node->lastNumber);
+	}
 	
 	if(node->parent)
 	{
@@ -357,10 +504,22 @@ static void BuildTypeDecls(TreeCCContext *context,
 		}
 
 		/* Declare the node kind member variable */
-		TreeCCStreamPrint(stream, "    var $kind__;\n");
+		if(context->flat_nodes)
+		{
+			TreeCCStreamPrint(stream, "    public int $kind__;\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "    var $kind__;\n");
+		}
 
 		/* Declare the filename and linenum fields if we are tracking lines */
-		if(context->track_lines)
+		if(context->track_lines && context->flat_nodes)
+		{
+			TreeCCStreamPrint(stream, "    public ?string $filename__;\n");
+			TreeCCStreamPrint(stream, "    public int $linenum__;\n");
+		}
+		else if(context->track_lines)
 		{
 			TreeCCStreamPrint(stream, "    var $filename__;\n");
 			TreeCCStreamPrint(stream, "    var $linenum__;\n");
@@ -397,104 +556,111 @@ static void BuildTypeDecls(TreeCCContext *context,
 	}
 
 	/* Declare the constructor for the node type */
-	if(context->reentrant)
+	if(context->flat_nodes)
 	{
-		/* Re-entrant systems use a factory to create the nodes.
-		   C# doesn't have a notion of "access by members of
-		   the namespace only".  The closest is "internal", but
-		   even that isn't quite right, so we always use "public" */
-		/*constructorAccess = "public "; */
-		constructorAccess = ""; 
+		ImplementFlatConstructor(context, stream, node);
 	}
 	else
 	{
-		/* Non-reentrant systems can construct nodes directly,
-		   unless the node happens to be abstract, in which
-		   case we force the constructor to be protected */
-		if((node->flags & TREECC_NODE_ABSTRACT) != 0)
+		if(context->reentrant)
 		{
-			/* constructorAccess = "protected "; */
-			constructorAccess = "";
+			/* Re-entrant systems use a factory to create the nodes.
+			   C# doesn't have a notion of "access by members of
+			   the namespace only".  The closest is "internal", but
+			   even that isn't quite right, so we always use "public" */
+			/*constructorAccess = "public "; */
+			constructorAccess = ""; 
 		}
 		else
 		{
-			/* constructorAccess = "public "; */
-			constructorAccess = "";
+			/* Non-reentrant systems can construct nodes directly,
+			   unless the node happens to be abstract, in which
+			   case we force the constructor to be protected */
+			if((node->flags & TREECC_NODE_ABSTRACT) != 0)
+			{
+				/* constructorAccess = "protected "; */
+				constructorAccess = "";
+			}
+			else
+			{
+				/* constructorAccess = "public "; */
+				constructorAccess = "";
+			}
 		}
-	}
-	TreeCCStreamPrint(stream, "    function %s%s(", constructorAccess, node->name);
-	if(context->reentrant)
-	{
-		/* TreeCCStreamPrint(stream, "%s state__", context->state_type); */
-		TreeCCStreamPrint(stream, "&$state__"); 
-		needComma = 1;
-	}
-	else
-	{
-		needComma = 0;
-	}
-	CreateParams(context, stream, node, needComma);
-	TreeCCStreamPrint(stream, ")\n");
-	 TreeCCStreamPrint(stream, "    {\n"); 
-	/* Call the parent class constructor */
-	if(node->parent)
-	{
-		TreeCCStreamPrint(stream, "        parent::%s (",node->parent->name);
+		TreeCCStreamPrint(stream, "    function %s%s(", constructorAccess, node->name);
 		if(context->reentrant)
 		{
-			TreeCCStreamPrint(stream, "&$state__");
+			/* TreeCCStreamPrint(stream, "%s state__", context->state_type); */
+			TreeCCStreamPrint(stream, "&$state__"); 
 			needComma = 1;
 		}
 		else
 		{
 			needComma = 0;
 		}
-		InheritParamsSource(context, stream, node->parent, needComma);
-		TreeCCStreamPrint(stream, ");\n");
-	}
+		CreateParams(context, stream, node, needComma);
+		TreeCCStreamPrint(stream, ")\n");
+		 TreeCCStreamPrint(stream, "    {\n"); 
+		/* Call the parent class constructor */
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "        parent::%s (",node->parent->name);
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream, "&$state__");
+				needComma = 1;
+			}
+			else
+			{
+				needComma = 0;
+			}
+			InheritParamsSource(context, stream, node->parent, needComma);
+			TreeCCStreamPrint(stream, ");\n");
+		}
 
-	/* Set the node kind */
+		/* Set the node kind */
 
-	TreeCCStreamPrint(stream, "        $this->kind__ = %s_KIND;\n",node->name);
+		TreeCCStreamPrint(stream, "        $this->kind__ = %s_KIND;\n",node->name);
 
-	/* Track the filename and line number if necessary */
-	if(context->track_lines && !(node->parent))
-	{
-		if(context->reentrant)
-		{
-			TreeCCStreamPrint(stream,
-					"        $this->filename__ = $state__->currFilename();\n");
-			TreeCCStreamPrint(stream,
-					"        $this->linenum__ = $state__->currLinenum();\n");
-		}
-		else
+		/* Track the filename and line number if necessary */
+		if(context->track_lines && !(node->parent))
 		{
-			TreeCCStreamPrint(stream,
-					"        $_tmp = &%s::getState(); $this->filename__ = $_tmp->currFilename();\n",
-					context->state_type);
-			TreeCCStreamPrint(stream,
-					"        $_tmp = &%s::getState(); $this->linenum__ = $_tmp->currLinenum();\n",
-					context->state_type);
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream,
+						"        $this->filename__ = $state__->currFilename();\n");
+				TreeCCStreamPrint(stream,
+						"        $this->linenum__ = $state__->currLinenum();\n");
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+						"        $_tmp = &%s::getState(); $this->filename__ = $_tmp->currFilename();\n",
+						context->state_type);
+				TreeCCStreamPrint(stream,
+						"        $_tmp = &%s::getState(); $this->linenum__ = $_tmp->currLinenum();\n",
+						context->state_type);
+			}
 		}
-	}
 
-	/* Initialize the fields that are specific to this node type */
-	field = node->fields;
-	while(field != 0)
-	{
-		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
-		{
-			TreeCCStreamPrint(stream, "        $this->%s = $%s;\n",
-							  field->name, field->name);
-		}
-		else if(field->value)
+		/* Initialize the fields that are specific to this node type */
+		field = node->fields;
+		while(field != 0)
 		{
-			TreeCCStreamPrint(stream, "        $this->%s = $%s;\n",
-							  field->name, field->value);
+			if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+			{
+				TreeCCStreamPrint(stream, "        $this->%s = $%s;\n",
+								  field->name, field->name);
+			}
+			else if(field->value)
+			{
+				TreeCCStreamPrint(stream, "        $this->%s = $%s;\n",
+								  field->name, field->value);
+			}
+			field = field->next;
 		}
-		field = field->next;
+		TreeCCStreamPrint(stream, "    }\n\n");
 	}
-	TreeCCStreamPrint(stream, "    }\n\n");
 
 	/* Implement the virtual functions */
 	ImplementVirtuals(context, stream, node, node);
@@ -1309,6 +1475,263 @@ static void PHP_GenEnd(TreeCCContext *context, TreeCCStream *stream,
 	}
 }
 
+/*
+ * Determine if any combination of trigger types from "level"
+ * onwards, given the types in "chosen" for the earlier levels,
+ * is handled by a case of an operation.
+ */
+static int PHPTableHasCase(TreeCCOperation *oper, TreeCCNode ***nodes,
+						   int *counts, TreeCCNode **chosen, int level)
+{
+	int index;
+	for(index = 0; index < counts[level]; ++index)
+	{
+		chosen[level] = nodes[level][index];
+		if(level == oper->numTriggers - 1)
+		{
+			if(TreeCCFindTableCase(oper, chosen) != 0)
+			{
+				return 1;
+			}
+		}
+		else if(PHPTableHasCase(oper, nodes, counts, chosen, level + 1))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Output the elements of one level of a dispatch array.  Each level
+ * maps the "KIND" of a trigger to the array for the next trigger, or
+ * to the name of the case function at the last level.
+ */
+static void PHPGenTableLevel(TreeCCStream *stream, TreeCCOperation *oper,
+							 TreeCCNode ***nodes, int *counts,
+							 TreeCCNode **chosen, int level)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCNode *node;
+	int index;
+	for(index = 0; index < counts[level]; ++index)
+	{
+		node = nodes[level][index];
+		chosen[level] = node;
+		if(level == oper->numTriggers - 1)
+		{
+			operCase = TreeCCFindTableCase(oper, chosen);
+			if(!operCase)
+			{
+				continue;
+			}
+		}
+		else if(!PHPTableHasCase(oper, nodes, counts, chosen, level + 1))
+		{
+			continue;
+		}
+		else
+		{
+			operCase = 0;
+		}
+		Indent(stream, level + 2);
+		if((node->flags & TREECC_NODE_ENUM_VALUE) != 0)
+		{
+			TreeCCStreamPrint(stream, "%s_%s => ",
+							  node->parent->name, node->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "%s_KIND => ", node->name);
+		}
+		if(operCase)
+		{
+			TreeCCStreamPrint(stream, "'%s_%d__',\n",
+							  oper->name, operCase->number);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "array(\n");
+			PHPGenTableLevel(stream, oper, nodes, counts, chosen, level + 1);
+			Indent(stream, level + 2);
+			TreeCCStreamPrint(stream, "),\n");
+		}
+	}
+}
+
+/*
+ * Output the name of a parameter within the entry point.
+ */
+static void PHPGenParamName(TreeCCContext *context, TreeCCStream *stream,
+							TreeCCParam *param, int num)
+{
+	if(param->name)
+	{
+		TreeCCStreamPrint(stream, "$%s", param->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "$P%d__", num);
+	}
+	if((param->flags & TREECC_PARAM_TRIGGER) != 0 &&
+	   !IsEnumType(context, param->type))
+	{
+		TreeCCStreamPrint(stream, "__");
+	}
+}
+
+/*
+ * Generate a dispatch table for a non-virtual operation.  The table
+ * is a static array of the operation's class that maps the "KIND" of
+ * each trigger in turn to the name of the case function, so that
+ * dispatch is one array lookup per trigger instead of a sequence
+ * of "case" tests.
+ */
+static int PHP_GenDispatchTable(TreeCCContext *context,
+								TreeCCStream *stream,
+								TreeCCOperation *oper)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	TreeCCNode ***nodes;
+	TreeCCNode **chosen;
+	int *keys;
+	int *counts;
+	int trigger, number, num;
+
+	/* Output a function for each case that does not have one
+	   already, so that every case can be entered in the table */
+	if((oper->flags & TREECC_OPER_INLINE) != 0)
+	{
+		number = 1;
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number >= number)
+			{
+				number = operCase->number + 1;
+			}
+			operCase = operCase->next;
+		}
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number == 0)
+			{
+				PHP_GenCaseFunc(context, stream, operCase, number);
+				operCase->number = number++;
+			}
+			operCase = operCase->next;
+		}
+	}
+
+	/* Collect the node types for each trigger */
+	nodes = (TreeCCNode ***)calloc(oper->numTriggers, sizeof(TreeCCNode **));
+	chosen = (TreeCCNode **)calloc(oper->numTriggers, sizeof(TreeCCNode *));
+	counts = (int *)calloc(oper->numTriggers, sizeof(int));
+	keys = (int *)malloc(sizeof(int) * context->nodeNumber);
+	if(!nodes || !chosen || !counts || !keys)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			type = TreeCCNodeFindByType(context, param->type);
+			nodes[trigger] = (TreeCCNode **)malloc
+					(sizeof(TreeCCNode *) * context->nodeNumber);
+			if(!(nodes[trigger]))
+			{
+				TreeCCOutOfMemory(context->input);
+			}
+			counts[trigger] = TreeCCCollectTableKeys
+				(type, nodes[trigger], keys, 0,
+				 ((type->flags & TREECC_NODE_ENUM) != 0));
+			++trigger;
+		}
+		param = param->next;
+	}
+
+	/* Output the table as a static member of the operation's class */
+	TreeCCStreamPrint(stream, "    static $%s_table__ = array(\n", oper->name);
+	PHPGenTableLevel(stream, oper, nodes, counts, chosen, 0);
+	TreeCCStreamPrint(stream, "    );\n\n");
+	for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+	{
+		free(nodes[trigger]);
+	}
+	free(nodes);
+	free(chosen);
+	free(counts);
+	free(keys);
+
+	/* Output the entry point, which indexes the table with each
+	   trigger in turn and then calls the case function */
+	PHPGenEntry(context, stream, oper, -1);
+	num = 1;
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			if(trigger == 0)
+			{
+				TreeCCStreamPrint(stream, "        $case__ = self::$%s_table__[",
+								  oper->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "        $case__ = $case__[");
+			}
+			PHPGenParamName(context, stream, param, num);
+			if(!IsEnumType(context, param->type))
+			{
+				TreeCCStreamPrint(stream, "->getKind()");
+			}
+			TreeCCStreamPrint(stream, "] ?? null;\n");
+			++trigger;
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, "        if($case__ !== null)\n");
+	TreeCCStreamPrint(stream, "        {\n");
+	TreeCCStreamPrint(stream, "            $_t = __CLASS__; $_t = new $_t;\n");
+	TreeCCStreamPrint(stream, "            ");
+	if(strcmp(oper->returnType, "void") != 0)
+	{
+		TreeCCStreamPrint(stream, "return ");
+	}
+	TreeCCStreamPrint(stream, "$_t->$case__(");
+	num = 1;
+	param = oper->params;
+	while(param != 0)
+	{
+		PHPGenParamName(context, stream, param, num);
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+		if(param != 0)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+	}
+	TreeCCStreamPrint(stream, ");\n");
+	TreeCCStreamPrint(stream, "        }\n");
+	PHP_GenExit(context, stream, oper);
+	return 1;
+}
+
 /*
  * Table of non-virtual code generation functions.
  */
@@ -1318,6 +1741,7 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsPHP = {
 	PHP_GenSplitEntry,
 	PHP_GenSwitchHead,
 	PHP_GenSelector,
+	0,
 	PHP_GenEndSelectors,
 	PHP_GenCaseFunc,
 	PHP_GenCaseCall,
@@ -1327,6 +1751,8 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsPHP = {
 	PHP_GenEndSwitch,
 	PHP_GenExit,
 	PHP_GenEnd,
+	PHP_GenDispatchTable,
+	0,
 };
 
  
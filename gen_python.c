@@ -116,6 +116,51 @@ static int InheritParamsSource(TreeCCContext *context, TreeCCStream *stream,
 	return needComma;
 }
 
+/*
+ * Output the names of the fields of a node type as "__slots__" entries.
+ */
+static int SlotNames(TreeCCContext *context, TreeCCStream *stream,
+					 TreeCCNode *node, int count)
+{
+	TreeCCField *field = node->fields;
+	while(field != 0)
+	{
+		TreeCCStreamPrint(stream, "%s'%s'", (count ? ", " : ""), field->name);
+		++count;
+		field = field->next;
+	}
+	return count;
+}
+
+/*
+ * Initialize the fields of a node type and its ancestors directly,
+ * instead of calling the constructors of the ancestor classes.
+ */
+static void InitFields(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCNode *node)
+{
+	TreeCCField *field;
+	if(node->parent)
+	{
+		InitFields(context, stream, node->parent);
+	}
+	field = node->fields;
+	while(field != 0)
+	{
+		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+		{
+			TreeCCStreamPrint(stream, "        self.%s = %s\n",
+							  field->name, field->name);
+		}
+		else if(field->value)
+		{
+			TreeCCStreamPrint(stream, "        self.%s = %s\n",
+							  field->name, field->value);
+		}
+		field = field->next;
+	}
+}
+
 /*
  * Implement the virtual methods that have implementations in a node type.
  */
@@ -251,6 +296,11 @@ static void BuildTypeDecls(TreeCCContext *context,
 			TreeCCStreamPrint(stream, "class %s (%s):\n",
 							  node->name, context->baseType);
 		}
+		else if(context->flat_nodes)
+		{
+			/* "__slots__" needs a new-style class in Python 2 */
+			TreeCCStreamPrint(stream, "class %s (object):\n", node->name);
+		}
 		else
 		{
 			TreeCCStreamPrint(stream, "class %s:\n", node->name);
@@ -259,6 +309,32 @@ static void BuildTypeDecls(TreeCCContext *context,
 
 	/* Declare the kind value */
 	TreeCCStreamPrint(stream, "    KIND = %d\n", node->number);
+	if(context->kind_ranges)
+	{
+		/* The kinds of the node type and its descendants */
+		TreeCCStreamPrint(stream, "    FIRST_KIND = %d\n", node->number);
+		TreeCCStreamPrint(stream, "    LAST_KIND = %d\n", node->lastNumber);
+	}
+
+	/* Declare the slots for the fields, so that instances do not
+	   need a dictionary.  Each class only lists its own fields */
+	if(context->flat_nodes)
+	{
+		int count = 0;
+		TreeCCStreamPrint(stream, "    __slots__ = (");
+		if(!(node->parent))
+		{
+			TreeCCStreamPrint(stream, "'kind'");
+			++count;
+			if(context->track_lines)
+			{
+				TreeCCStreamPrint(stream, ", 'filename', 'linenum'");
+				count += 2;
+			}
+		}
+		count = SlotNames(context, stream, node, count);
+		TreeCCStreamPrint(stream, "%s)\n", (count == 1 ? "," : ""));
+	}
 
 	/* Declare the constructor for the node type */
 	TreeCCStreamPrint(stream, "    def __init__(self");
@@ -266,42 +342,64 @@ static void BuildTypeDecls(TreeCCContext *context,
 	CreateParams(context, stream, node, needComma);
 	TreeCCStreamPrint(stream, "):\n");
 
-	/* Call the parent class constructor */
-	if(node->parent)
+	/* Flat constructors initialize the inherited fields themselves,
+	   instead of calling the constructors of the ancestor classes */
+	if(context->flat_nodes)
 	{
-		TreeCCStreamPrint(stream, "        %s.__init__(self", node->parent->name);
-		needComma = 1;
-		InheritParamsSource(context, stream, node->parent, needComma);
-		TreeCCStreamPrint(stream, ")\n");
+		TreeCCStreamPrint(stream, "        self.kind = %d\n", node->number);
+		if(context->track_lines)
+		{
+			TreeCCStreamPrint(stream,
+							  "        self.filename = %scurrfilename()\n",
+							  context->yy_replacement);
+			TreeCCStreamPrint(stream,
+							  "        self.linenum = %scurrlinenum()\n",
+							  context->yy_replacement);
+		}
+		InitFields(context, stream, node);
 	}
-
-	/* Set the node kind */
-	TreeCCStreamPrint(stream, "        self.kind = %d\n", node->number);
-
-	/* Track the filename and line number if necessary */
-	if(context->track_lines && !(node->parent))
+	else
 	{
-		TreeCCStreamPrint(stream, "        self.filename = %scurrfilename()\n",
-						  context->yy_replacement);
-		TreeCCStreamPrint(stream, "        self.linenum = %scurrlinenum()\n",
-						  context->yy_replacement);
-	}
+		/* Call the parent class constructor */
+		if(node->parent)
+		{
+			TreeCCStreamPrint(stream, "        %s.__init__(self",
+							  node->parent->name);
+			needComma = 1;
+			InheritParamsSource(context, stream, node->parent, needComma);
+			TreeCCStreamPrint(stream, ")\n");
+		}
 
-	/* Initialize the fields that are specific to this node type */
-	field = node->fields;
-	while(field != 0)
-	{
-		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+		/* Set the node kind */
+		TreeCCStreamPrint(stream, "        self.kind = %d\n", node->number);
+
+		/* Track the filename and line number if necessary */
+		if(context->track_lines && !(node->parent))
 		{
-			TreeCCStreamPrint(stream, "        self.%s = %s\n",
-							  field->name, field->name);
+			TreeCCStreamPrint(stream,
+							  "        self.filename = %scurrfilename()\n",
+							  context->yy_replacement);
+			TreeCCStreamPrint(stream,
+							  "        self.linenum = %scurrlinenum()\n",
+							  context->yy_replacement);
 		}
-		else if(field->value)
+
+		/* Initialize the fields that are specific to this node type */
+		field = node->fields;
+		while(field != 0)
 		{
-			TreeCCStreamPrint(stream, "        self.%s = %s\n",
-							  field->name, field->value);
+			if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+			{
+				TreeCCStreamPrint(stream, "        self.%s = %s\n",
+								  field->name, field->name);
+			}
+			else if(field->value)
+			{
+				TreeCCStreamPrint(stream, "        self.%s = %s\n",
+								  field->name, field->value);
+			}
+			field = field->next;
 		}
-		field = field->next;
 	}
 	TreeCCStreamPrint(stream, "\n");
 
@@ -471,6 +569,35 @@ static void PythonGenSelector(TreeCCContext *context, TreeCCStream *stream,
 	info->needsOr = 1;
 }
 
+/*
+ * Generate a selector for a range of node kinds.
+ */
+static void PythonGenRangeSelector(TreeCCContext *context,
+								   TreeCCStream *stream, TreeCCNode *first,
+								   TreeCCNode *last, int level)
+{
+	SwitchInfo *info = &(switchStack[switchStackSize - 1]);
+	if(info->needsOr)
+	{
+		/* Generating multiple selectors for the same case */
+		TreeCCStreamPrint(stream, " or ");
+	}
+	else if(info->nextIsIf)
+	{
+		Indent(stream, level + 1);
+		TreeCCStreamPrint(stream, "if ");
+		info->nextIsIf = 0;
+	}
+	else
+	{
+		Indent(stream, level + 1);
+		TreeCCStreamPrint(stream, "elif ");
+	}
+	TreeCCStreamPrint(stream, "%d <= %s.kind <= %d",
+					  first->number, info->paramName, last->number);
+	info->needsOr = 1;
+}
+
 /*
  * Terminate the selectors and begin the body of a "switch" case.
  */
@@ -690,6 +817,231 @@ static void PythonGenEnd(TreeCCContext *context, TreeCCStream *stream,
 	/* Nothing to do here for Python */
 }
 
+/*
+ * Output the arguments that are passed to a case function.
+ */
+static void PythonGenArgs(TreeCCContext *context, TreeCCStream *stream,
+						  TreeCCOperation *oper)
+{
+	TreeCCParam *param;
+	int num;
+	int needComma;
+	param = oper->params;
+	num = 1;
+	needComma = 0;
+	while(param != 0)
+	{
+		if(needComma)
+		{
+			TreeCCStreamPrint(stream, ", ");
+		}
+		if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s", param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "P%d__", num);
+			++num;
+		}
+		needComma = 1;
+		param = param->next;
+	}
+}
+
+/*
+ * Generate a dispatch table for a non-virtual operation.  The
+ * table is a dictionary that is built when the module is loaded,
+ * and which maps the kinds of the triggers to the case function.
+ * Multi-trigger operations use a tuple of the kinds as the key.
+ */
+static int PythonGenDispatchTable(TreeCCContext *context,
+								  TreeCCStream *stream,
+								  TreeCCOperation *oper)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	TreeCCNode ***nodes;
+	int **keys;
+	int *counts;
+	int *current;
+	TreeCCNode **chosen;
+	int trigger, number, num;
+
+	/* Output a function for each case that does not have one
+	   already, so that every case can be entered in the table */
+	if((oper->flags & TREECC_OPER_INLINE) != 0)
+	{
+		number = 1;
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number >= number)
+			{
+				number = operCase->number + 1;
+			}
+			operCase = operCase->next;
+		}
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number == 0)
+			{
+				PythonGenCaseFunc(context, stream, operCase, number);
+				operCase->number = number++;
+			}
+			operCase = operCase->next;
+		}
+	}
+
+	/* Collect the node types and keys for each trigger */
+	nodes = (TreeCCNode ***)calloc(oper->numTriggers, sizeof(TreeCCNode **));
+	keys = (int **)calloc(oper->numTriggers, sizeof(int *));
+	counts = (int *)calloc(oper->numTriggers, sizeof(int));
+	current = (int *)calloc(oper->numTriggers, sizeof(int));
+	chosen = (TreeCCNode **)calloc(oper->numTriggers, sizeof(TreeCCNode *));
+	if(!nodes || !keys || !counts || !current || !chosen)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			type = TreeCCNodeFindByType(context, param->type);
+			nodes[trigger] = (TreeCCNode **)malloc
+					(sizeof(TreeCCNode *) * context->nodeNumber);
+			keys[trigger] = (int *)malloc(sizeof(int) * context->nodeNumber);
+			if(!(nodes[trigger]) || !(keys[trigger]))
+			{
+				TreeCCOutOfMemory(context->input);
+			}
+			counts[trigger] = TreeCCCollectTableKeys
+				(type, nodes[trigger], keys[trigger], 0,
+				 ((type->flags & TREECC_NODE_ENUM) != 0));
+			++trigger;
+		}
+		param = param->next;
+	}
+
+	/* Output the table, with an entry for every combination
+	   of trigger types that is handled by a case */
+	TreeCCStreamPrint(stream, "%s_table__ = {\n", oper->name);
+	for(;;)
+	{
+		for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+		{
+			chosen[trigger] = nodes[trigger][current[trigger]];
+		}
+		operCase = TreeCCFindTableCase(oper, chosen);
+		if(operCase)
+		{
+			if(oper->numTriggers == 1)
+			{
+				TreeCCStreamPrint(stream, "    %d: ", keys[0][current[0]]);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "    (");
+				for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+				{
+					TreeCCStreamPrint(stream, "%s%d", (trigger ? ", " : ""),
+									  keys[trigger][current[trigger]]);
+				}
+				TreeCCStreamPrint(stream, "): ");
+			}
+			TreeCCStreamPrint(stream, "%s_%d__,\n",
+							  oper->name, operCase->number);
+		}
+
+		/* Advance to the next combination of trigger types */
+		for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+		{
+			if(++(current[trigger]) < counts[trigger])
+			{
+				break;
+			}
+			current[trigger] = 0;
+		}
+		if(trigger >= oper->numTriggers)
+		{
+			break;
+		}
+	}
+	TreeCCStreamPrint(stream, "}\n\n");
+	for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+	{
+		free(nodes[trigger]);
+		free(keys[trigger]);
+	}
+	free(nodes);
+	free(keys);
+	free(counts);
+	free(current);
+	free(chosen);
+
+	/* Output the entry point, which looks up the case function */
+	GenEntry(context, stream, oper, -1);
+	TreeCCStreamPrint(stream, "    case__ = %s_table__.get(", oper->name);
+	if(oper->numTriggers > 1)
+	{
+		TreeCCStreamPrint(stream, "(");
+	}
+	num = 1;
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			if(trigger)
+			{
+				TreeCCStreamPrint(stream, ", ");
+			}
+			if(param->name)
+			{
+				TreeCCStreamPrint(stream, "%s", param->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "P%d__", num);
+			}
+			type = TreeCCNodeFindByType(context, param->type);
+			if((type->flags & TREECC_NODE_ENUM) == 0)
+			{
+				TreeCCStreamPrint(stream, ".kind");
+			}
+			++trigger;
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	if(oper->numTriggers > 1)
+	{
+		TreeCCStreamPrint(stream, ")");
+	}
+	TreeCCStreamPrint(stream, ")\n");
+	TreeCCStreamPrint(stream, "    if case__ is not None:\n");
+	if(strcmp(oper->returnType, "void") != 0)
+	{
+		TreeCCStreamPrint(stream, "        return case__(");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "        case__(");
+	}
+	PythonGenArgs(context, stream, oper);
+	TreeCCStreamPrint(stream, ")\n");
+	PythonGenExit(context, stream, oper);
+	return 1;
+}
+
 /*
  * Table of non-virtual code generation functions.
  */
@@ -699,6 +1051,7 @@ static TreeCCNonVirtual const TreeCCNonVirtualFuncsPython = {
 	PythonGenSplitEntry,
 	PythonGenSwitchHead,
 	PythonGenSelector,
+	PythonGenRangeSelector,
 	PythonGenEndSelectors,
 	PythonGenCaseFunc,
 	PythonGenCaseCall,
@@ -707,7 +1060,9 @@ static TreeCCNonVirtual const TreeCCNonVirtualFuncsPython = {
 	PythonGenEndCase,
 	PythonGenEndSwitch,
 	PythonGenExit,
-	PythonGenEnd
+	PythonGenEnd,
+	PythonGenDispatchTable,
+	0
 };
 
 /*
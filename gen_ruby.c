@@ -24,6 +24,7 @@
 #include "input.h"
 #include "info.h"
 #include "gen.h"
+#include "errors.h"
 
 #ifdef	__cplusplus
 extern	"C" {
@@ -114,6 +115,35 @@ static int InheritParamsSource(TreeCCContext *context, TreeCCStream *stream,
 	return needComma;
 }
 
+/*
+ * Assign the fields of a node type and its ancestors to instance
+ * variables, instead of calling the constructors of the ancestors.
+ */
+static void InitFields(TreeCCContext *context, TreeCCStream *stream,
+					   TreeCCNode *node)
+{
+	TreeCCField *field;
+	if(node->parent)
+	{
+		InitFields(context, stream, node->parent);
+	}
+	field = node->fields;
+	while(field != 0)
+	{
+		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+		{
+			TreeCCStreamPrint(stream, "    @%s = %s\n",
+							  field->name, field->name);
+		}
+		else if(field->value)
+		{
+			TreeCCStreamPrint(stream, "    @%s = %s\n",
+							  field->name, field->value);
+		}
+		field = field->next;
+	}
+}
+
 /* 
  * Implement the virtual methods that have implementations in a node type.
  */
@@ -358,8 +388,15 @@ static void BuildTypeDecls(TreeCCContext *context,
 	/* Stick to the Ruby convention of constants, start with Uppercase,
 	   continue with lowercase */
 	/* The parent doesn't matter, so don't check it */
-	TreeCCStreamPrint(stream, "  KIND = %d\n\n",
+	TreeCCStreamPrint(stream, "  KIND = %d\n",
 					  node->number);
+	if(context->kind_ranges)
+	{
+		/* The kinds of the node type and its descendants */
+		TreeCCStreamPrint(stream, "  FIRST_KIND = %d\n", node->number);
+		TreeCCStreamPrint(stream, "  LAST_KIND = %d\n", node->lastNumber);
+	}
+	TreeCCStreamPrint(stream, "\n");
 
 	/* Declare the constructor for the node type */
 	/* A constructor is always public (I hope) anyway I don't expect
@@ -381,67 +418,96 @@ static void BuildTypeDecls(TreeCCContext *context,
 	CreateParams(context, stream, node, needComma);
 
 	TreeCCStreamPrint(stream, ")\n");
-	
-	/* Enter the super call */
-	/* Call the parent class constructor */
-	if(node->parent)
+
+	if(context->flat_nodes)
 	{
-		/* Do not use base, Ruby uses super for that */
-		/*TreeCCStreamPrint(stream, "    : base(");*/
-		TreeCCStreamPrint(stream, "    super(");
-		if(context->reentrant)
-		{
-			TreeCCStreamPrint(stream, "@state");
-			needComma = 1;
-		}
-		else
+		/* Set the kind, the position, and all fields directly,
+		   so that construction does not walk the "super" chain */
+		TreeCCStreamPrint(stream, "    @kind = KIND\n");
+		if(context->track_lines)
 		{
-			needComma = 0;
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream,
+						"    @Filename = state__.currFilename\n");
+				TreeCCStreamPrint(stream,
+						"    @Linenum = state__.currLinenum\n");
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+						"    @Filename = %s.state.currFilename()\n",
+						context->state_type);
+				TreeCCStreamPrint(stream,
+						"    @Linenum = %s.state.currLinenum()\n",
+						context->state_type);
+			}
 		}
-		CreateParams(context, stream, node, needComma);		
-		InheritParamsSource(context, stream, node->parent, needComma);
-		TreeCCStreamPrint(stream, ")\n");
+		InitFields(context, stream, node);
 	}
-	
-	/* Set the node kind */	
-	TreeCCStreamPrint(stream, "    @kind = KIND\n");
-
-	/* Track the filename and line number if necessary */
-	if(context->track_lines && !(node->parent))
+	else
 	{
-		if(context->reentrant)
+		/* Enter the super call */
+		/* Call the parent class constructor */
+		if(node->parent)
 		{
-			TreeCCStreamPrint(stream,
-					"    @Filename = @state.currFilename\n");
-			TreeCCStreamPrint(stream,
-					"    @Finenum = @state.currLinenum\n");
-		}
-		else
-		{
-			TreeCCStreamPrint(stream,
-					"    @Filename = %s.state.currFilename()\n",
-					context->state_type);
-			TreeCCStreamPrint(stream,
-					"    @Linenum = %s.state.currLinenum()\n",
-					context->state_type);
+			/* Do not use base, Ruby uses super for that */
+			/*TreeCCStreamPrint(stream, "    : base(");*/
+			TreeCCStreamPrint(stream, "    super(");
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream, "@state");
+				needComma = 1;
+			}
+			else
+			{
+				needComma = 0;
+			}
+			CreateParams(context, stream, node, needComma);		
+			InheritParamsSource(context, stream, node->parent, needComma);
+			TreeCCStreamPrint(stream, ")\n");
 		}
-	}
+	
+		/* Set the node kind */	
+		TreeCCStreamPrint(stream, "    @kind = KIND\n");
 
-	/* Initialize the fields that are specific to this node type */
-	field = node->fields;
-	while(field != 0)
-	{
-		if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+		/* Track the filename and line number if necessary */
+		if(context->track_lines && !(node->parent))
 		{
-			TreeCCStreamPrint(stream, "    self.%s = %s\n",
-							  field->name, field->name);
+			if(context->reentrant)
+			{
+				TreeCCStreamPrint(stream,
+						"    @Filename = @state.currFilename\n");
+				TreeCCStreamPrint(stream,
+						"    @Finenum = @state.currLinenum\n");
+			}
+			else
+			{
+				TreeCCStreamPrint(stream,
+						"    @Filename = %s.state.currFilename()\n",
+						context->state_type);
+				TreeCCStreamPrint(stream,
+						"    @Linenum = %s.state.currLinenum()\n",
+						context->state_type);
+			}
 		}
-		else if(field->value)
+
+		/* Initialize the fields that are specific to this node type */
+		field = node->fields;
+		while(field != 0)
 		{
-			TreeCCStreamPrint(stream, "    self.%s = %s\n",
-							  field->name, field->value);
+			if((field->flags & TREECC_FIELD_NOCREATE) == 0)
+			{
+				TreeCCStreamPrint(stream, "    self.%s = %s\n",
+								  field->name, field->name);
+			}
+			else if(field->value)
+			{
+				TreeCCStreamPrint(stream, "    self.%s = %s\n",
+								  field->name, field->value);
+			}
+			field = field->next;
 		}
-		field = field->next;
 	}
 	TreeCCStreamPrint(stream, "  end\n\n");
 
@@ -872,6 +938,18 @@ static void Ruby_GenSelector(TreeCCContext *context, TreeCCStream *stream,
 	}
 }
 
+/*
+ * Generate a selector for a range of node kinds.
+ */
+static void Ruby_GenRangeSelector(TreeCCContext *context, TreeCCStream *stream,
+								  TreeCCNode *first, TreeCCNode *last,
+								  int level)
+{
+	Indent(stream, level * 2 + 3);
+	TreeCCStreamPrint(stream, "when %s::KIND..%s::KIND\n",
+					  first->name, last->name);
+}
+
 /*
  * Terminate the selectors and begin the body of a "switch" case.
  */
@@ -1169,6 +1247,281 @@ static void Ruby_GenEnd(TreeCCContext *context, TreeCCStream *stream,
 	TreeCCStreamPrint(stream, "end\n");
 }
 
+/*
+ * Determine if any combination of trigger types from "level"
+ * onwards, given the types in "chosen" for the earlier levels,
+ * is handled by a case of an operation.
+ */
+static int RubyTableHasCase(TreeCCOperation *oper, TreeCCNode ***byKey,
+							int *sizes, TreeCCNode **chosen, int level)
+{
+	int key;
+	for(key = 0; key < sizes[level]; ++key)
+	{
+		if(byKey[level][key] == 0)
+		{
+			continue;
+		}
+		chosen[level] = byKey[level][key];
+		if(level == oper->numTriggers - 1)
+		{
+			if(TreeCCFindTableCase(oper, chosen) != 0)
+			{
+				return 1;
+			}
+		}
+		else if(RubyTableHasCase(oper, byKey, sizes, chosen, level + 1))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Output the elements of one level of a dispatch table.  Each level
+ * is an array that is indexed by the key of a trigger, and which
+ * holds the arrays for the next trigger, or the names of the case
+ * methods at the last level.
+ */
+static void RubyGenTableLevel(TreeCCStream *stream, TreeCCOperation *oper,
+							  TreeCCNode ***byKey, int *sizes,
+							  TreeCCNode **chosen, int level)
+{
+	TreeCCOperationCase *operCase;
+	int key;
+	for(key = 0; key < sizes[level]; ++key)
+	{
+		Indent(stream, level + 2);
+		chosen[level] = byKey[level][key];
+		if(chosen[level] == 0)
+		{
+			TreeCCStreamPrint(stream, "nil,\n");
+		}
+		else if(level == oper->numTriggers - 1)
+		{
+			operCase = TreeCCFindTableCase(oper, chosen);
+			if(operCase)
+			{
+				TreeCCStreamPrint(stream, ":%s_%d__,\n",
+								  oper->name, operCase->number);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "nil,\n");
+			}
+		}
+		else if(RubyTableHasCase(oper, byKey, sizes, chosen, level + 1))
+		{
+			TreeCCStreamPrint(stream, "[\n");
+			RubyGenTableLevel(stream, oper, byKey, sizes, chosen, level + 1);
+			Indent(stream, level + 2);
+			TreeCCStreamPrint(stream, "].freeze,\n");
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "nil,\n");
+		}
+	}
+}
+
+/*
+ * Output the name of a trigger parameter within the entry point.
+ */
+static void RubyGenTriggerName(TreeCCContext *context, TreeCCStream *stream,
+							   TreeCCParam *param, int num)
+{
+	if(param->name)
+	{
+		TreeCCStreamPrint(stream, "%s", param->name);
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "p%d__", num);
+	}
+	if(!IsEnumType(context, param->type))
+	{
+		TreeCCStreamPrint(stream, "__");
+	}
+}
+
+/*
+ * Generate a dispatch table for a non-virtual operation.  The table
+ * is a frozen constant that maps the kinds of the triggers to the
+ * name of the case method, with one level of nested arrays for each
+ * trigger.  Enumerated triggers are indexed on their value.
+ */
+static int Ruby_GenDispatchTable(TreeCCContext *context,
+								 TreeCCStream *stream,
+								 TreeCCOperation *oper)
+{
+	TreeCCOperationCase *operCase;
+	TreeCCParam *param;
+	TreeCCNode *type;
+	TreeCCNode **nodes;
+	TreeCCNode ***byKey;
+	TreeCCNode **chosen;
+	int *keys;
+	int *sizes;
+	int trigger, number, count, index, num;
+
+	/* Output a method for each case that does not have one
+	   already, so that every case can be entered in the table */
+	if((oper->flags & TREECC_OPER_INLINE) != 0)
+	{
+		number = 1;
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number >= number)
+			{
+				number = operCase->number + 1;
+			}
+			operCase = operCase->next;
+		}
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->number == 0)
+			{
+				Ruby_GenCaseFunc(context, stream, operCase, number);
+				operCase->number = number++;
+			}
+			operCase = operCase->next;
+		}
+	}
+
+	/* Index the node types of each trigger by their keys */
+	nodes = (TreeCCNode **)malloc(sizeof(TreeCCNode *) * context->nodeNumber);
+	keys = (int *)malloc(sizeof(int) * context->nodeNumber);
+	byKey = (TreeCCNode ***)calloc(oper->numTriggers, sizeof(TreeCCNode **));
+	chosen = (TreeCCNode **)calloc(oper->numTriggers, sizeof(TreeCCNode *));
+	sizes = (int *)calloc(oper->numTriggers, sizeof(int));
+	if(!nodes || !keys || !byKey || !chosen || !sizes)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			type = TreeCCNodeFindByType(context, param->type);
+			count = TreeCCCollectTableKeys
+				(type, nodes, keys, 0, ((type->flags & TREECC_NODE_ENUM) != 0));
+			for(index = 0; index < count; ++index)
+			{
+				if(keys[index] >= sizes[trigger])
+				{
+					sizes[trigger] = keys[index] + 1;
+				}
+			}
+			byKey[trigger] = (TreeCCNode **)calloc
+				(sizes[trigger] + 1, sizeof(TreeCCNode *));
+			if(!(byKey[trigger]))
+			{
+				TreeCCOutOfMemory(context->input);
+			}
+			for(index = 0; index < count; ++index)
+			{
+				byKey[trigger][keys[index]] = nodes[index];
+			}
+			++trigger;
+		}
+		param = param->next;
+	}
+
+	/* Output the table as a constant of the operation's class */
+	TreeCCStreamPrint(stream, "  DISPATCH_%s__ = [\n", oper->name);
+	RubyGenTableLevel(stream, oper, byKey, sizes, chosen, 0);
+	TreeCCStreamPrint(stream, "  ].freeze\n\n");
+	for(trigger = 0; trigger < oper->numTriggers; ++trigger)
+	{
+		free(byKey[trigger]);
+	}
+	free(nodes);
+	free(keys);
+	free(byKey);
+	free(chosen);
+	free(sizes);
+
+	/* Output the entry point, which indexes the table with each
+	   trigger in turn and then calls the case method */
+	RubyGenEntry(context, stream, oper, -1);
+	num = 1;
+	trigger = 0;
+	param = oper->params;
+	while(param != 0)
+	{
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			if(trigger == 0)
+			{
+				TreeCCStreamPrint(stream, "    case__ = DISPATCH_%s__[",
+								  oper->name);
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "    case__ = case__[");
+			}
+			RubyGenTriggerName(context, stream, param, num);
+			if(!IsEnumType(context, param->type))
+			{
+				TreeCCStreamPrint(stream, ".class::KIND");
+			}
+			if(trigger == 0)
+			{
+				TreeCCStreamPrint(stream, "]\n");
+			}
+			else
+			{
+				TreeCCStreamPrint(stream, "] unless case__.nil?\n");
+			}
+			++trigger;
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	if(strcmp(oper->returnType, "void") != 0)
+	{
+		TreeCCStreamPrint(stream, "    return send(case__");
+	}
+	else
+	{
+		TreeCCStreamPrint(stream, "    send(case__");
+	}
+	num = 1;
+	param = oper->params;
+	while(param != 0)
+	{
+		TreeCCStreamPrint(stream, ", ");
+		if((param->flags & TREECC_PARAM_TRIGGER) != 0)
+		{
+			RubyGenTriggerName(context, stream, param, num);
+		}
+		else if(param->name)
+		{
+			TreeCCStreamPrint(stream, "%s", param->name);
+		}
+		else
+		{
+			TreeCCStreamPrint(stream, "p%d__", num);
+		}
+		if(!(param->name))
+		{
+			++num;
+		}
+		param = param->next;
+	}
+	TreeCCStreamPrint(stream, ") unless case__.nil?\n");
+	Ruby_GenExit(context, stream, oper);
+	return 1;
+}
+
 /*
  * Table of non-virtual code generation functions.
  */
@@ -1178,6 +1531,7 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsRuby = {
 	Ruby_GenSplitEntry,
 	Ruby_GenSwitchHead,
 	Ruby_GenSelector,
+	Ruby_GenRangeSelector,
 	Ruby_GenEndSelectors,
 	Ruby_GenCaseFunc,
 	Ruby_GenCaseCall,
@@ -1187,6 +1541,8 @@ TreeCCNonVirtual const TreeCCNonVirtualFuncsRuby = {
 	Ruby_GenEndSwitch,
 	Ruby_GenExit,
 	Ruby_GenEnd,
+	Ruby_GenDispatchTable,
+	0,
 };
 
 void TreeCCGenerateRuby(TreeCCContext *context)
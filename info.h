@@ -60,6 +60,9 @@ typedef struct _tagTreeCCOperationCase	TreeCCOperationCase;
 #define	TREECC_OPER_VIRTUAL			1
 #define	TREECC_OPER_INLINE			2
 #define	TREECC_OPER_SPLIT			4
+#define	TREECC_OPER_DISPATCH_SWITCH	8
+#define	TREECC_OPER_DISPATCH_AUTO	16
+#define	TREECC_OPER_MEMOIZE			32
 
 /*
  * Parameter flags.
@@ -104,6 +107,7 @@ struct _tagTreeCCNode
 	char		   *name;		/* Name of this node type */
 	int				flags;		/* Node flags */
 	int				number;		/* Number associated with this node type */
+	int				lastNumber;	/* Last number within this node's subtree */
 	int				position;	/* Position within the tree for operations */
 	char		   *filename;	/* File that defines the node type */
 	long			linenum;	/* Line where the node type is defined */
@@ -134,6 +138,8 @@ struct _tagTreeCCOperation
 	TreeCCOperationCase *lastCase;  /* Last case associated with operation */
 	TreeCCOperationCase **sortedCases; /* Cases sorted for non-virtual ops */
 	int				numCases;	/* Number of operation cases */
+	int				profileIndex;/* Index for dispatch profiling, or -1 */
+	unsigned long	hits;		/* Profiled calls to the operation */
 	TreeCCStream   *header;		/* Stream to write header to */
 	TreeCCStream   *source;		/* Stream to write source to */
 
@@ -188,6 +194,7 @@ struct _tagTreeCCOperationCase
 	long		   	linenum;	/* Line that starts the case definition */
 	char		   *codeFilename;/* File that starts the code */
 	long		   	codeLinenum;/* Line that starts the code */
+	unsigned long	hits;		/* Profiled calls to the case */
 	TreeCCOperationCase *next;	/* Next case for the operation */
 	TreeCCOperationCase *nextHeader; /* Next header for same code block */
 
@@ -220,6 +227,7 @@ typedef struct _tagTreeCCContext
 	int				track_lines : 1;	/* Track node creation lines */
 	int				no_singletons : 1;	/* Don't handle singletons specially */
 	int				reentrant : 1;		/* Build a re-entrant system */
+	int				thread_local_state : 1; /* Per-thread fixed state */
 	int				force : 1;			/* Force the creation of files */
 	int				virtual_factory : 1;/* Allow overrides of factory methods */
 	int				abstract_factory : 1;/* Declare factory methods abstract */
@@ -229,6 +237,19 @@ typedef struct _tagTreeCCContext
 	int				internal_access : 1; /* Use "internal" classes in C# */
 	int				use_allocator : 1;	/* Use the skeleton allocator */
 	int				use_gc_allocator : 1; /* Use the libgc allocator */
+	int				use_shared_allocator : 1; /* Use the lock-free shared allocator */
+	int				node_stats : 1;		/* Collect allocation statistics */
+	int				free_lists : 1;		/* Recycle individual nodes */
+	int				clone_nodes : 1;	/* Generate subtree clone functions */
+	int				memory_resource : 1; /* C++ state is a memory_resource */
+	int				propagate_resource : 1; /* Pass state to field allocators */
+	int				finalizers : 1;		/* Destroy C++ node fields on pop */
+	int				move_fields : 1;	/* Move C++ constructor arguments */
+	int				kind_ranges : 1;	/* Number node kinds in pre-order */
+	int				dispatch_tables : 1; /* Table-driven non-virtual dispatch */
+	int				profile_dispatch : 1; /* Count dispatches per node kind */
+	int				batch_operations : 1; /* Batch entry points for operations */
+	int				flat_nodes : 1;		/* Flat node layout in scripting langs */
 
 	/* String to use to replace "yy" in output files */
 	char		   *yy_replacement;
@@ -248,12 +269,24 @@ typedef struct _tagTreeCCContext
 	/* Size of blocks to use in C/C++ memory alloction */
 	int				block_size;
 
+	/* Number of retired blocks to cache in C/C++ memory allocation */
+	int				block_cache;
+
+	/* Maximum size that C/C++ memory allocation blocks may grow to */
+	int				max_block_size;
+
+	/* Size at which C/C++ memory allocation blocks are mmap'ed */
+	int				mmap_threshold;
+
 	/* Name of the directory to output Java source files to */
 	char		   *outputDirectory;
 
 	/* name of the base type which is what %typedef expands to */
 	char		   *baseType;
 
+	/* Name of the file to write dispatch profile counts to */
+	char		   *profileFile;
+
 } TreeCCContext;
 
 /*
@@ -348,6 +381,12 @@ void TreeCCNodeClearMarking(TreeCCContext *context, int flags);
  */
 int TreeCCNodeAssignPositions(TreeCCNode *node);
 
+/*
+ * Renumber the node types in pre-order, so that the kinds of each
+ * node type and its descendants form a contiguous range.
+ */
+void TreeCCNodeNumberPreOrder(TreeCCContext *context);
+
 /*
  * Create a new field definition and add it to a node.
  */
@@ -393,6 +432,12 @@ void TreeCCOperationValidate(TreeCCContext *context);
 TreeCCOperationCase *TreeCCOperationFindCase
 		(TreeCCContext *context, TreeCCNode *node, char *name);
 
+/*
+ * Load the dispatch counts from a profile that was written by a
+ * program built with "%option profile_dispatch".
+ */
+void TreeCCOperationLoadProfile(TreeCCContext *context, char *filename);
+
 /*
  * Visit all operations declared by a context.
  */
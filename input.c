@@ -603,11 +603,13 @@ static struct
 	{"both",			TREECC_TOKEN_BOTH},
 	{"common",			TREECC_TOKEN_COMMON},
 	{"decls",			TREECC_TOKEN_DECLS},
+	{"dispatch",		TREECC_TOKEN_DISPATCH},
 	{"end",				TREECC_TOKEN_END},
 	{"enum",			TREECC_TOKEN_ENUM},
 	{"header",			TREECC_TOKEN_HEADER},
 	{"include",			TREECC_TOKEN_INCLUDE},
 	{"inline",			TREECC_TOKEN_INLINE},
+	{"memoize",			TREECC_TOKEN_MEMOIZE},
 	{"nocreate",		TREECC_TOKEN_NOCREATE},
 	{"node",			TREECC_TOKEN_NODE},
 	{"operation",		TREECC_TOKEN_OPERATION},
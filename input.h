@@ -68,6 +68,8 @@ typedef enum
 	TREECC_TOKEN_COMMON,
 	TREECC_TOKEN_INCLUDE,
 	TREECC_TOKEN_READONLY,
+	TREECC_TOKEN_DISPATCH,
+	TREECC_TOKEN_MEMOIZE,
 
 } TreeCCToken;
 
@@ -40,6 +40,7 @@ int main(int argc, char *argv[])
 	char *headerFile = NULL;
 	char *extension = "c";
 	char *outputDir = NULL;
+	char *profileFile = NULL;
 	int forceCreate = 0;
 	TreeCCInput input;
 	TreeCCContext *context;
@@ -142,6 +143,17 @@ int main(int argc, char *argv[])
 				}
 				options[num_options++] = argv[1];
 			}
+			else if(!strcmp(argv[1], "--profile"))
+			{
+				--argc;
+				++argv;
+				if(argc <= 1)
+				{
+					Usage(progname);
+					return 1;
+				}
+				profileFile = argv[1];
+			}
 			else if(!strcmp(argv[1], "--force-create"))
 			{
 				forceCreate = 1;
@@ -439,6 +451,12 @@ int main(int argc, char *argv[])
 	TreeCCNodeValidate(context);
 	TreeCCOperationValidate(context);
 
+	/* Load the dispatch profile that guides the layout of operations */
+	if(profileFile)
+	{
+		TreeCCOperationLoadProfile(context, profileFile);
+	}
+
 	/* Abort if we encountered errors during parsing and validation */
 	if(input.errors)
 	{
@@ -487,6 +505,8 @@ static void Usage(char *progname)
 	fprintf(stderr, "        Force the creation of unchanged output files.\n");
 	fprintf(stderr, "    -O opt,  --option opt\n");
 	fprintf(stderr, "        Set a treecc source option value.\n");
+	fprintf(stderr, "    --profile file\n");
+	fprintf(stderr, "        Order operation cases using a dispatch profile.\n");
 	fprintf(stderr, "    --help\n");
 	fprintf(stderr, "        Print this help message.\n");
 	fprintf(stderr, "    -v,      --version\n");
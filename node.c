@@ -124,6 +124,7 @@ TreeCCNode *TreeCCNodeCreate(TreeCCContext *context, long linenum,
 			parentNode->name = parent;
 			parentNode->flags = TREECC_NODE_UNDEFINED;
 			parentNode->number = (context->nodeNumber)++;
+			parentNode->lastNumber = parentNode->number;
 			parentNode->filename = context->input->filename;
 			parentNode->linenum = linenum;
 			parentNode->fields = 0;
@@ -190,6 +191,7 @@ TreeCCNode *TreeCCNodeCreate(TreeCCContext *context, long linenum,
 		node->name = name;
 		node->flags = flags;
 		node->number = (context->nodeNumber)++;
+		node->lastNumber = node->number;
 		node->filename = context->input->filename;
 		node->linenum = linenum;
 		node->fields = 0;
@@ -547,6 +549,119 @@ int TreeCCNodeAssignPositions(TreeCCNode *node)
 	return AssignPositions(node, 0);
 }
 
+/*
+ * Number a node type and its descendants in pre-order,
+ * starting at a particular value.
+ */
+static int NumberPreOrder(TreeCCNode *node, int number)
+{
+	TreeCCNode *child;
+
+	/* Number this node before its children */
+	node->number = number++;
+
+	/* Number the children */
+	child = node->firstChild;
+	while(child != 0)
+	{
+		number = NumberPreOrder(child, number);
+		child = child->nextSibling;
+	}
+
+	/* Record the end of the range for the subtree */
+	node->lastNumber = number - 1;
+	return number;
+}
+
+/*
+ * Compare two top-level node types.  Enumerated types are placed
+ * after the node types, and otherwise the order of declaration
+ * is preserved.
+ */
+static int RootCompare(const void *e1, const void *e2)
+{
+	TreeCCNode *node1 = *((TreeCCNode **)e1);
+	TreeCCNode *node2 = *((TreeCCNode **)e2);
+	int isEnum1 = ((node1->flags & TREECC_NODE_ENUM) != 0);
+	int isEnum2 = ((node2->flags & TREECC_NODE_ENUM) != 0);
+	if(isEnum1 != isEnum2)
+	{
+		return isEnum1 - isEnum2;
+	}
+	else if(node1->number < node2->number)
+	{
+		return -1;
+	}
+	else if(node1->number > node2->number)
+	{
+		return 1;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+void TreeCCNodeNumberPreOrder(TreeCCContext *context)
+{
+	unsigned int hash;
+	TreeCCNode *node;
+	TreeCCNode **roots;
+	int numRoots, posn;
+	int number;
+
+	/* Find the top-level node types, and the first number in use */
+	numRoots = 0;
+	number = context->nodeNumber;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		node = context->nodeHash[hash];
+		while(node != 0)
+		{
+			if(!(node->parent))
+			{
+				++numRoots;
+			}
+			if(node->number < number)
+			{
+				number = node->number;
+			}
+			node = node->nextHash;
+		}
+	}
+	if(!numRoots)
+	{
+		return;
+	}
+	roots = (TreeCCNode **)malloc(sizeof(TreeCCNode *) * numRoots);
+	if(!roots)
+	{
+		TreeCCOutOfMemory(context->input);
+	}
+	posn = 0;
+	for(hash = 0; hash < TREECC_HASH_SIZE; ++hash)
+	{
+		node = context->nodeHash[hash];
+		while(node != 0)
+		{
+			if(!(node->parent))
+			{
+				roots[posn++] = node;
+			}
+			node = node->nextHash;
+		}
+	}
+
+	/* Renumber each of the hierarchies in turn */
+	qsort(roots, numRoots, sizeof(TreeCCNode *), RootCompare);
+	for(posn = 0; posn < numRoots; ++posn)
+	{
+		number = NumberPreOrder(roots[posn], number);
+	}
+	context->nodeNumber = number;
+	free(roots);
+}
+
 /*
  * Determine if a field name is already declared in a node type.
  */
@@ -133,6 +133,8 @@ TreeCCOperation *TreeCCOperationCreate(TreeCCContext *context,
 	oper->lastCase = 0;
 	oper->sortedCases = 0;
 	oper->numCases = 0;
+	oper->profileIndex = -1;
+	oper->hits = 0;
 	oper->header = context->headerStream;
 	oper->source = context->sourceStream;
 
@@ -196,6 +198,7 @@ TreeCCOperationCase *TreeCCOperationAddCase
 	operCase->linenum = linenum;
 	operCase->codeFilename = 0;
 	operCase->codeLinenum = 0;
+	operCase->hits = 0;
 	operCase->next = 0;
 	operCase->nextHeader = 0;
 
@@ -814,6 +817,98 @@ TreeCCOperationCase *TreeCCOperationFindCase
 	return 0;
 }
 
+/*
+ * Find the case of a single-trigger operation that handles a node type.
+ */
+static TreeCCOperationCase *FindHandlingCase(TreeCCOperation *oper,
+											 TreeCCNode *node)
+{
+	TreeCCOperationCase *operCase;
+	while(node != 0)
+	{
+		operCase = oper->firstCase;
+		while(operCase != 0)
+		{
+			if(operCase->triggers && operCase->triggers->node == node)
+			{
+				return operCase;
+			}
+			operCase = operCase->next;
+		}
+		node = node->parent;
+	}
+	return 0;
+}
+
+void TreeCCOperationLoadProfile(TreeCCContext *context, char *filename)
+{
+	FILE *file;
+	char buffer[TREECC_BUFSIZ];
+	char operName[256];
+	char kindName[256];
+	unsigned long count;
+	long linenum;
+	TreeCCOperation *oper;
+	TreeCCNode *node;
+	TreeCCOperationCase *operCase;
+	char *posn;
+
+	/* Open the profile */
+	if((file = fopen(filename, "r")) == NULL)
+	{
+		perror(filename);
+		context->input->errors = 1;
+		return;
+	}
+
+	/* Each line has the form "operation kind count" */
+	linenum = 0;
+	while(fgets(buffer, sizeof(buffer), file))
+	{
+		++linenum;
+		posn = buffer;
+		while(*posn == ' ' || *posn == '\t')
+		{
+			++posn;
+		}
+		if(*posn == '#' || *posn == '\n' || *posn == '\r' || *posn == '\0')
+		{
+			/* Comment or blank line */
+			continue;
+		}
+		if(sscanf(posn, "%255s %255s %lu", operName, kindName, &count) != 3)
+		{
+			TreeCCErrorOnLine(context->input, filename, linenum,
+							  "invalid profile entry");
+			continue;
+		}
+
+		/* Ignore entries that no longer match the input, which can
+		   happen if the profile was collected from an older version.
+		   Only the cases of single-trigger non-virtual operations are
+		   reordered using the counts */
+		oper = TreeCCOperationFind(context, operName);
+		if(!oper || oper->numTriggers != 1 ||
+		   (oper->flags & TREECC_OPER_VIRTUAL) != 0)
+		{
+			continue;
+		}
+		node = TreeCCNodeFind(context, kindName);
+		if(!node || (node->flags & (TREECC_NODE_ENUM |
+									TREECC_NODE_ENUM_VALUE)) != 0)
+		{
+			continue;
+		}
+		operCase = FindHandlingCase(oper, node);
+		if(operCase)
+		{
+			operCase->hits += count;
+			oper->hits += count;
+		}
+	}
+	fclose(file);
+}
+
 void TreeCCOperationVisitAll(TreeCCContext *context,
 							 TreeCCOperationVisitor visitor)
 {
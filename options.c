@@ -75,6 +75,144 @@ static int ReentrantOption(TreeCCContext *context, char *value, int flag)
 	}
 }
 
+/*
+ * "thread_local_state": use thread-local storage for the
+ * non-reentrant node allocation state.
+ */
+static int ThreadLocalStateOption(TreeCCContext *context,
+								  char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->thread_local_state = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "node_stats": collect allocation statistics in C and C++ allocators.
+ */
+static int NodeStatsOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->node_stats = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "free_lists": allow individual nodes to be freed and recycled
+ * in C and C++ allocators.
+ */
+static int FreeListsOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->free_lists = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "clone": generate functions that deep-copy subtrees in C and C++.
+ */
+static int CloneOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->clone_nodes = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "memory_resource": make the C++ state type a "std::pmr::memory_resource".
+ */
+static int MemoryResourceOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->memory_resource = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "propagate_resource": construct allocator-aware C++ fields
+ * using the state type as their memory resource.
+ */
+static int PropagateResourceOption(TreeCCContext *context,
+								   char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->propagate_resource = flag;
+		if(flag)
+		{
+			context->memory_resource = 1;
+		}
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "finalizers": destroy the fields of C++ nodes when the
+ * node pool is popped or cleared.
+ */
+static int FinalizersOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->finalizers = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "move_fields": move C++ constructor arguments into node fields.
+ */
+static int MoveFieldsOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->move_fields = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
 /*
  * "force": force source files to be created even if unchanged.
  */
@@ -139,6 +277,100 @@ static int KindInVtableOption(TreeCCContext *context, char *value, int flag)
 	}
 }
 
+/*
+ * "kind_ranges": number node kinds in pre-order, so that each
+ * subtree of node types has a contiguous range of kinds.
+ */
+static int KindRangesOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->kind_ranges = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "dispatch_tables": dispatch multi-trigger non-virtual operations
+ * through a table of case functions instead of nested "switch"'s.
+ */
+static int DispatchTablesOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->dispatch_tables = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "profile_dispatch": count the calls to each operation per node
+ * kind, and write the counts to a profile file at exit.
+ */
+static int ProfileDispatchOption(TreeCCContext *context,
+								 char *value, int flag)
+{
+	if(!flag)
+	{
+		if(value)
+		{
+			return TREECC_OPT_NO_VALUE;
+		}
+		context->profile_dispatch = 0;
+		return TREECC_OPT_OK;
+	}
+	context->profile_dispatch = 1;
+	if(value)
+	{
+		context->profileFile = value;
+		return TREECC_OPT_KEEP_VALUE;
+	}
+	return TREECC_OPT_OK;
+}
+
+/*
+ * "batch_operations": generate an entry point for each single-trigger
+ * non-virtual operation that processes an array of nodes.
+ */
+static int BatchOperationsOption(TreeCCContext *context,
+								 char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->batch_operations = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "flat_nodes": lay out the node types of the scripting languages
+ * without per-instance dictionaries or chained constructors.
+ */
+static int FlatNodesOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else
+	{
+		context->flat_nodes = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
 /*
  * "prefix": specify the prefix to use instead of "yy".
  */
@@ -271,37 +503,129 @@ static int LangOption(TreeCCContext *context, char *value, int flag)
 	}
 }
 
+/*
+ * Parse a decimal number option value.  Returns zero if invalid,
+ * or if the value is too large to fit in an "int".  "*num" is
+ * not changed unless the value is valid.
+ */
+static int ParseNumber(char *value, int *num)
+{
+	int maxNum = (int)(((unsigned int)(~0)) >> 1);
+	int result = 0;
+	int digit;
+	if(*value == '\0')
+	{
+		return 0;
+	}
+	while(*value >= '0' && *value <= '9')
+	{
+		digit = (int)(*value - '0');
+		if(result > (maxNum - digit) / 10)
+		{
+			return 0;
+		}
+		result = result * 10 + digit;
+		++value;
+	}
+	if(*value != '\0')
+	{
+		return 0;
+	}
+	*num = result;
+	return 1;
+}
+
 /*
  * "block_size": specify a new block size for C and C++ allocators.
  */
 static int BlockSizeOption(TreeCCContext *context, char *value, int flag)
 {
+	int num;
 	if(!value)
 	{
 		return TREECC_OPT_NEED_VALUE;
 	}
-	else if(*value == '\0')
+	else if(!ParseNumber(value, &num))
 	{
 		return TREECC_OPT_INVALID_VALUE;
 	}
+	else if(context->max_block_size && num > context->max_block_size)
+	{
+		return TREECC_OPT_CONFLICT;
+	}
 	else
 	{
-		int num = 0;
-		while(*value >= '0' && *value <= '9')
-		{
-			num = num * 10 + (int)(*value - '0');
-			++value;
-		}
-		if(*value != '\0')
-		{
-			return TREECC_OPT_INVALID_VALUE;
-		}
 		context->block_size = num;
 		return TREECC_OPT_OK;
 	}
 }
 
+/*
+ * "block_cache": specify the number of retired blocks to keep
+ * for re-use in C and C++ allocators.
+ */
+static int BlockCacheOption(TreeCCContext *context, char *value, int flag)
+{
+	if(!value)
+	{
+		return TREECC_OPT_NEED_VALUE;
+	}
+	else if(!ParseNumber(value, &(context->block_cache)))
+	{
+		return TREECC_OPT_INVALID_VALUE;
+	}
+	else
+	{
+		return TREECC_OPT_OK;
+	}
+}
 
+/*
+ * "max_block_size": specify the size that blocks in C and C++
+ * allocators may double up to.  The limit cannot be less than
+ * the initial block size.
+ */
+static int MaxBlockSizeOption(TreeCCContext *context, char *value, int flag)
+{
+	int num;
+	if(!value)
+	{
+		return TREECC_OPT_NEED_VALUE;
+	}
+	else if(!ParseNumber(value, &num))
+	{
+		return TREECC_OPT_INVALID_VALUE;
+	}
+	else if(context->block_size && num < context->block_size)
+	{
+		return TREECC_OPT_CONFLICT;
+	}
+	else
+	{
+		context->max_block_size = num;
+		return TREECC_OPT_OK;
+	}
+}
+
+/*
+ * "mmap_threshold": specify the block size at which C and C++
+ * allocators map memory directly from the operating system.
+ */
+static int MmapThresholdOption(TreeCCContext *context, char *value, int flag)
+{
+	if(!value)
+	{
+		return TREECC_OPT_NEED_VALUE;
+	}
+	else if(!ParseNumber(value, &(context->mmap_threshold)))
+	{
+		return TREECC_OPT_INVALID_VALUE;
+	}
+	else
+	{
+		return TREECC_OPT_OK;
+	}
+}
 
 /*
  * "print_lines": print out line number directives.
@@ -371,6 +695,7 @@ static int AllocatorOption(TreeCCContext *context, char *value, int flag)
 
 /*
  * "gc_allocator": use (or don't use) the libgc treecc allocator for C/C++.
+ * It cannot be combined with the shared allocator.
  */
 static int GCAllocatorOption(TreeCCContext *context, char *value, int flag)
 {
@@ -378,6 +703,10 @@ static int GCAllocatorOption(TreeCCContext *context, char *value, int flag)
 	{
 		return TREECC_OPT_NO_VALUE;
 	}
+	else if(flag && context->use_shared_allocator)
+	{
+		return TREECC_OPT_CONFLICT;
+	}
 	else
 	{
 		context->use_gc_allocator = flag;
@@ -385,6 +714,27 @@ static int GCAllocatorOption(TreeCCContext *context, char *value, int flag)
 	}
 }
 
+/*
+ * "shared_allocator": use (or don't use) the lock-free shared treecc
+ * allocator for C/C++.  It cannot be combined with the libgc allocator.
+ */
+static int SharedAllocatorOption(TreeCCContext *context, char *value, int flag)
+{
+	if(value)
+	{
+		return TREECC_OPT_NO_VALUE;
+	}
+	else if(flag && context->use_gc_allocator)
+	{
+		return TREECC_OPT_CONFLICT;
+	}
+	else
+	{
+		context->use_shared_allocator = flag;
+		return TREECC_OPT_OK;
+	}
+}
+
 /*
  * "base_type": use the type as the base type for the root treecc node 
  */
@@ -422,6 +772,22 @@ static struct
 	{"singletons",			NoSingletonsOption,		0},
 	{"reentrant",			ReentrantOption,		1},
 	{"no_reentrant",		ReentrantOption,		0},
+	{"thread_local_state",	ThreadLocalStateOption,	1},
+	{"no_thread_local_state", ThreadLocalStateOption, 0},
+	{"node_stats",			NodeStatsOption,		1},
+	{"no_node_stats",		NodeStatsOption,		0},
+	{"free_lists",			FreeListsOption,		1},
+	{"no_free_lists",		FreeListsOption,		0},
+	{"clone",				CloneOption,			1},
+	{"no_clone",			CloneOption,			0},
+	{"memory_resource",		MemoryResourceOption,	1},
+	{"no_memory_resource",	MemoryResourceOption,	0},
+	{"propagate_resource",	PropagateResourceOption, 1},
+	{"no_propagate_resource", PropagateResourceOption, 0},
+	{"finalizers",			FinalizersOption,		1},
+	{"no_finalizers",		FinalizersOption,		0},
+	{"move_fields",			MoveFieldsOption,		1},
+	{"no_move_fields",		MoveFieldsOption,		0},
 	{"force",				ForceOption,			1},
 	{"no_force",			ForceOption,			0},
 	{"virtual_factory",		VirtualFactoryOption,	1},
@@ -430,6 +796,16 @@ static struct
 	{"no_abstract_factory",	AbstractFactoryOption,	0},
 	{"kind_in_vtable",		KindInVtableOption,		1},
 	{"kind_in_node",		KindInVtableOption,		0},
+	{"kind_ranges",			KindRangesOption,		1},
+	{"no_kind_ranges",		KindRangesOption,		0},
+	{"dispatch_tables",		DispatchTablesOption,	1},
+	{"no_dispatch_tables",	DispatchTablesOption,	0},
+	{"profile_dispatch",	ProfileDispatchOption,	1},
+	{"no_profile_dispatch",	ProfileDispatchOption,	0},
+	{"batch_operations",	BatchOperationsOption,	1},
+	{"no_batch_operations",	BatchOperationsOption,	0},
+	{"flat_nodes",			FlatNodesOption,		1},
+	{"no_flat_nodes",		FlatNodesOption,		0},
 	{"prefix",				PrefixOption,			0},
 	{"state_type",			StateTypeOption,		0},
 	{"namespace",			NamespaceOption,		0},
@@ -437,6 +813,9 @@ static struct
 	{"base",				BaseOption,				0},
 	{"lang",				LangOption,				0},
 	{"block_size",			BlockSizeOption,		0},
+	{"block_cache",			BlockCacheOption,		0},
+	{"max_block_size",		MaxBlockSizeOption,		0},
+	{"mmap_threshold",		MmapThresholdOption,	0},
 	{"strip_filenames",		StripFilenamesOption,	1},
 	{"print_lines",			PrintLineNumberOption,	1},
 	{"no_print_lines",		PrintLineNumberOption,	0},
@@ -447,6 +826,8 @@ static struct
 	{"no_allocator",		AllocatorOption,		0},
 	{"gc_allocator",		GCAllocatorOption,		1},
 	{"no_gc_allocator",		GCAllocatorOption,		0},
+	{"shared_allocator",	SharedAllocatorOption,	1},
+	{"no_shared_allocator",	SharedAllocatorOption,	0},
 	{"base_type",			BaseTypeOption,			0},
 	{0,						0,						0},
 };
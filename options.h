@@ -34,6 +34,7 @@ extern	"C" {
 #define	TREECC_OPT_INVALID_VALUE	3
 #define	TREECC_OPT_NEED_VALUE		4
 #define	TREECC_OPT_NO_VALUE			5
+#define	TREECC_OPT_CONFLICT			6
 
 /*
  * Process an option declaration.
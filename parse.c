@@ -383,7 +383,8 @@ static void ValidateSuffixes(TreeCCContext *context, const char *type,
  *
  * Operation ::= %operation { OperFlag } Type [ClassName ] IDENTIFIER
  *                  '(' [ Params ] ')' [ '=' LITERAL_CODE ] [ ';' ]
- * OperFlag ::= %virtual | %inline
+ * OperFlag ::= %virtual | %inline | %split | %memoize
+ *            | %dispatch IDENTIFIER
  * ClassName ::= IDENTIFIER "::"
  * Params ::= Param { ',' Param }
  * Param ::= TypeAndName | '[' TypeAndName ']'
@@ -430,6 +431,37 @@ static void ParseOperation(TreeCCContext *context)
 			flags |= TREECC_OPER_SPLIT;
 			TreeCCNextToken(input);
 		}
+		else if(input->token == TREECC_TOKEN_MEMOIZE)
+		{
+			flags |= TREECC_OPER_MEMOIZE;
+			TreeCCNextToken(input);
+		}
+		else if(input->token == TREECC_TOKEN_DISPATCH)
+		{
+			/* The dispatch style implies a virtual operation */
+			flags |= TREECC_OPER_VIRTUAL;
+			flags &= ~(TREECC_OPER_DISPATCH_SWITCH |
+					   TREECC_OPER_DISPATCH_AUTO);
+			TreeCCNextToken(input);
+			if(input->token != TREECC_TOKEN_IDENTIFIER)
+			{
+				TreeCCError(input, "`switch', `vtable' or `auto' expected");
+				continue;
+			}
+			if(!strcmp(input->text, "switch"))
+			{
+				flags |= TREECC_OPER_DISPATCH_SWITCH;
+			}
+			else if(!strcmp(input->text, "auto"))
+			{
+				flags |= TREECC_OPER_DISPATCH_AUTO;
+			}
+			else if(strcmp(input->text, "vtable") != 0)
+			{
+				TreeCCError(input, "unknown dispatch style `%s'", input->text);
+			}
+			TreeCCNextToken(input);
+		}
 		else
 		{
 			break;
@@ -696,6 +728,38 @@ static void ParseOperation(TreeCCContext *context)
 		}
 	}
 
+	/* A memoized operation caches its result in the trigger node,
+	   so the trigger must be a node type and the only parameter */
+	if((flags & TREECC_OPER_MEMOIZE) != 0)
+	{
+		if((flags & TREECC_OPER_VIRTUAL) != 0)
+		{
+			TreeCCErrorOnLine(input, filename, linenum,
+				"`memoize' cannot be used with virtual operations");
+			flags &= ~TREECC_OPER_MEMOIZE;
+		}
+		else if(!params || params->next != 0)
+		{
+			TreeCCErrorOnLine(input, filename, linenum,
+				"memoized operations must have exactly one parameter");
+			flags &= ~TREECC_OPER_MEMOIZE;
+		}
+		else if(!strcmp(returnType, "void"))
+		{
+			TreeCCErrorOnLine(input, filename, linenum,
+				"memoized operations must return a value");
+			flags &= ~TREECC_OPER_MEMOIZE;
+		}
+		else if((typeNode = TreeCCNodeFindByType
+						(context, params->type)) == 0 ||
+				(typeNode->flags & TREECC_NODE_ENUM) != 0)
+		{
+			TreeCCErrorOnLine(input, filename, linenum,
+				"memoized operations must be triggered on a node type");
+			flags &= ~TREECC_OPER_MEMOIZE;
+		}
+	}
+
 	/* See if we already have an operation with this name */
 	oper = TreeCCOperationFind(context, name);
 	if(oper != 0)
@@ -1049,6 +1113,11 @@ static void ParseOption(TreeCCContext *context)
 		TreeCCErrorOnLine(input, filename, linenum,
 						  "option `%s' does not take a value", name);
 	}
+	else if(optValue == TREECC_OPT_CONFLICT)
+	{
+		TreeCCErrorOnLine(input, filename, linenum,
+						  "option `%s' conflicts with an earlier option", name);
+	}
 
 	/* Clean up the memory that we used */
 	free(name);
@@ -1437,6 +1506,8 @@ void TreeCCParse(TreeCCContext *context)
 			case TREECC_TOKEN_INLINE:
 			case TREECC_TOKEN_SPLIT:
 			case TREECC_TOKEN_READONLY:
+			case TREECC_TOKEN_DISPATCH:
+			case TREECC_TOKEN_MEMOIZE:
 			{
 				/* This token is not valid here */
 				TreeCCError(context->input, "declaration expected");
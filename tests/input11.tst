@@ -0,0 +1,3 @@
+// test the dispatch keyword
+%dispatch %operation
+%dispatch(a)
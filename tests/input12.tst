@@ -0,0 +1,3 @@
+// test the memoize keyword
+%operation %memoize %inline
+%memoize%split
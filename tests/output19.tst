@@ -0,0 +1,14 @@
+// test output logic for the retired block cache
+
+%option block_size = "4096"
+%option block_cache = "16"
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
@@ -0,0 +1,16 @@
+// test output logic for growing and mmap'ed blocks in C++
+
+%option lang = "C++"
+%option block_size = "4096"
+%option max_block_size = "262144"
+%option mmap_threshold = "65536"
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
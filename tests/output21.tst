@@ -0,0 +1,12 @@
+// test output logic for thread-local non-reentrant state
+
+%option thread_local_state
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
@@ -0,0 +1,20 @@
+// test output logic for allocation statistics in C++
+
+%option lang = "C++"
+%option node_stats
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
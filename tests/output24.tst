@@ -0,0 +1,21 @@
+// test output logic for free lists in C
+
+%option free_lists
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
+
+%node zero expression
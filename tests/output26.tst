@@ -0,0 +1,30 @@
+// test output logic for subtree cloning in reentrant C
+
+%option reentrant
+%option clone
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+
+%node plus binary
+
+%node negate expression =
+{
+	expression *expr;
+	%nocreate expression *folded = {0};
+}
+
+%node zero expression
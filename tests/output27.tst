@@ -0,0 +1,27 @@
+// test output logic for subtree cloning in C++
+
+%option lang = "C++"
+%option clone
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+
+%node plus binary
+
+%node negate expression =
+{
+	expression *expr;
+}
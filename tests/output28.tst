@@ -0,0 +1,23 @@
+// test output logic for memory resource propagation in C++
+
+%option lang = "C++"
+%option reentrant
+%option propagate_resource
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+	string_list names;
+	%nocreate string_list uses;
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
@@ -0,0 +1,23 @@
+// test output logic for field finalizers in reentrant C++
+
+%option lang = "C++"
+%option reentrant
+%option finalizers
+%option free_lists
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+	string_type name;
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
@@ -0,0 +1,23 @@
+// test output logic for moving constructor arguments in C++
+
+%option lang = "C++"
+%option reentrant
+%option move_fields
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+	string_type label;
+}
+
+%node intnum expression =
+{
+	int num;
+	%nocreate int flags = {0};
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
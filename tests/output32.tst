@@ -0,0 +1,20 @@
+// test output logic for the shared allocator in non-reentrant C++
+
+%option lang = "C++"
+%option shared_allocator
+%option no_track_lines
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node plus expression =
+{
+	expression *expr1;
+	expression *expr2;
+}
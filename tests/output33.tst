@@ -0,0 +1,52 @@
+// test output logic for pre-order kind numbering in C
+
+%option kind_ranges
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node literal expression %abstract
+%node intnum literal =
+{
+	int num;
+}
+%node floatnum literal =
+{
+	double num;
+}
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+%node multiply binary
+
+%node negate expression =
+{
+	expression *expr;
+}
+
+%operation int precedence(expression *e) = {0}
+
+precedence(literal)
+{
+	return 3;
+}
+
+precedence(binary)
+{
+	return 1;
+}
+
+precedence(multiply)
+{
+	return 2;
+}
+
+precedence(negate)
+{
+	return 3;
+}
@@ -0,0 +1,33 @@
+// test output logic for interval-based isA checks in C++
+
+%option lang = "C++"
+%option kind_ranges
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node literal expression %abstract
+%node intnum literal =
+{
+	int num;
+}
+%node floatnum literal =
+{
+	double num;
+}
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+
+%node negate expression =
+{
+	expression *expr;
+}
+
+%node statement %abstract %typedef
+%node return_stmt statement
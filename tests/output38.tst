@@ -0,0 +1,81 @@
+// test output logic for switch-dispatched virtual operations in C
+
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+%node multiply binary
+
+%node intnum expression =
+{
+	int num;
+}
+%node negate expression =
+{
+	expression *expr;
+}
+
+%operation %dispatch switch int eval(expression *e)
+
+eval(intnum)
+{
+	return e->num;
+}
+
+eval(negate)
+{
+	return -eval(e->expr);
+}
+
+eval(plus)
+{
+	return eval(e->expr1) + eval(e->expr2);
+}
+
+eval(binary)
+{
+	return eval(e->expr1) * eval(e->expr2);
+}
+
+%operation %dispatch switch void clear(expression *e, int value)
+
+clear(intnum)
+{
+	e->num = value;
+}
+
+clear(binary), clear(negate)
+{
+	(void)e;
+}
+
+%operation %dispatch auto int depth(expression *e)
+
+depth(expression)
+{
+	return 1;
+}
+
+depth(binary)
+{
+	return 1 + depth(e->expr1);
+}
+
+%operation %dispatch vtable int is_literal(expression *e)
+
+is_literal(intnum)
+{
+	return 1;
+}
+
+is_literal(expression)
+{
+	return 0;
+}
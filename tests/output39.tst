@@ -0,0 +1,82 @@
+// test output logic for switch-dispatched virtual operations in C++
+
+%option lang = "C++"
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+%node multiply binary
+
+%node intnum expression =
+{
+	int num;
+}
+%node negate expression =
+{
+	expression *expr;
+}
+
+%operation %dispatch switch int eval(expression *this)
+
+eval(intnum)
+{
+	return num;
+}
+
+eval(negate)
+{
+	return -expr->eval();
+}
+
+eval(plus)
+{
+	return expr1->eval() + expr2->eval();
+}
+
+eval(binary)
+{
+	return expr1->eval() * expr2->eval();
+}
+
+%operation %dispatch switch void clear(expression *this, int value)
+
+clear(intnum)
+{
+	num = value;
+}
+
+clear(binary), clear(negate)
+{
+	(void)value;
+}
+
+%operation %dispatch auto int depth(expression *this)
+
+depth(expression)
+{
+	return 1;
+}
+
+depth(binary)
+{
+	return 1 + expr1->depth();
+}
+
+%operation %dispatch vtable int is_literal(expression *this)
+
+is_literal(intnum)
+{
+	return 1;
+}
+
+is_literal(expression)
+{
+	return 0;
+}
@@ -0,0 +1,80 @@
+// test output logic for dispatch profiling in C
+
+%option profile_dispatch = "expr.prof"
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+
+%node intnum expression =
+{
+	int num;
+}
+%node negate expression =
+{
+	expression *expr;
+}
+
+%enum type_code =
+{
+	int_type,
+	float_type
+}
+
+%operation int eval(expression *e) = {0}
+
+eval(intnum)
+{
+	return e->num;
+}
+
+eval(negate)
+{
+	return -eval(e->expr);
+}
+
+eval(plus)
+{
+	return eval(e->expr1) + eval(e->expr2);
+}
+
+eval(minus)
+{
+	return eval(e->expr1) - eval(e->expr2);
+}
+
+%operation %virtual int size(expression *e)
+
+size(intnum)
+{
+	return 1;
+}
+
+size(negate)
+{
+	return 1 + size(e->expr);
+}
+
+size(binary)
+{
+	return 1 + size(e->expr1) + size(e->expr2);
+}
+
+%operation int type_size(type_code type) = {0}
+
+type_size(int_type)
+{
+	return 4;
+}
+
+type_size(float_type)
+{
+	return 8;
+}
@@ -0,0 +1,63 @@
+// test output logic for profile-guided case ordering in Python
+
+%option lang = "Python"
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression expr1;
+	expression expr2;
+}
+%node plus binary
+%node minus binary
+%node multiply binary
+
+%node intnum expression =
+{
+	int num;
+}
+%node negate expression =
+{
+	expression expr;
+}
+
+%operation int eval(expression e) = {0}
+
+eval(intnum)
+{
+	return e.num
+}
+
+eval(negate)
+{
+	return -eval(e.expr)
+}
+
+eval(plus)
+{
+	return eval(e.expr1) + eval(e.expr2)
+}
+
+eval(binary)
+{
+	return eval(e.expr1) * eval(e.expr2)
+}
+
+%operation %inline int weight(expression e) = {0}
+
+weight(intnum)
+{
+	return 1
+}
+
+weight(negate)
+{
+	return 2
+}
+
+weight(binary)
+{
+	return 3
+}
@@ -0,0 +1,75 @@
+// test output logic for batched operation entry points in C
+
+%option no_track_lines
+%option batch_operations
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node minus binary
+%node multiply binary
+
+%node intnum expression =
+{
+	int num;
+}
+%node negate expression =
+{
+	expression *expr;
+}
+
+%operation int eval(expression *e) = {0}
+
+eval(plus)
+{
+	return eval(e->expr1) + eval(e->expr2);
+}
+
+eval(minus)
+{
+	return eval(e->expr1) - eval(e->expr2);
+}
+
+eval(binary)
+{
+	return eval(e->expr1) * eval(e->expr2);
+}
+
+eval(intnum)
+{
+	return e->num;
+}
+
+eval(negate)
+{
+	return -eval(e->expr);
+}
+
+%operation %inline int scaled(int scale, [expression *e], int bias) = {-1}
+
+scaled(intnum)
+{
+	return scale * e->num + bias;
+}
+
+scaled(expression)
+{
+	return bias;
+}
+
+%operation void mark(expression *e, int value)
+
+mark(expression)
+{
+	(void)e;
+}
+
+mark(intnum)
+{
+	e->num = value;
+}
@@ -0,0 +1,47 @@
+// test output logic for memoized operations in C
+
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node binary expression %abstract =
+{
+	expression *expr1;
+	expression *expr2;
+}
+%node plus binary
+%node multiply binary
+
+%node intnum expression =
+{
+	int num;
+}
+
+%operation %memoize int eval(expression *e) = {0}
+
+eval(plus)
+{
+	return eval(e->expr1) + eval(e->expr2);
+}
+
+eval(multiply)
+{
+	return eval(e->expr1) * eval(e->expr2);
+}
+
+eval(intnum)
+{
+	return e->num;
+}
+
+%operation %memoize %inline int is_constant(expression *) = {0}
+
+is_constant(binary)
+{
+	return 0;
+}
+
+is_constant(intnum)
+{
+	return 1;
+}
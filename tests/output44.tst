@@ -0,0 +1,39 @@
+// test output logic for dispatch tables in Python
+
+%option lang = "Python"
+%option dispatch_tables
+%option no_track_lines
+
+%enum op = { A, B }
+
+%node expr %abstract %typedef
+%node leaf expr %abstract
+%node num leaf = { int v; }
+%node ident leaf = { int n; }
+%node binary expr %abstract = { expr *l; expr *r; }
+%node add binary
+%node sub binary
+%node neg expr = { expr *e; }
+
+%operation int eval(expr *e) = {0}
+eval(num) { return e.v }
+eval(ident) { return 100 }
+eval(add) { return eval(e.l) + eval(e.r) }
+eval(binary) { return eval(e.l) - eval(e.r) }
+eval(neg) { return -eval(e.e) }
+
+%operation %inline int scale(expr *e, int k) = {-1}
+scale(leaf) { return k }
+scale(expr) { return k * 2 }
+
+%operation int multi([expr *e], [op o]) = {0}
+multi(num, A) { return 1 }
+multi(num, B) { return 2 }
+multi(leaf, op) { return 3 }
+multi(binary, op) { return 4 }
+multi(add, op) { return 5 }
+multi(neg, op) { return 6 }
+
+%operation void show(op o, [op p])
+show(A) { print("A", o) }
+show(B) { print("B", o) }
@@ -0,0 +1,23 @@
+// test output logic for flat node layout in Python
+
+%option lang = "Python"
+%option flat_nodes
+
+%node expr %abstract %typedef
+%node leaf expr %abstract
+%node num leaf = { int v; }
+%node ident leaf = { int n; }
+%node binary expr %abstract = { expr *l; expr *r; }
+%node add binary
+%node neg expr = { expr *e; }
+%node withdef neg = { %nocreate int z = {42}; int w; }
+
+%operation %virtual int vv(expr *e) = {1}
+vv(expr) { return 1 }
+vv(num) { return 2 }
+
+%operation int eval(expr *e) = {0}
+eval(num) { return e.v }
+eval(ident) { return 100 }
+eval(add) { return eval(e.l) + eval(e.r) }
+eval(neg) { return -eval(e.e) }
@@ -0,0 +1,40 @@
+// test output logic for dispatch tables and flat nodes in Ruby
+
+%option lang = "Ruby"
+%option dispatch_tables
+%option flat_nodes
+
+%enum Op = { A, B }
+
+%node Expr %abstract %typedef
+%node Leaf Expr %abstract
+%node Num Leaf = { int v; }
+%node Ident Leaf = { int n; }
+%node Binary Expr %abstract = { Expr *l; Expr *r; }
+%node Add Binary
+%node Sub Binary
+%node Neg Expr = { Expr *e; }
+%node Withdef Neg = { %nocreate int z = {42}; int w; }
+
+%operation int Ops::ev(Expr *e) = {0}
+ev(Num) { return e.v }
+ev(Ident) { return 100 }
+ev(Add) { return Ops.ev(e.l) + Ops.ev(e.r) }
+ev(Binary) { return Ops.ev(e.l) - Ops.ev(e.r) }
+ev(Neg) { return -Ops.ev(e.e) }
+
+%operation %inline int Ops::scale(Expr *e, int k) = {-1}
+scale(Leaf) { return k }
+scale(Expr) { return k * 2 }
+
+%operation int Ops::multi([Expr *e], [Op o]) = {0}
+multi(Num, A) { return 1 }
+multi(Num, B) { return 2 }
+multi(Leaf, Op) { return 3 }
+multi(Binary, Op) { return 4 }
+multi(Add, Op) { return 5 }
+multi(Neg, Op) { return 6 }
+
+%operation void Ops::show(Op o, [Op p])
+show(A) { puts "A" }
+show(B) { puts "B" }
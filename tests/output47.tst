@@ -0,0 +1,40 @@
+// test output logic for dispatch tables and flat nodes in PHP
+
+%option lang = "PHP"
+%option dispatch_tables
+%option flat_nodes
+
+%enum Op = { A, B }
+
+%node Expr %abstract %typedef
+%node Leaf Expr %abstract
+%node Num Leaf = { int v; double f; char *s; Op o; }
+%node Ident Leaf = { int n; }
+%node Binary Expr %abstract = { Expr *l; Expr *r; }
+%node Add Binary
+%node Sub Binary
+%node Neg Expr = { Expr *e; }
+%node Withdef Neg = { %nocreate int z = {42}; int w; }
+
+%operation int ev(Expr *e) = {0}
+ev(Num) { return $e->v; }
+ev(Ident) { return 100; }
+ev(Add) { return ev($e->l) + ev($e->r); }
+ev(Binary) { return ev($e->l) - ev($e->r); }
+ev(Neg) { return -ev($e->e); }
+
+%operation %inline int scale(Expr *e, int k) = {-1}
+scale(Leaf) { return $k; }
+scale(Expr) { return $k * 2; }
+
+%operation int multi([Expr *e], [Op o]) = {0}
+multi(Num, A) { return 1; }
+multi(Num, B) { return 2; }
+multi(Leaf, Op) { return 3; }
+multi(Binary, Op) { return 4; }
+multi(Add, Op) { return 5; }
+multi(Neg, Op) { return 6; }
+
+%operation void show(Op o, [Op p])
+show(A) { echo "A\n"; }
+show(B) { echo "B\n"; }
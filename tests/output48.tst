@@ -0,0 +1,13 @@
+// test C++ output logic for thread-local non-reentrant state
+
+%option lang = "C++"
+%option thread_local_state
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
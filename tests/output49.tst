@@ -0,0 +1,22 @@
+// test output logic for cloning nodes with propagated memory resources
+
+%option lang = "C++"
+%option clone
+%option propagate_resource
+%option finalizers
+
+%node expression %abstract %typedef =
+{
+	string_list names;
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%node negate expression =
+{
+	expression *expr;
+	%nocreate string_list uses;
+}
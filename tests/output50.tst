@@ -0,0 +1,75 @@
+// test output logic for table-driven multi-trigger dispatch in C++
+
+%option lang = "C++"
+%option dispatch_tables
+%option no_track_lines
+
+%{
+#include <cstdlib>
+#include "output.h"
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int num;
+}
+%node floatnum expression =
+{
+	double num;
+}
+%node negate expression =
+{
+	expression *expr;
+}
+
+%enum type_code =
+{
+	int_type,
+	float_type
+}
+
+%enum binop =
+{
+	add_op,
+	mul_op
+}
+
+%operation int combine([expression *e1], [expression *e2], [binop op]) = {-1}
+
+combine(intnum, intnum, add_op)
+{
+	return e1->num + e2->num;
+}
+
+combine(intnum, intnum, mul_op)
+{
+	return e1->num * e2->num;
+}
+
+combine(expression, floatnum, binop),
+combine(floatnum, expression, binop)
+{
+	return 100;
+}
+
+combine(negate, expression, binop),
+combine(intnum, negate, binop)
+{
+	return 200;
+}
+
+%operation %inline void coerce([expression *e], [type_code t])
+
+coerce(intnum, int_type),
+coerce(floatnum, float_type)
+{
+	(void)e;
+}
+
+coerce(expression, type_code)
+{
+	(void)e;
+	std::abort();
+}
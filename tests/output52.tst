@@ -0,0 +1,18 @@
+// test output logic for memoized operations with thread-local state in C
+
+%option thread_local_state
+%option no_track_lines
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int num;
+}
+
+%operation %memoize int eval(expression *e) = {0}
+
+eval(intnum)
+{
+	return e->num;
+}
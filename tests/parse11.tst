@@ -0,0 +1,9 @@
+// test block size option conflicts
+
+%option block_size = "4096"
+%option max_block_size = "1024"
+%option max_block_size = "16384"
+%option block_size = "32768"
+%option block_size = "8192"
+
+%node expr %typedef
@@ -0,0 +1,9 @@
+// test allocator option conflicts
+
+%option gc_allocator
+%option shared_allocator
+%option no_gc_allocator
+%option shared_allocator
+%option gc_allocator
+
+%node expr %typedef
@@ -0,0 +1,24 @@
+// test memoized operation diagnostics
+
+%node expr %abstract %typedef
+%node intnum expr
+
+%enum kind =
+{
+	small,
+	large
+}
+
+%operation %memoize %virtual int eval1(expr *e)
+%operation %memoize int eval2(expr *e, int x) = {0}
+%operation %memoize int eval3() = {0}
+%operation %memoize void eval4(expr *e)
+%operation %memoize int eval5(kind k) = {0}
+%operation %memoize int eval6(expr *e) = {0}
+
+eval1(intnum) { return 1; }
+eval2(intnum) { return 2; }
+eval3() { return 3; }
+eval4(intnum) {}
+eval5(small), eval5(large) { return 5; }
+eval6(intnum) { return 6; }
@@ -0,0 +1,11 @@
+// test numeric option values that do not fit in an "int"
+
+%option block_size = "99999999999"
+%option max_block_size = "99999999999"
+%option mmap_threshold = "4294967296"
+%option block_cache = "2147483648"
+%option block_size = "12x"
+%option max_block_size = "2147483647"
+%option block_size = "8192"
+
+%node expr %typedef
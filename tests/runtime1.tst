@@ -0,0 +1,58 @@
+// test that the fields of adopted nodes follow them to the new pool
+
+%option lang = "C++"
+%option reentrant
+%option propagate_resource
+%option finalizers
+%option free_lists
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+#include <string>
+#include <vector>
+typedef std::pmr::vector<std::pmr::string> string_list;
+%}
+%{
+#include "runtime1.h"
+%}
+
+%node expression %abstract %typedef =
+{
+}
+
+%node word expression =
+{
+	string_list names;
+}
+
+%end %{
+#define	LONG_NAME	"a name that is too long to be stored inline"
+
+int main()
+{
+	YYNODESTATE pool;
+	YYNODESTATE src;
+	word *node = src.wordCreate(string_list());
+	node->names.push_back(LONG_NAME);
+	const char *name = node->names[0].data();
+	pool.adopt(&src);
+
+	/* The fields of the adopted node must grow in the new pool */
+	unsigned long requested = src.stats().requested;
+	node->names.push_back(LONG_NAME);
+	if(src.stats().requested != requested)
+	{
+		return 1;
+	}
+
+	/* Destroying the fields must not recycle memory into the old pool */
+	pool.clear();
+	if(src.allocate(sizeof(LONG_NAME), 1) == (void *)name)
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
@@ -0,0 +1,121 @@
+// test that C++ node pools adopt nodes that survive pops in the new pool
+
+%option lang = "C++"
+%option reentrant
+%option finalizers
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+#include <string>
+
+struct tracked
+{
+	std::string name;
+	static int destroyed;
+
+	tracked() : name("a name that is too long to be stored inline") {}
+	tracked(const tracked &other) : name(other.name) {}
+	~tracked() { ++destroyed; }
+};
+%}
+%{
+#include "runtime10.h"
+
+int tracked::destroyed = 0;
+%}
+
+%node expression %abstract %typedef =
+{
+}
+
+%node leaf expression =
+{
+	int value;
+	%nocreate tracked item;
+}
+
+%end %{
+int main()
+{
+	YYNODESTATE dst;
+	YYNODESTATE src;
+	YYNODESTATE third;
+	int index;
+
+	/* Build nodes in the source, and adopt them into a destination
+	   that has open pushes */
+	leaf *keep = dst.leafCreate(1);
+	if(!dst.push() || !dst.leafCreate(2) || !dst.push())
+	{
+		return 1;
+	}
+	leaf *node = src.leafCreate(3);
+	if(!src.alloc(10000))
+	{
+		return 1;
+	}
+	dst.adopt(&src);
+	if(src.stats().reserved != 0 || dst.stats().reserved < 10000)
+	{
+		return 1;
+	}
+
+	/* New nodes in the destination must not overlap the adopted ones */
+	for(index = 0; index < 1000; ++index)
+	{
+		if(dst.leafCreate(4) == node)
+		{
+			return 1;
+		}
+	}
+
+	/* The adopted nodes survive popping the destination */
+	dst.pop();
+	dst.pop();
+	if(tracked::destroyed != 1001 || node->value != 3 ||
+	   node->item.name.size() < 20 || keep->value != 1 ||
+	   dst.stats().reserved < 10000)
+	{
+		return 1;
+	}
+
+	/* The emptied source can be used again, and adopted again
+	   by way of another pool that adopts it first */
+	leaf *other = src.leafCreate(5);
+	if(!other || node->value != 3)
+	{
+		return 1;
+	}
+	leaf *last = third.leafCreate(6);
+	third.adopt(&src);
+	dst.adopt(&third);
+	if(!dst.push())
+	{
+		return 1;
+	}
+	dst.pop();
+	src.clear();
+	third.clear();
+	if(tracked::destroyed != 1001 || other->value != 5 ||
+	   last->value != 6 || node->value != 3)
+	{
+		return 1;
+	}
+
+	/* Clearing the destination finalizes and frees the adopted nodes */
+	dst.clear();
+	if(tracked::destroyed != 1001 + 4 || dst.stats().reserved != 0 ||
+	   dst.stats().blocks != 0)
+	{
+		return 1;
+	}
+	if(!src.leafCreate(7))
+	{
+		return 1;
+	}
+	src.clear();
+	return (tracked::destroyed == 1001 + 5 ? 0 : 1);
+}
+%}
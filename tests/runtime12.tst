@@ -0,0 +1,76 @@
+// test that a thread can alternate between C++ shared allocator pools
+
+%option lang = "C++"
+%option reentrant
+%option shared_allocator
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime12.h"
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int num;
+}
+
+%end %{
+#define	NUM_NODES	1000
+
+static expression *nodes[2][NUM_NODES];
+
+int main()
+{
+	YYNODESTATE a;
+	YYNODESTATE b;
+	int index;
+	int far;
+	long gap;
+
+	/* Alternate between the two pools */
+	for(index = 0; index < NUM_NODES; ++index)
+	{
+		nodes[0][index] = a.intnumCreate(index);
+		nodes[1][index] = b.intnumCreate(-index);
+		if(!(nodes[0][index]) || !(nodes[1][index]))
+		{
+			return 1;
+		}
+	}
+
+	/* Consecutive nodes from each pool should share a chunk, apart
+	   from when one chunk is exhausted and the next is started */
+	far = 0;
+	for(index = 1; index < NUM_NODES; ++index)
+	{
+		gap = (long)((char *)(nodes[0][index]) - (char *)(nodes[0][index - 1]));
+		if(gap < 0 || gap > 64)
+		{
+			++far;
+		}
+		gap = (long)((char *)(nodes[1][index]) - (char *)(nodes[1][index - 1]));
+		if(gap < 0 || gap > 64)
+		{
+			++far;
+		}
+	}
+	if(far > NUM_NODES / 20)
+	{
+		return 1;
+	}
+	for(index = 0; index < NUM_NODES; ++index)
+	{
+		if(((intnum *)(nodes[0][index]))->num != index ||
+		   ((intnum *)(nodes[1][index]))->num != -index)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+%}
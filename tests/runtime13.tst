@@ -0,0 +1,60 @@
+// test that thread-local state gives each thread its own memo generation
+
+%option lang = "C++"
+%option thread_local_state
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime13.h"
+#include <thread>
+
+static int evaluations = 0;
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int value;
+}
+
+%operation %memoize int eval(expression *e) = {0}
+
+eval(intnum)
+{
+	++evaluations;
+	return e->value;
+}
+
+%end %{
+int main()
+{
+	YYNODESTATE pool;
+	expression *node = new intnum(42);
+
+	/* The second call returns the cached result */
+	if(eval(node) != 42 || eval(node) != 42 || evaluations != 1)
+	{
+		return 1;
+	}
+
+	/* Invalidating in another thread keeps this thread's results */
+	std::thread other([] { yymemoinvalidate(); });
+	other.join();
+	if(eval(node) != 42 || evaluations != 1)
+	{
+		return 1;
+	}
+
+	/* Invalidating in this thread computes the result again */
+	yymemoinvalidate();
+	if(eval(node) != 42 || evaluations != 2)
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
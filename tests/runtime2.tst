@@ -0,0 +1,55 @@
+// test that cloned nodes allocate their fields from the new pool
+
+%option lang = "C++"
+%option reentrant
+%option clone
+%option propagate_resource
+%option finalizers
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+#include <string>
+#include <vector>
+typedef std::pmr::vector<std::pmr::string> string_list;
+%}
+%{
+#include "runtime2.h"
+%}
+
+%node expression %abstract %typedef =
+{
+	string_list names;
+}
+
+%node negate expression =
+{
+	expression *expr;
+}
+
+%node word expression
+
+%end %{
+int main()
+{
+	YYNODESTATE src;
+	YYNODESTATE pool;
+	string_list names;
+	names.push_back("a name that is too long to be stored inline");
+	expression *tree = src.negateCreate
+		(names, src.wordCreate(names));
+	expression *copy = tree->clone(&pool);
+	if(!copy || copy->names.size() != 1 ||
+	   static_cast<negate *>(copy)->expr->names.size() != 1)
+	{
+		return 1;
+	}
+	if(copy->names.get_allocator().resource() != pool.resource() ||
+	   static_cast<negate *>(copy)->expr->names.get_allocator().resource()
+	   		!= pool.resource())
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
@@ -0,0 +1,85 @@
+// test that finalizers are cancelled, recycled, and adopted correctly
+
+%option lang = "C++"
+%option reentrant
+%option finalizers
+%option free_lists
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+#include <string>
+
+struct tracked
+{
+	std::string name;
+	static int destroyed;
+
+	tracked() : name("a name that is too long to be stored inline") {}
+	tracked(const tracked &other) : name(other.name) {}
+	~tracked() { ++destroyed; }
+};
+%}
+%{
+#include "runtime3.h"
+
+int tracked::destroyed = 0;
+%}
+
+%node expression %abstract %typedef =
+{
+}
+
+%node leaf expression =
+{
+	%nocreate tracked value;
+}
+
+%end %{
+int main()
+{
+	YYNODESTATE pool;
+	YYNODESTATE src;
+	int index;
+
+	/* Freeing a node cancels its finalizer and recycles the record */
+	pool.nodeFree(pool.leafCreate());
+	unsigned long blocks = pool.stats().blocks;
+	for(index = 0; index < 10000; ++index)
+	{
+		pool.nodeFree(pool.leafCreate());
+	}
+	if(pool.stats().blocks != blocks || tracked::destroyed != 10001)
+	{
+		return 1;
+	}
+
+	/* Rolling back past an adoption keeps the adopted nodes,
+	   and clearing runs their finalizers */
+	YYNODESTATE::Mark mark = pool.mark();
+	for(index = 0; index < 10; ++index)
+	{
+		src.leafCreate();
+	}
+	leaf *freed = src.leafCreate();
+	pool.adopt(&src);
+	pool.nodeFree(freed);
+	pool.leafCreate();
+	pool.rollback(mark);
+	if(tracked::destroyed != 10001 + 2)
+	{
+		return 1;
+	}
+	pool.clear();
+	if(tracked::destroyed != 10001 + 12)
+	{
+		return 1;
+	}
+
+	/* Nothing is finalized twice */
+	pool.clear();
+	src.clear();
+	return (tracked::destroyed == 10001 + 12 ? 0 : 1);
+}
+%}
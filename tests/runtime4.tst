@@ -0,0 +1,69 @@
+// test that pools using the shared allocator can be adopted repeatedly
+
+%option lang = "C++"
+%option reentrant
+%option shared_allocator
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime4.h"
+%}
+
+%node expression %abstract %typedef =
+{
+}
+
+%node intnum expression =
+{
+	int num;
+}
+
+%end %{
+#define	NUM_NODES	100000
+
+static intnum *nodes[3][NUM_NODES];
+
+int main()
+{
+	YYNODESTATE pools[3];
+	YYNODESTATE merged;
+	int pool;
+	int index;
+
+	/* Fill each pool with more blocks than fit in one chunk */
+	for(pool = 0; pool < 3; ++pool)
+	{
+		for(index = 0; index < NUM_NODES; ++index)
+		{
+			nodes[pool][index] = pools[pool].intnumCreate(index);
+		}
+	}
+
+	/* Adopt into an empty pool and then into a full one */
+	merged.adopt(&pools[0]);
+	merged.adopt(&pools[1]);
+	pools[1].adopt(&pools[2]);
+	merged.adopt(&pools[1]);
+	for(pool = 0; pool < 3; ++pool)
+	{
+		for(index = 0; index < NUM_NODES; ++index)
+		{
+			if(nodes[pool][index]->num != index)
+			{
+				return 1;
+			}
+		}
+	}
+
+	/* The emptied pools can be re-used */
+	if(pools[0].intnumCreate(42)->num != 42)
+	{
+		return 1;
+	}
+	merged.clear();
+	return 0;
+}
+%}
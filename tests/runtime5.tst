@@ -0,0 +1,102 @@
+// test that C nodes larger than the block size get blocks of their own
+
+%option lang = "C"
+%option block_size = "64"
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include <string.h>
+#include "runtime5.h"
+%}
+
+%node expression %abstract %typedef
+
+%node small expression =
+{
+	int value;
+}
+
+%node big expression =
+{
+	%nocreate double d0 = {0.0};
+	%nocreate double d1 = {0.0};
+	%nocreate double d2 = {0.0};
+	%nocreate double d3 = {0.0};
+	%nocreate double d4 = {0.0};
+	%nocreate double d5 = {0.0};
+	%nocreate double d6 = {0.0};
+	%nocreate double d7 = {0.0};
+	%nocreate double d8 = {0.0};
+	%nocreate double d9 = {0.0};
+	int value;
+}
+
+%end %{
+void yynodefailed(void)
+{
+}
+
+int main(void)
+{
+	expression *node;
+	expression *other;
+	char *huge;
+	unsigned long reserved;
+
+	yynodeinit();
+	if(sizeof(big) <= 64)
+	{
+		return 1;
+	}
+
+	/* Oversized nodes are allocated, and do not disturb small nodes */
+	node = small_create(1);
+	reserved = yynodestats()->reserved;
+	if(!yynodepush())
+	{
+		return 1;
+	}
+	other = big_create(2);
+	if(!other || ((big *)other)->value != 2 || ((big *)other)->d9 != 0.0)
+	{
+		return 1;
+	}
+	huge = (char *)yynodealloc(10000);
+	if(!huge)
+	{
+		return 1;
+	}
+	memset(huge, 0xAA, 10000);
+	if(!small_create(3) || ((small *)node)->value != 1)
+	{
+		return 1;
+	}
+	if(yynodestats()->reserved < reserved + 10000 + sizeof(big))
+	{
+		return 1;
+	}
+
+	/* Popping releases the dedicated blocks */
+	yynodepop();
+	if(yynodestats()->reserved != reserved || ((small *)node)->value != 1)
+	{
+		return 1;
+	}
+
+	/* Clearing releases them too */
+	if(!big_create(4) || !yynodealloc(10000))
+	{
+		return 1;
+	}
+	yynodeclear();
+	if(yynodestats()->reserved != 0 || yynodestats()->blocks != 0)
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
@@ -0,0 +1,93 @@
+// test that C++ nodes larger than the block size get blocks of their own
+
+%option lang = "C++"
+%option block_size = "64"
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include <string.h>
+#include "runtime6.h"
+%}
+
+%node expression %abstract %typedef
+
+%node small expression =
+{
+	int value;
+}
+
+%node big expression =
+{
+	%nocreate double d0 = {0.0};
+	%nocreate double d1 = {0.0};
+	%nocreate double d2 = {0.0};
+	%nocreate double d3 = {0.0};
+	%nocreate double d4 = {0.0};
+	%nocreate double d5 = {0.0};
+	%nocreate double d6 = {0.0};
+	%nocreate double d7 = {0.0};
+	%nocreate double d8 = {0.0};
+	%nocreate double d9 = {0.0};
+	int value;
+}
+
+%end %{
+int main()
+{
+	YYNODESTATE pool;
+	if(sizeof(big) <= 64)
+	{
+		return 1;
+	}
+
+	/* Oversized nodes are allocated, and do not disturb small nodes */
+	small *node = new small(1);
+	unsigned long reserved = pool.stats().reserved;
+	if(!pool.push())
+	{
+		return 1;
+	}
+	big *other = new big(2);
+	if(!other || other->value != 2 || other->d9 != 0.0)
+	{
+		return 1;
+	}
+	char *huge = (char *)pool.alloc(10000);
+	if(!huge)
+	{
+		return 1;
+	}
+	memset(huge, 0xAA, 10000);
+	if(!new small(3) || node->value != 1)
+	{
+		return 1;
+	}
+	if(pool.stats().reserved < reserved + 10000 + sizeof(big))
+	{
+		return 1;
+	}
+
+	/* Popping releases the dedicated blocks */
+	pool.pop();
+	if(pool.stats().reserved != reserved || node->value != 1)
+	{
+		return 1;
+	}
+
+	/* Clearing releases them too */
+	if(!new big(4) || !pool.alloc(10000))
+	{
+		return 1;
+	}
+	pool.clear();
+	if(pool.stats().reserved != 0 || pool.stats().blocks != 0)
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
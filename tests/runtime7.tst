@@ -0,0 +1,127 @@
+// test that C allocation marks roll back, commit, and nest with pushes
+
+%option lang = "C"
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime7.h"
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int value;
+}
+
+%end %{
+void yynodefailed(void)
+{
+}
+
+/*
+ * Get the address that the next node will be allocated at.
+ */
+static expression *next_node(void)
+{
+	YYNODESTATE_mark mark = yynodemark();
+	expression *node = intnum_create(0);
+	yynoderollback(mark);
+	return node;
+}
+
+int main(void)
+{
+	YYNODESTATE_mark mark;
+	YYNODESTATE_mark inner;
+	expression *first;
+	expression *node;
+	expression *posn;
+
+	yynodeinit();
+	first = intnum_create(1);
+
+	/* Rolling back hands out the same memory again */
+	mark = yynodemark();
+	node = intnum_create(2);
+	yynoderollback(mark);
+	if(intnum_create(3) != node || ((intnum *)first)->value != 1)
+	{
+		return 1;
+	}
+
+	/* Committing keeps the nodes */
+	mark = yynodemark();
+	node = intnum_create(4);
+	yynodecommit(mark);
+	if(intnum_create(5) == node || ((intnum *)node)->value != 4)
+	{
+		return 1;
+	}
+
+	/* Marks can be nested and rolled back in order */
+	mark = yynodemark();
+	posn = intnum_create(6);
+	inner = yynodemark();
+	node = intnum_create(7);
+	yynoderollback(inner);
+	if(intnum_create(8) != node)
+	{
+		return 1;
+	}
+	yynoderollback(mark);
+	if(next_node() != posn)
+	{
+		return 1;
+	}
+
+	/* A mark within a push is rolled back without popping it */
+	posn = next_node();
+	if(!yynodepush())
+	{
+		return 1;
+	}
+	mark = yynodemark();
+	node = intnum_create(9);
+	yynoderollback(mark);
+	if(intnum_create(10) != node)
+	{
+		return 1;
+	}
+	yynodepop();
+	if(next_node() != posn)
+	{
+		return 1;
+	}
+
+	/* Rolling back past a push discards it, so the next pop
+	   returns to the push that was made before the mark */
+	posn = next_node();
+	if(!yynodepush())
+	{
+		return 1;
+	}
+	node = intnum_create(11);
+	mark = yynodemark();
+	if(!yynodepush())
+	{
+		return 1;
+	}
+	intnum_create(12);
+	yynoderollback(mark);
+	if(((intnum *)node)->value != 11)
+	{
+		return 1;
+	}
+	yynodepop();
+	if(next_node() != posn || ((intnum *)first)->value != 1)
+	{
+		return 1;
+	}
+	yynodeclear();
+	return 0;
+}
+%}
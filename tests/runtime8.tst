@@ -0,0 +1,116 @@
+// test that C++ allocation marks roll back, commit, and nest with pushes
+
+%option lang = "C++"
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime8.h"
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int value;
+}
+
+%end %{
+/*
+ * Get the address that the next node will be allocated at.
+ */
+static expression *next_node(YYNODESTATE &pool)
+{
+	YYNODESTATE::Mark mark = pool.mark();
+	expression *node = new intnum(0);
+	pool.rollback(mark);
+	return node;
+}
+
+int main()
+{
+	YYNODESTATE pool;
+	intnum *first = new intnum(1);
+
+	/* Rolling back hands out the same memory again */
+	YYNODESTATE::Mark mark = pool.mark();
+	intnum *node = new intnum(2);
+	pool.rollback(mark);
+	if(new intnum(3) != node || first->value != 1)
+	{
+		return 1;
+	}
+
+	/* Committing keeps the nodes */
+	mark = pool.mark();
+	node = new intnum(4);
+	pool.commit(mark);
+	if(new intnum(5) == node || node->value != 4)
+	{
+		return 1;
+	}
+
+	/* Marks can be nested and rolled back in order */
+	mark = pool.mark();
+	expression *posn = new intnum(6);
+	YYNODESTATE::Mark inner = pool.mark();
+	node = new intnum(7);
+	pool.rollback(inner);
+	if(new intnum(8) != node)
+	{
+		return 1;
+	}
+	pool.rollback(mark);
+	if(next_node(pool) != posn)
+	{
+		return 1;
+	}
+
+	/* A mark within a push is rolled back without popping it */
+	posn = next_node(pool);
+	if(!pool.push())
+	{
+		return 1;
+	}
+	mark = pool.mark();
+	node = new intnum(9);
+	pool.rollback(mark);
+	if(new intnum(10) != node)
+	{
+		return 1;
+	}
+	pool.pop();
+	if(next_node(pool) != posn)
+	{
+		return 1;
+	}
+
+	/* Rolling back past a push discards it, so the next pop
+	   returns to the push that was made before the mark */
+	posn = next_node(pool);
+	if(!pool.push())
+	{
+		return 1;
+	}
+	node = new intnum(11);
+	mark = pool.mark();
+	if(!pool.push())
+	{
+		return 1;
+	}
+	new intnum(12);
+	pool.rollback(mark);
+	if(node->value != 11)
+	{
+		return 1;
+	}
+	pool.pop();
+	if(next_node(pool) != posn || first->value != 1)
+	{
+		return 1;
+	}
+	return 0;
+}
+%}
@@ -0,0 +1,119 @@
+// test that C node pools adopt nodes that survive pops in the new pool
+
+%option lang = "C"
+%option reentrant
+%option node_stats
+%option no_track_lines
+
+%decls %{
+#include <stddef.h>
+%}
+%{
+#include "runtime9.h"
+%}
+
+%node expression %abstract %typedef
+
+%node intnum expression =
+{
+	int value;
+}
+
+%end %{
+void yynodefailed(YYNODESTATE *state)
+{
+}
+
+int main(void)
+{
+	YYNODESTATE dst;
+	YYNODESTATE src;
+	YYNODESTATE third;
+	expression *keep;
+	expression *node;
+	expression *other;
+	expression *last;
+	int index;
+
+	yynodeinit(&dst);
+	yynodeinit(&src);
+	yynodeinit(&third);
+
+	/* Build nodes in the source, and adopt them into a destination
+	   that has open pushes */
+	keep = intnum_create(&dst, 1);
+	if(!yynodepush(&dst) || !intnum_create(&dst, 2) || !yynodepush(&dst))
+	{
+		return 1;
+	}
+	node = intnum_create(&src, 3);
+	if(!node || !yynodealloc(&src, 10000))
+	{
+		return 1;
+	}
+	yynodeadopt(&dst, &src);
+	if(yynodestats(&src)->reserved != 0 ||
+	   yynodestats(&dst)->reserved < 10000)
+	{
+		return 1;
+	}
+
+	/* New nodes in the destination must not overlap the adopted ones */
+	for(index = 0; index < 1000; ++index)
+	{
+		if(intnum_create(&dst, 4) == node)
+		{
+			return 1;
+		}
+	}
+
+	/* The adopted nodes survive popping the destination */
+	yynodepop(&dst);
+	yynodepop(&dst);
+	if(((intnum *)node)->value != 3 || ((intnum *)keep)->value != 1 ||
+	   yynodestats(&dst)->reserved < 10000)
+	{
+		return 1;
+	}
+
+	/* The emptied source can be used again, and adopted again
+	   by way of another pool that adopts it first */
+	other = intnum_create(&src, 5);
+	if(!other || ((intnum *)node)->value != 3)
+	{
+		return 1;
+	}
+	last = intnum_create(&third, 6);
+	yynodeadopt(&third, &src);
+	yynodeadopt(&dst, &third);
+	if(!yynodepush(&dst))
+	{
+		return 1;
+	}
+	yynodepop(&dst);
+	if(((intnum *)other)->value != 5 || ((intnum *)last)->value != 6 ||
+	   ((intnum *)node)->value != 3)
+	{
+		return 1;
+	}
+	yynodeclear(&src);
+	yynodeclear(&third);
+	if(((intnum *)other)->value != 5)
+	{
+		return 1;
+	}
+
+	/* Clearing the destination frees the adopted nodes */
+	yynodeclear(&dst);
+	if(yynodestats(&dst)->reserved != 0 || yynodestats(&dst)->blocks != 0)
+	{
+		return 1;
+	}
+	if(!intnum_create(&src, 7))
+	{
+		return 1;
+	}
+	yynodeclear(&src);
+	return 0;
+}
+%}
@@ -300,6 +300,18 @@ int main(int argc, char *argv[])
 				TreeCCDebug(input.linenum, "%%readonly");
 			}
 			break;
+
+			case TREECC_TOKEN_DISPATCH:
+			{
+				TreeCCDebug(input.linenum, "%%dispatch");
+			}
+			break;
+
+			case TREECC_TOKEN_MEMOIZE:
+			{
+				TreeCCDebug(input.linenum, "%%memoize");
+			}
+			break;
 		}
 	}
 
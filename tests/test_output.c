@@ -36,9 +36,9 @@ int main(int argc, char *argv[])
 	TreeCCStream *stream;
 
 	/* Validate the command-line arguments */
-	if(argc != 2)
+	if(argc != 2 && argc != 3)
 	{
-		fprintf(stderr, "Usage: %s filename\n", argv[0]);
+		fprintf(stderr, "Usage: %s filename [profile]\n", argv[0]);
 		return 1;
 	}
 
@@ -81,6 +81,12 @@ int main(int argc, char *argv[])
 	TreeCCNodeValidate(context);
 	TreeCCOperationValidate(context);
 
+	/* Load the dispatch profile if one was supplied */
+	if(argc == 3)
+	{
+		TreeCCOperationLoadProfile(context, argv[2]);
+	}
+
 	/* If there were errors, then bail out now */
 	if(input.errors)
 	{